@@ -224,29 +224,59 @@ class Chat {
         this.ws.onopen = (cxn)=>this.onWsOpen(cxn, username, password);
         this.ws.onclose = ()=>this.onWsClose(username, password);
         this.ws.onmessage = (msg)=>this.onMessage(msg);
+        this.deflate = false;
+        this.inbound = Promise.resolve();
     }
     onWsOpen(cxn, username, password) {
-        this.clear();
-        this.send("LOGIN "+username+" "+password+"\n");
+        // the state is kept if the server can replay the missed messages
+        if (this.epoch !== undefined) {
+            this.send("RESUME "+this.epoch+" "+this.seq+"\n");
+        } else {
+            this.clear();
+            this.send("RESUME\n");
+        }
+        // binary frames are compressed once the server accepted the offer
+        if (typeof DecompressionStream !== 'undefined')
+            this.send("EXTENSIONS permessage-deflate; server_no_context_takeover\n");
+        this.send("COALESCE 10\n");
+        // reconnects present the session token instead of the password
+        this.tokenUsed = this.sessionToken !== undefined;
+        this.connectionLoggedIn = false;
+        if (this.tokenUsed)
+            this.send("TOKEN "+this.sessionToken+"\n");
+        else
+            this.send("LOGIN "+username+" "+password+"\n");
     }
     onWsClose(username, password) {
         if (this.pingInterval !== null)
             clearInterval(this.pingInterval);
-        if (this.loginSuccess) {
+        if (this.tokenUsed && !this.connectionLoggedIn) {
+            // expired or revoked, log in with the password again
+            this.sessionToken = undefined;
+            setTimeout(()=>this.login(username, password), 1000);
+        } else if (this.loginSuccess) {
             setTimeout(()=>this.login(username, password), 1000);
         } else {
+            this.epoch = undefined;
             q('#login,#login-error').css({'display':'block'});
         }
     }
     onMessage(msg) {
-        if (msg.data instanceof Blob || msg.data instanceof ArrayBuffer) {
-            // unpack message
-            var reader = new FileReader();
-            reader.onload = (e)=>this.handleCommand(e.target.result);
-            reader.readAsText(msg.data);
-        } else {
-            handleCommand(msg.data);
-        }
+        // unpack messages in order, the extension reply decides about later frames
+        this.inbound = this.inbound
+            .then(()=>this.unpack(msg.data))
+            .then((text)=>this.handleCommand(text))
+            .catch((e)=>console.log("Failed to unpack message. Reason: "+e));
+    }
+    unpack(data) {
+        if (!(data instanceof Blob || data instanceof ArrayBuffer))
+            return data;
+        if (!this.deflate)
+            return new Response(data).text();
+        // restore the removed sync flush marker and terminate the raw deflate stream
+        var tail = new Uint8Array([0x00, 0x00, 0xff, 0xff, 0x03, 0x00]);
+        var stream = new Blob([data, tail]).stream().pipeThrough(new DecompressionStream('deflate-raw'));
+        return new Response(stream).text();
     }
     messageKey(event) {
         if (event.keyCode == 13 && !event.shiftKey) {
@@ -283,9 +313,31 @@ class Chat {
             return;
         }
 
+        // coalesced messages arrive as array
+        if (Array.isArray(json))
+            json.forEach((entry)=>this.handleJson(entry));
+        else
+            this.handleJson(json);
+    }
+    handleJson(json) {
+        if (json.seq)
+            this.seq = json.seq;
         if (!json.protocol) {
             if (json.cmd == "login" && json.success)
-                this.loginSuccess = true;
+                this.loginSuccess = this.connectionLoggedIn = true;
+            if (json.cmd == "session")
+                this.sessionToken = json.token;
+            if (json.cmd == "resync") // messages were dropped, a new chat list follows
+                this.clear();
+            if (json.cmd == "resume") {
+                this.epoch = json.epoch;
+                if (!json.success) { // a new chat list follows
+                    this.clear();
+                    this.seq = json.seq;
+                }
+            }
+            if (json.cmd == "extensions")
+                this.deflate = json.extensions.indexOf("permessage-deflate") === 0;
         } else {
             // service specific message
             var service = this.get(json.protocol);
@@ -272,8 +272,11 @@ class IrcService extends ServiceBase {
         if (IrcUtils.stripName(json.nick) === server.activeNick) {
             // TODO: handle quit
         } else {
-            for (var channelName in server.channels) {
-                var channel = server.get(channelName);
+            // the server lists the channels of the user, older servers don't
+            var channelNames = json.channels || Object.keys(server.channels);
+            for (var i = 0; i < channelNames.length; ++i) {
+                var channel = server.get(channelNames[i]);
+                if (!channel) continue;
                 var user = channel.get(json.nick);
                 if (!user) continue;
                 user.remove();
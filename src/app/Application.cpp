@@ -1,8 +1,11 @@
-#include <iostream>
+#include <algorithm>
 #include <csignal>
 #include <list>
+#include <sstream>
+#include <string>
 
 #include "Application.hpp"
+#include "EventTrace.hpp"
 #include "utils/Ini.hpp"
 #include "queue/EventQueue.hpp"
 #include "user/UserManager.hpp"
@@ -17,26 +20,107 @@
 #endif
 
 #include "event/EventQuit.hpp"
+#include "event/EventTimer.hpp"
+#include "utils/LatencyTracer.hpp"
+#include "utils/Logger.hpp"
 #include "utils/ModuleProvider.hpp"
 
 using namespace std;
 
 
-Application::Application()
+static LogModule& logModule = Logger::getInstance().getModule("application");
+
+static void loadLogLevels(Ini& coreIni) {
+    if (!coreIni.hasCategory("logging")) return;
+    auto& logger = Logger::getInstance();
+    // "level" is the default of all modules, other keys name a module
+    for (auto& entry : coreIni.expectCategory("logging")) {
+        LogLevel level;
+        if (!Logger::parseLevel(entry.second, level)) {
+            LOG_WARNING(logModule) << "unknown log level" << logField("key", entry.first) << logField("level", entry.second);
+            continue;
+        }
+        if (entry.first == "level")
+            logger.setDefaultLevel(level);
+        else
+            logger.setLevel(entry.first, level);
+    }
+}
+
+
+/// Reads the queue limits of a module from the category "queue_<module category>" of config/core.ini
+static void loadQueueLimits(Ini& coreIni, const string& moduleCategory, EventQueue* queue) {
+    string categoryName = "queue_" + moduleCategory;
+    if (!coreIni.hasCategory(categoryName)) return;
+    auto& category = coreIni.expectCategory(categoryName);
+
+    EventQueue::Limits limits;
+    string value;
+    if (coreIni.getEntry(category, "capacity", value))
+        istringstream(value) >> limits.capacity;
+    if (coreIni.getEntry(category, "policy", value) && !EventQueue::parseOverflowPolicy(value, limits.policy))
+        LOG_WARNING(logModule) << "unknown overflow policy" << logField("category", categoryName) << logField("policy", value);
+    // spilled events are read back in order, events without a complete codec wait in memory
+    limits.spillFile = categoryName + ".spill";
+    coreIni.getEntry(category, "spill_file", limits.spillFile);
+    limits.encode = &EventTrace::encodeComplete;
+    limits.decode = &EventTrace::decode;
+    if (coreIni.getEntry(category, "droppable", value)) {
+        // comma separated event uuids
+        istringstream droppable(value);
+        string uuid;
+        while (getline(droppable, uuid, ',')) {
+            UUID eventUuid;
+            if (istringstream(uuid) >> eventUuid)
+                limits.droppableEvents.insert(eventUuid);
+        }
+    }
+    queue->setLimits(limits);
+}
+
+
+Application::Settings::Settings()
+    : replayFast{false}
+{
+}
+
+Application::Application(const Settings& settings)
     : EventLoop({}, {}, false)
+    , settings(settings)
     , guard{this}
+    , dumpTimer{0}
+    , replaying{false}
 {
     Ini coreIni("config/core.ini");
     if (coreIni.isNew()) {
-        cerr << "No configuration exists. See --help for setup." << endl;
+        LOG_ERROR(logModule) << "no configuration exists, see --help for setup";
         stop();
         return;
     }
     auto& modules = coreIni.expectCategory("modules");
     auto& services = coreIni.expectCategory("services");
 
+    loadLogLevels(coreIni);
+
+    // latency tracing is optional, dumps are requested with SIGUSR1
+    auto& tracer = LatencyTracer::getInstance();
+    string tracingEnabled;
+    coreIni.getEntry("tracing", "enabled", tracingEnabled);
+    tracer.setEnabled(tracingEnabled == "y");
+    setName("application");
+
+    string recordingFile;
+    if (coreIni.getEntry("recording", "file", recordingFile) && !recordingFile.empty()) {
+        recorder.reset(new EventTraceWriter(recordingFile));
+        if (!recorder->isOpen()) {
+            LOG_ERROR(logModule) << "could not open the recording" << logField("file", recordingFile);
+            recorder.reset();
+        }
+    }
+
     EventQueue* queue = getEventQueue();
     userManager = make_shared<UserManager>(queue);
+    userManager->setName("user_manager");
     eventHandlers.push_back(userManager);
 
     string loginDatabaseType,
@@ -48,7 +132,15 @@ Application::Application()
     coreIni.getEntry(modules, "database", databaseType);
 
     auto& moduleProvider = ModuleProvider<EventLoop>::getInstance();
-    eventHandlers.push_back(moduleProvider.getInitializerFunction("login_database", loginDatabaseType)(queue));
+    auto loadModule = [&](const string& category, const string& name) {
+        // replays use stand-ins instead of irc networks and the configured database
+        bool standIn = !settings.replayFile.empty() && (category == "irc_database" || category == "database");
+        auto module = moduleProvider.getInitializerFunction(category, standIn ? "replay" : name)(queue);
+        loadQueueLimits(coreIni, category, module->getEventQueue());
+        module->setName(category);
+        eventHandlers.push_back(module);
+    };
+    loadModule("login_database", loginDatabaseType);
 
 #ifdef USE_IRC_PROTOCOL
     // load irc settings
@@ -63,20 +155,20 @@ Application::Application()
         ircIni.getEntry(modules, "settings_database", ircDatabaseType);
         ircIni.getEntry(modules, "backlog", backlogEnabled);
 
-        eventHandlers.push_back(moduleProvider.getInitializerFunction("irc_database", ircDatabaseType)(queue));
+        loadModule("irc_database", ircDatabaseType);
         if (backlogEnabled == "y")
-            eventHandlers.push_back(moduleProvider.getInitializerFunction("irc_backlog", "default")(queue));
+            loadModule("irc_backlog", "default");
         else
             queue->sendEvent(make_shared<EventIrcServiceInit>());
     }
 #endif
 
     if (databaseType != "" && databaseType != "none")
-        eventHandlers.push_back(moduleProvider.getInitializerFunction("database", databaseType)(queue));
+        loadModule("database", databaseType);
 
 #ifdef USE_WEBSOCKET_SERVER
     if (enableWebChat == "y") {
-        eventHandlers.push_back(moduleProvider.getInitializerFunction("server", "websocket")(queue));
+        loadModule("server", "websocket");
     }
 #endif
 
@@ -92,9 +184,9 @@ Application::Application()
         hackIni.getEntry(modules, "settings_database", hackDatabaseType);
         hackIni.getEntry(modules, "backlog", backlogEnabled);
 
-        eventHandlers.push_back(moduleProvider.getInitializerFunction("hack_database", hackDatabaseType)(queue));
+        loadModule("hack_database", hackDatabaseType);
         if (backlogEnabled == "y")
-            eventHandlers.push_back(moduleProvider.getInitializerFunction("hack_backlog", "default")(queue));
+            loadModule("hack_backlog", "default");
         else
             queue->sendEvent(make_shared<EventHackServiceInit>());
     }
@@ -104,31 +196,120 @@ Application::Application()
     for (auto& eventHandler : eventHandlers)
         eventHandler->getEventQueue()->sendEvent(make_shared<EventInit>());
 
+    dumpTimer = scheduleEvery(chrono::seconds(1));
+    if (!settings.replayFile.empty()) {
+        replaying = true;
+        replayThread = thread([this]{ replay(); });
+    }
     run();
 }
 
 Application::~Application() {
+    replaying = false;
+    if (replayThread.joinable())
+        replayThread.join();
+}
+
+void Application::replay() {
+    EventTraceReader reader(settings.replayFile);
+    if (!reader.isValid()) {
+        LOG_ERROR(logModule) << "could not read the trace" << logField("file", settings.replayFile);
+        stop();
+        return;
+    }
+
+    size_t replayed = 0,
+        skipped = 0;
+    auto start = chrono::steady_clock::now();
+    EventTraceRecord record;
+    while (replaying && reader.next(record)) {
+        // database events and client commands are caused by the replayed events again
+        auto event = EventTrace::decode(record);
+        if (!event) {
+            ++skipped;
+            continue;
+        }
+        if (!settings.replayFast) {
+            auto due = start + record.offset;
+            // sleeps in slices to notice a quit during long pauses of the trace
+            while (replaying && chrono::steady_clock::now() < due)
+                this_thread::sleep_until(min(due, chrono::steady_clock::now() + chrono::milliseconds(100)));
+        }
+        getEventQueue()->sendEvent(event);
+        ++replayed;
+    }
+
+    // a module may still handle an event while all queues are empty, idle has to be seen repeatedly
+    size_t idleChecks = 0;
+    while (replaying && idleChecks < 3) {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        idleChecks = isIdle() ? idleChecks + 1 : 0;
+    }
+    if (!replaying) return;
+
+    auto elapsed = chrono::duration_cast<chrono::duration<double>>(chrono::steady_clock::now() - start).count();
+    LOG_INFO(logModule) << "replay finished" << logField("events", replayed) << logField("skipped", skipped)
+                        << logField("seconds", elapsed) << logField("events_per_second", elapsed > 0 ? replayed / elapsed : 0);
+    stop();
+}
+
+bool Application::isIdle() {
+    auto isEmpty = [](EventQueue* queue) {
+        for (auto& lane : queue->getStatistics()) {
+            if (lane.depth > 0) return false;
+        }
+        return true;
+    };
+    lock_guard<mutex> lock(handlersMutex);
+    if (!isEmpty(getEventQueue())) return false;
+    for (auto& eventHandler : eventHandlers) {
+        if (!isEmpty(eventHandler->getEventQueue())) return false;
+    }
+    return true;
 }
 
 void Application::stop() {
     getEventQueue()->sendEvent(make_shared<EventQuit>());
 }
 
-bool Application::onEvent(std::shared_ptr<IEvent> event) {
-    // which event do we process?
-    UUID eventType = event->getEventUuid();
-
-    // dispatch events
+void Application::dispatch(const std::list<std::shared_ptr<EventLoop>>& eventHandlers, std::shared_ptr<IEvent> event) {
     for (auto& eventHandler : eventHandlers) {
         auto eventQueue = eventHandler->getEventQueue();
         if (eventQueue->canProcessEvent(event.get()))
             eventQueue->sendEvent(event);
     }
+}
+
+bool Application::onEvent(std::shared_ptr<IEvent> event) {
+    // which event do we process?
+    UUID eventType = event->getEventUuid();
+
+    // timers of the application are not dispatched
+    if (eventType == EventTimer::uuid) {
+        if (event->as<EventTimer>()->getTimerId() != dumpTimer) return true;
+        if (recorder)
+            recorder->flush();
+        if (LatencyTracer::getInstance().takeDumpRequest()) {
+            ostringstream report;
+            LatencyTracer::getInstance().dump(report);
+            LOG_INFO(logModule) << "latency report\n" << report.str();
+        }
+        return true;
+    }
+
+    if (recorder)
+        recorder->record(event);
+
+    dispatch(eventHandlers, event);
 
     if (eventType == EventQuit::uuid) {
-        cout << "Received Quit Event" << endl;
-        eventHandlers.clear(); // stop all event handlers. All received the quit event yet
-        cout << "Submodules were stopped" << endl;
+        LOG_INFO(logModule) << "received quit, stopping the modules";
+        replaying = false;
+        {
+            lock_guard<mutex> lock(handlersMutex);
+            eventHandlers.clear(); // stop all event handlers. All received the quit event yet
+        }
+        LOG_INFO(logModule) << "modules were stopped";
         return false; // stop execution
     }
     return true;
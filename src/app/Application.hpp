@@ -1,25 +1,56 @@
 #ifndef APPLICATION_H
 #define APPLICATION_H
 
+#include <atomic>
 #include <memory>
 #include <list>
+#include <mutex>
+#include <string>
+#include <thread>
 #include "ApplicationGuard.hpp"
 #include "queue/EventLoop.hpp"
 
 
 class UserManager;
 class IEvent;
+class EventTraceWriter;
 /// Application class which is the core of the entire service
 class Application : public EventLoop {
+public:
+    /// Options of tools running the application, harpoon itself uses the defaults
+    struct Settings {
+        Settings();
+        /// Trace fed into the application instead of irc connections, see EventTrace
+        std::string replayFile;
+        /// Replays as fast as possible instead of keeping the recorded timing
+        bool replayFast;
+    };
+private:
+    Settings settings;
     ApplicationGuard guard;
     /// Keeps track of all active services for each registered user
     std::shared_ptr<UserManager> userManager;
     /// All available event handlers
     std::list<std::shared_ptr<EventLoop>> eventHandlers;
+    /// Checks for requested latency dumps and flushes the recording
+    size_t dumpTimer;
+    /// Records the dispatched events if "file" is set in the category "recording" of config/core.ini
+    std::unique_ptr<EventTraceWriter> recorder;
+    /// Guards the event handlers while a replay waits for them to become idle
+    std::mutex handlersMutex;
+    std::atomic<bool> replaying;
+    std::thread replayThread;
+
+    /// Feeds the replayed events into the application queue, stops the application afterwards
+    void replay();
+    /// True if no module has pending events
+    bool isIdle();
 public:
-    Application();
+    explicit Application(const Settings& settings = Settings());
     virtual ~Application();
 
+    /// Sends the event to every handler accepting it
+    static void dispatch(const std::list<std::shared_ptr<EventLoop>>& eventHandlers, std::shared_ptr<IEvent> event);
     /// Sends EventQuit to all event handlers
     void stop();
     /// On received events
@@ -3,6 +3,7 @@
 #include <csignal>
 #include "Application.hpp"
 #include "event/EventQuit.hpp"
+#include "utils/LatencyTracer.hpp"
 
 using namespace std;
 
@@ -12,10 +13,17 @@ static void sigInt(int) {
         app->getEventQueue()->sendEvent(make_shared<EventQuit>());
 }
 
+static void sigUsr1(int) {
+    LatencyTracer::getInstance().requestDump();
+}
+
 std::list<Application*> ApplicationGuard::apps;
 ApplicationGuard::ApplicationGuard(Application* app) : app(app) {
     signal(SIGTERM, sigInt);
     signal(SIGINT, sigInt);
+    // created before the handler may use it
+    LatencyTracer::getInstance();
+    signal(SIGUSR1, sigUsr1);
     apps.push_back(app);
 }
 ApplicationGuard::~ApplicationGuard() {
@@ -0,0 +1,453 @@
+#include "EventTrace.hpp"
+#include "event/IEvent.hpp"
+#include "event/EventDatabaseQuery.hpp"
+#include "event/EventDatabaseResult.hpp"
+
+#ifdef USE_IRC_PROTOCOL
+#include "event/irc/EventIrcAction.hpp"
+#include "event/irc/EventIrcConnected.hpp"
+#include "event/irc/EventIrcInvited.hpp"
+#include "event/irc/EventIrcMessage.hpp"
+#include "event/irc/EventIrcModeChanged.hpp"
+#include "event/irc/EventIrcNickChanged.hpp"
+#include "event/irc/EventIrcNumeric.hpp"
+#include "event/irc/EventIrcSendAction.hpp"
+#include "event/irc/EventIrcSendMessage.hpp"
+#include "event/irc/EventIrcTopic.hpp"
+#include "event/irc/EventIrcUserlistReceived.hpp"
+#include "event/irc/EventIrcUserStatusChanged.hpp"
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+
+static const char traceMagic[] = "HRPNTRC1";
+static const size_t traceMagicSize = sizeof(traceMagic) - 1;
+/// Larger payloads are treated as corrupted traces
+static const uint64_t maxPayloadSize = 64 * 1024 * 1024;
+
+static void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static void putString(std::string& out, const std::string& value) {
+    putVarint(out, value.size());
+    out.append(value);
+}
+
+static void putStrings(std::string& out, const std::vector<std::string>& values) {
+    putVarint(out, values.size());
+    for (auto& value : values)
+        putString(out, value);
+}
+
+/// Reads the fields of a payload, ok turns false once the payload is exhausted
+struct PayloadReader {
+    const std::string& payload;
+    size_t position;
+    bool ok;
+
+    explicit PayloadReader(const std::string& payload)
+        : payload(payload)
+        , position{0}
+        , ok{true}
+    {
+    }
+
+    uint64_t getVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (position >= payload.size()) break;
+            uint8_t byte = static_cast<uint8_t>(payload[position++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        ok = false;
+        return 0;
+    }
+
+    std::string getString() {
+        uint64_t size = getVarint();
+        if (!ok || size > payload.size() - position) {
+            ok = false;
+            return "";
+        }
+        std::string value = payload.substr(position, size);
+        position += size;
+        return value;
+    }
+
+    std::vector<std::string> getStrings() {
+        uint64_t count = getVarint();
+        std::vector<std::string> values;
+        // every string needs at least one byte
+        if (count > payload.size() - position) {
+            ok = false;
+            return values;
+        }
+        for (uint64_t i = 0; i < count && ok; ++i)
+            values.push_back(getString());
+        return values;
+    }
+};
+
+
+bool EventTrace::encode(std::shared_ptr<IEvent> event, std::string& payload) {
+    payload.clear();
+    switch (event->getEventUuid()) {
+    case EventDatabaseQuery::uuid: {
+        // queries are templates without a common interface, only their amount is kept
+        auto query = event->as<EventDatabaseQuery>();
+        auto origin = query->getEventOrigin();
+        putVarint(payload, origin ? origin->getEventUuid() : 0);
+        putVarint(payload, query->getQueries().size());
+        return true;
+    }
+    case EventDatabaseResult::uuid: {
+        auto result = event->as<EventDatabaseResult>();
+        auto origin = result->getEventOrigin();
+        putVarint(payload, origin ? origin->getEventUuid() : 0);
+        putVarint(payload, result->getSuccess());
+        auto& results = result->getResults();
+        putStrings(payload, vector<string>(results.begin(), results.end()));
+        return true;
+    }
+#ifdef USE_IRC_PROTOCOL
+    case EventIrcMessage::uuid: {
+        auto message = event->as<EventIrcMessage>();
+        putVarint(payload, message->getUserId());
+        putVarint(payload, message->getServerId());
+        putString(payload, message->getFrom());
+        putString(payload, message->getChannel());
+        putString(payload, message->getMessage());
+        putVarint(payload, static_cast<uint64_t>(message->getType()));
+        return true;
+    }
+    case EventIrcAction::uuid: {
+        auto action = event->as<EventIrcAction>();
+        putVarint(payload, action->getUserId());
+        putVarint(payload, action->getServerId());
+        putString(payload, action->getUsername());
+        putString(payload, action->getChannel());
+        putString(payload, action->getMessage());
+        return true;
+    }
+    case EventIrcUserStatusChanged::uuid: {
+        auto status = event->as<EventIrcUserStatusChanged>();
+        putVarint(payload, status->getUserId());
+        putVarint(payload, status->getServerId());
+        putVarint(payload, static_cast<uint64_t>(status->getStatus()));
+        putString(payload, status->getUsername());
+        putString(payload, status->getChannel());
+        putString(payload, status->getTarget());
+        putString(payload, status->getReason());
+        putStrings(payload, status->getChannels());
+        return true;
+    }
+    case EventIrcNickChanged::uuid: {
+        auto nick = event->as<EventIrcNickChanged>();
+        putVarint(payload, nick->getUserId());
+        putVarint(payload, nick->getServerId());
+        putString(payload, nick->getUsername());
+        putString(payload, nick->getNewNick());
+        return true;
+    }
+    case EventIrcTopic::uuid: {
+        auto topic = event->as<EventIrcTopic>();
+        putVarint(payload, topic->getUserId());
+        putVarint(payload, topic->getServerId());
+        putString(payload, topic->getUsername());
+        putString(payload, topic->getChannel());
+        putString(payload, topic->getTopic());
+        return true;
+    }
+    case EventIrcModeChanged::uuid: {
+        auto mode = event->as<EventIrcModeChanged>();
+        putVarint(payload, mode->getUserId());
+        putVarint(payload, mode->getServerId());
+        putString(payload, mode->getUsername());
+        putString(payload, mode->getChannel());
+        putString(payload, mode->getMode());
+        putStrings(payload, mode->getArgs());
+        return true;
+    }
+    case EventIrcNumeric::uuid: {
+        auto numeric = event->as<EventIrcNumeric>();
+        putVarint(payload, numeric->getUserId());
+        putVarint(payload, numeric->getServerId());
+        putVarint(payload, numeric->getEventCode());
+        putString(payload, numeric->getFrom());
+        putStrings(payload, numeric->getParameters());
+        return true;
+    }
+    case EventIrcConnected::uuid: {
+        auto connected = event->as<EventIrcConnected>();
+        putVarint(payload, connected->getUserId());
+        putVarint(payload, connected->getServerId());
+        return true;
+    }
+    case EventIrcInvited::uuid: {
+        auto invited = event->as<EventIrcInvited>();
+        putVarint(payload, invited->getUserId());
+        putVarint(payload, invited->getServerId());
+        putString(payload, invited->getUsername());
+        putString(payload, invited->getTarget());
+        putString(payload, invited->getChannel());
+        return true;
+    }
+    case EventIrcUserlistReceived::uuid: {
+        auto userlist = event->as<EventIrcUserlistReceived>();
+        putVarint(payload, userlist->getUserId());
+        putVarint(payload, userlist->getServerId());
+        putString(payload, userlist->getChannel());
+        auto& users = userlist->getUsers();
+        putVarint(payload, users.size());
+        for (auto& user : users) {
+            putString(payload, user.nick);
+            putString(payload, user.mode);
+        }
+        return true;
+    }
+    case EventIrcSendMessage::uuid: {
+        auto message = event->as<EventIrcSendMessage>();
+        putVarint(payload, message->getUserId());
+        putVarint(payload, message->getServerId());
+        putString(payload, message->getChannel());
+        putString(payload, message->getMessage());
+        putVarint(payload, static_cast<uint64_t>(message->getType()));
+        return true;
+    }
+    case EventIrcSendAction::uuid: {
+        auto action = event->as<EventIrcSendAction>();
+        putVarint(payload, action->getUserId());
+        putVarint(payload, action->getServerId());
+        putString(payload, action->getChannel());
+        putString(payload, action->getMessage());
+        return true;
+    }
+#endif
+    }
+    return false;
+}
+
+bool EventTrace::encodeComplete(std::shared_ptr<IEvent> event, std::string& payload) {
+    UUID uuid = event->getEventUuid();
+    if (uuid == EventDatabaseQuery::uuid || uuid == EventDatabaseResult::uuid) return false;
+    return encode(event, payload);
+}
+
+std::shared_ptr<IEvent> EventTrace::decode(UUID uuid, const std::string& payload) {
+    return decode(EventTraceRecord{chrono::microseconds{0}, uuid, payload});
+}
+
+std::shared_ptr<IEvent> EventTrace::decode(const EventTraceRecord& record) {
+    PayloadReader in(record.payload);
+    shared_ptr<IEvent> event;
+    switch (record.uuid) {
+#ifdef USE_IRC_PROTOCOL
+    case EventIrcMessage::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        string from = in.getString();
+        string channel = in.getString();
+        string message = in.getString();
+        auto type = in.getVarint() == 0 ? IrcMessageType::Message : IrcMessageType::Notice;
+        event = make_shared<EventIrcMessage>(userId, serverId, from, channel, message, type);
+        break;
+    }
+    case EventIrcAction::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        string username = in.getString();
+        string channel = in.getString();
+        string message = in.getString();
+        event = make_shared<EventIrcAction>(userId, serverId, username, channel, message);
+        break;
+    }
+    case EventIrcUserStatusChanged::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        auto status = static_cast<EventIrcUserStatusChanged::Status>(in.getVarint());
+        string username = in.getString();
+        string channel = in.getString();
+        string targetOrMode = in.getString();
+        string reason = in.getString();
+        auto changed = make_shared<EventIrcUserStatusChanged>(userId, serverId, status, username, channel, targetOrMode, reason);
+        for (auto& quitChannel : in.getStrings())
+            changed->addChannel(quitChannel);
+        event = changed;
+        break;
+    }
+    case EventIrcNickChanged::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        string username = in.getString();
+        string newNick = in.getString();
+        event = make_shared<EventIrcNickChanged>(userId, serverId, username, newNick);
+        break;
+    }
+    case EventIrcTopic::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        string username = in.getString();
+        string channel = in.getString();
+        string topic = in.getString();
+        event = make_shared<EventIrcTopic>(userId, serverId, username, channel, topic);
+        break;
+    }
+    case EventIrcModeChanged::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        string username = in.getString();
+        string channel = in.getString();
+        string mode = in.getString();
+        auto args = in.getStrings();
+        event = make_shared<EventIrcModeChanged>(userId, serverId, username, channel, mode, args.cbegin(), args.cend());
+        break;
+    }
+    case EventIrcNumeric::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        unsigned int code = static_cast<unsigned int>(in.getVarint());
+        string from = in.getString();
+        auto parameters = in.getStrings();
+        event = make_shared<EventIrcNumeric>(userId, serverId, code, from, parameters);
+        break;
+    }
+    case EventIrcConnected::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        event = make_shared<EventIrcConnected>(userId, serverId);
+        break;
+    }
+    case EventIrcInvited::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        string username = in.getString();
+        string target = in.getString();
+        string channel = in.getString();
+        event = make_shared<EventIrcInvited>(userId, serverId, username, target, channel);
+        break;
+    }
+    case EventIrcUserlistReceived::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        string channel = in.getString();
+        auto userlist = make_shared<EventIrcUserlistReceived>(userId, serverId, channel);
+        uint64_t count = in.getVarint();
+        userlist->reserveUsers(min<uint64_t>(count, record.payload.size()));
+        for (uint64_t i = 0; i < count && in.ok; ++i) {
+            string nick = in.getString();
+            string mode = in.getString();
+            userlist->addUser(nick, mode);
+        }
+        event = userlist;
+        break;
+    }
+    case EventIrcSendMessage::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        string channel = in.getString();
+        string message = in.getString();
+        auto type = in.getVarint() == 0 ? IrcMessageType::Message : IrcMessageType::Notice;
+        event = make_shared<EventIrcSendMessage>(userId, serverId, channel, message, type);
+        break;
+    }
+    case EventIrcSendAction::uuid: {
+        size_t userId = in.getVarint();
+        size_t serverId = in.getVarint();
+        string channel = in.getString();
+        string message = in.getString();
+        event = make_shared<EventIrcSendAction>(userId, serverId, channel, message);
+        break;
+    }
+#endif
+    }
+    return in.ok ? event : nullptr;
+}
+
+
+EventTraceWriter::EventTraceWriter(const std::string& filename)
+    : file{filename, ios::binary | ios::trunc}
+    , start{chrono::steady_clock::now()}
+    , last{start}
+{
+    if (file)
+        file.write(traceMagic, traceMagicSize);
+}
+
+EventTraceWriter::~EventTraceWriter() {
+    flush();
+}
+
+bool EventTraceWriter::isOpen() const {
+    return static_cast<bool>(file);
+}
+
+void EventTraceWriter::record(std::shared_ptr<IEvent> event) {
+    auto now = max(chrono::steady_clock::now(), last);
+    string payload;
+    EventTrace::encode(event, payload);
+
+    putVarint(buffer, chrono::duration_cast<chrono::microseconds>(now - last).count());
+    putVarint(buffer, event->getEventUuid());
+    putString(buffer, payload);
+    last = now;
+    if (buffer.size() >= 64 * 1024)
+        flush();
+}
+
+void EventTraceWriter::flush() {
+    if (buffer.empty()) return;
+    file.write(buffer.data(), buffer.size());
+    file.flush();
+    buffer.clear();
+}
+
+
+EventTraceReader::EventTraceReader(const std::string& filename)
+    : file{filename, ios::binary}
+    , offset{0}
+    , valid{false}
+{
+    char magic[traceMagicSize];
+    if (file.read(magic, traceMagicSize))
+        valid = equal(magic, magic + traceMagicSize, traceMagic);
+}
+
+bool EventTraceReader::isValid() const {
+    return valid;
+}
+
+static bool readVarint(std::istream& in, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = in.get();
+        if (byte == char_traits<char>::eof()) return false;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool EventTraceReader::next(EventTraceRecord& record) {
+    if (!valid) return false;
+    uint64_t delta, uuid, size;
+    if (!readVarint(file, delta) || !readVarint(file, uuid) || !readVarint(file, size) || size > maxPayloadSize)
+        return false;
+    record.payload.resize(size);
+    if (size > 0 && !file.read(&record.payload[0], size))
+        return false;
+    offset += chrono::microseconds(delta);
+    record.offset = offset;
+    record.uuid = uuid;
+    return true;
+}
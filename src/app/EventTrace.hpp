@@ -0,0 +1,78 @@
+#ifndef EVENTTRACE_H
+#define EVENTTRACE_H
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include "utils/uuid.hpp"
+
+
+class IEvent;
+
+/// One event of a recorded trace
+struct EventTraceRecord {
+    /// Time since the recording started
+    std::chrono::microseconds offset;
+    UUID uuid;
+    /// Serialized event, empty for event types without codec
+    std::string payload;
+};
+
+/// Compact binary trace of the events crossing the application loop.
+/// The file starts with "HRPNTRC1", every record consists of the varint time since the previous record
+/// in microseconds, the varint event uuid, the varint payload size and the payload.
+/// Irc events and database queries and results have codecs, other events are stored without payload.
+class EventTrace {
+public:
+    /// Serializes an event
+    ///
+    /// \returns False if there is no codec for the event type
+    static bool encode(std::shared_ptr<IEvent> event, std::string& payload);
+    /// Recreates an event of a record
+    ///
+    /// \returns nullptr if the event type can't be replayed
+    static std::shared_ptr<IEvent> decode(const EventTraceRecord& record);
+    /// Serializes an event which decode recreates completely, used for spilling queues
+    ///
+    /// \returns False for events without codec and database events, which are stored without their queries
+    static bool encodeComplete(std::shared_ptr<IEvent> event, std::string& payload);
+    /// Recreates an event serialized by encodeComplete
+    static std::shared_ptr<IEvent> decode(UUID uuid, const std::string& payload);
+};
+
+/// Appends events to a trace file, used by the application loop only
+class EventTraceWriter {
+    std::ofstream file;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point last;
+    std::string buffer;
+public:
+    /// Truncates the file and writes the header
+    explicit EventTraceWriter(const std::string& filename);
+    ~EventTraceWriter();
+
+    bool isOpen() const;
+    void record(std::shared_ptr<IEvent> event);
+    /// Writes buffered records to the file
+    void flush();
+};
+
+/// Reads the records of a trace file in order
+class EventTraceReader {
+    std::ifstream file;
+    std::chrono::microseconds offset;
+    bool valid;
+public:
+    /// Opens the file and checks the header
+    explicit EventTraceReader(const std::string& filename);
+
+    /// Returns false if the file couldn't be opened or is no trace
+    bool isValid() const;
+    /// Reads the next record
+    ///
+    /// \returns False at the end of the trace or on truncated records
+    bool next(EventTraceRecord& record);
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "version.hpp"
+
+/// Runs the benchmarks, results are written to harpoon_bench.json unless --benchmark_out is passed
+int main(int argc, char **argv) {
+    std::vector<char*> args(argv, argv + argc);
+    bool hasOutput = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--benchmark_out=", 16) == 0)
+            hasOutput = true;
+    }
+    std::string output = "--benchmark_out=harpoon_bench.json";
+    std::string format = "--benchmark_out_format=json";
+    if (!hasOutput) {
+        args.push_back(&output[0]);
+        args.push_back(&format[0]);
+    }
+    args.push_back(nullptr);
+
+    int count = static_cast<int>(args.size()) - 1;
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+        return 1;
+
+    benchmark::AddCustomContext("harpoon_version",
+                                std::to_string(VERSION_MAJOR) + "." +
+                                std::to_string(VERSION_MINOR) + "." +
+                                std::to_string(VERSION_PATCH));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
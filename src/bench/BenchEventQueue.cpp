@@ -0,0 +1,94 @@
+#include <benchmark/benchmark.h>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#include "app/Application.hpp"
+#include "event/EventInit.hpp"
+#include "queue/EventLoop.hpp"
+#include "queue/EventQueue.hpp"
+
+
+/// Event type only known to the benchmarks
+class BenchEvent : public IEvent {
+public:
+    static constexpr UUID uuid = numeric_limits<UUID>::max();
+    virtual UUID getEventUuid() const override {
+        return uuid;
+    }
+};
+
+/// Unthreaded loop, its queue is drained by the benchmark
+class BenchSink : public EventLoop {
+public:
+    explicit BenchSink(const set<UUID>& events)
+        : EventLoop{events, {}, false}
+    { }
+    virtual bool onEvent(std::shared_ptr<IEvent> event) override {
+        return true;
+    }
+};
+
+
+/// Events per iteration, split between the producers
+static const size_t queueBatch = 4096;
+
+static void BM_EventQueueSendGet(benchmark::State& state) {
+    const size_t producers = state.range(0);
+    const size_t perProducer = queueBatch / producers;
+    EventQueue queue;
+    shared_ptr<IEvent> event = make_shared<BenchEvent>();
+
+    for (auto _ : state) {
+        vector<thread> threads;
+        for (size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue, &event, perProducer] {
+                for (size_t i = 0; i < perProducer; ++i)
+                    queue.sendEvent(event);
+            });
+        }
+        shared_ptr<IEvent> received;
+        for (size_t i = 0; i < perProducer * producers; ++i)
+            queue.getEvent(received);
+        for (auto& t : threads)
+            t.join();
+    }
+    state.SetItemsProcessed(state.iterations() * perProducer * producers);
+}
+BENCHMARK(BM_EventQueueSendGet)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+
+/// Dispatches events to a set of modules of which every second one accepts the event type
+static void BM_ApplicationDispatch(benchmark::State& state) {
+    const size_t handlerCount = state.range(0);
+    list<shared_ptr<EventLoop>> handlers;
+    for (size_t i = 0; i < handlerCount; ++i) {
+        if (i % 2 == 0)
+            handlers.push_back(make_shared<BenchSink>(set<UUID>{BenchEvent::uuid}));
+        else
+            handlers.push_back(make_shared<BenchSink>(set<UUID>{EventInit::uuid}));
+    }
+    shared_ptr<IEvent> event = make_shared<BenchEvent>();
+
+    size_t pending = 0;
+    for (auto _ : state) {
+        Application::dispatch(handlers, event);
+        if (++pending < 1024) continue;
+
+        // keep the queues small, draining isn't part of the measurement
+        state.PauseTiming();
+        shared_ptr<IEvent> received;
+        for (auto& handler : handlers) {
+            auto queue = handler->getEventQueue();
+            while (!queue->isEmpty())
+                queue->getEvent(received);
+        }
+        pending = 0;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ApplicationDispatch)->Arg(2)->Arg(8)->Arg(32);
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "service/irc/IrcChannelStore.hpp"
+#include "service/irc/IrcNickTable.hpp"
+
+
+/// Users of a large channel
+static const size_t channelUsers = 10000;
+
+static vector<string> makeNicks(const string& prefix) {
+    vector<string> nicks;
+    nicks.reserve(channelUsers);
+    for (size_t i = 0; i < channelUsers; ++i)
+        nicks.push_back(prefix + to_string(i));
+    return nicks;
+}
+
+static void BM_ChannelStoreAdd(benchmark::State& state) {
+    IrcNickTable nicks;
+    IrcChannelStore channel(&nicks, "", false);
+    auto names = makeNicks("User");
+    for (auto _ : state) {
+        for (size_t i = 0; i < channelUsers; ++i)
+            channel.addUser(names[i], i % 10 == 0 ? "o" : "");
+        state.PauseTiming();
+        channel.clear();
+        nicks.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * channelUsers);
+}
+BENCHMARK(BM_ChannelStoreAdd);
+
+static void BM_ChannelStoreRename(benchmark::State& state) {
+    IrcNickTable nicks;
+    IrcChannelStore channel(&nicks, "", false);
+    auto names = makeNicks("User");
+    auto renamed = makeNicks("Renamed");
+    for (auto& name : names)
+        channel.addUser(name, "");
+
+    bool forward = true;
+    vector<IrcNickTable::Merge> merges;
+    for (auto _ : state) {
+        auto& from = forward ? names : renamed;
+        auto& to = forward ? renamed : names;
+        for (size_t i = 0; i < channelUsers; ++i)
+            nicks.rename(from[i], to[i], merges);
+        forward = !forward;
+    }
+    state.SetItemsProcessed(state.iterations() * channelUsers);
+}
+BENCHMARK(BM_ChannelStoreRename);
+
+static void BM_ChannelStoreRemove(benchmark::State& state) {
+    IrcNickTable nicks;
+    IrcChannelStore channel(&nicks, "", false);
+    auto names = makeNicks("User");
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (auto& name : names)
+            channel.addUser(name, "");
+        state.ResumeTiming();
+        for (auto& name : names)
+            channel.removeUser(name);
+    }
+    state.SetItemsProcessed(state.iterations() * channelUsers);
+}
+BENCHMARK(BM_ChannelStoreRemove);
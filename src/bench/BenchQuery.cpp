@@ -0,0 +1,149 @@
+#include <benchmark/benchmark.h>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "db/handler/Memory.hpp"
+#include "db/query/Database_Query.hpp"
+#include "db/query/Database_QuerySelect_Store.hpp"
+#include "event/EventDatabaseQuery.hpp"
+#include "event/EventDatabaseResult.hpp"
+#include "event/EventInit.hpp"
+#include "queue/EventQueue.hpp"
+
+using namespace Query;
+
+
+/// Builds the backlog fetch of the irc backlog service
+static Select makeBacklogQuery() {
+    auto filter = make_var("channel_ref") == make_constant("42")
+        && make_var("user_id") == make_constant("7");
+    Select stmt = select("message_id", "time", "message", "type", "flags", "sender")
+        .from("harpoon_irc_backlog")
+        .join("harpoon_irc_sender", "sender")
+        .where(std::move(std::move(filter) && make_var("message_id") < make_constant("100000")))
+        .order_by("message_id", "DESC")
+        .limit(100);
+    return stmt;
+}
+
+/// Renders a select like the postgres module without binding the values
+static string renderSelect(QuerySelect_Store& store) {
+    stringstream ss;
+    ss << "SELECT ";
+    size_t whatIndex = 0;
+    for (auto& s : store.what) {
+        ss << s;
+        if (++whatIndex < store.what.size())
+            ss << ", ";
+    }
+    ss << " FROM " << store.from;
+    for (auto& join : store.on)
+        ss << " LEFT JOIN " << join.table << " ON " << join.field << "_id = " << join.field << "_ref";
+
+    if (store.filter) {
+        size_t filterDataIndex = 0;
+        ss << " WHERE ";
+        store.filter->traverse(TraverseCallbacks{
+                [&ss]{ ss << '('; },
+                [&ss]{ ss << ')'; },
+                [&ss](const std::string& name){ ss << name; },
+                [&ss, &filterDataIndex](const std::string& name){ ss << ":data" << filterDataIndex++; },
+                [&ss](Op op) {
+                    switch(op) {
+                    case Op::EQ: ss << " = "; break;
+                    case Op::NEQ: ss << " != "; break;
+                    case Op::GT: ss << " > "; break;
+                    case Op::LT: ss << " < "; break;
+                    case Op::AND: ss << " AND "; break;
+                    case Op::OR: ss << " OR "; break;
+                    }
+                }
+            });
+    }
+
+    if (store.order.size() > 0) {
+        ss << " ORDER BY";
+        for (auto& order : store.order)
+            ss << " " << order.first << " " << order.second;
+    }
+    if (store.limit != numeric_limits<size_t>::max())
+        ss << " LIMIT " << store.limit;
+    return ss.str();
+}
+
+static void BM_QueryBuild(benchmark::State& state) {
+    for (auto _ : state) {
+        Select stmt = makeBacklogQuery();
+        benchmark::DoNotOptimize(stmt.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueryBuild);
+
+static void BM_QueryRender(benchmark::State& state) {
+    Select stmt = makeBacklogQuery();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(renderSelect(*stmt));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueryRender);
+
+/// Sends the statements to the memory database and waits for the result
+template<class... T>
+static shared_ptr<IEvent> roundtrip(Database::Memory& database, EventQueue& results, T&&... stmts) {
+    database.getEventQueue()->sendEvent(make_shared<EventDatabaseQuery>(&results, make_shared<EventInit>(), std::forward<T>(stmts)...));
+    shared_ptr<IEvent> result;
+    results.getEvent(result);
+    return result;
+}
+
+/// Backlog fetch against the memory database holding range(0) messages of 10 channels,
+/// the handler cost without a database server
+static void BM_MemoryBacklogQuery(benchmark::State& state) {
+    EventQueue results;
+    Database::Memory database(&results);
+
+    Create stmtChannel = create("harpoon_irc_channel")
+        .field("channel_id", FieldType::Id)
+        .field("channel", FieldType::Text);
+    Create stmtSender = create("harpoon_irc_sender")
+        .field("sender_id", FieldType::Id)
+        .field("sender", FieldType::Text);
+    Create stmtBacklog = create("harpoon_irc_backlog")
+        .field("message_id", FieldType::Id)
+        .field("user_id", FieldType::Integer)
+        .field("time", FieldType::Time)
+        .field("message", FieldType::Text)
+        .field("type", FieldType::Integer)
+        .field("flags", FieldType::Integer)
+        .field("channel_ref", FieldType::Integer)
+        .field("sender_ref", FieldType::Integer);
+    roundtrip(database, results, std::move(stmtChannel), std::move(stmtSender), std::move(stmtBacklog));
+
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        Insert stmt = insert()
+            .into("harpoon_irc_backlog")
+            .format("message_id", "user_id", "time", "message", "type", "flags")
+            .join("harpoon_irc_channel", "channel", "#channel" + to_string(i % 10))
+            .join("harpoon_irc_sender", "sender", "sender" + to_string(i % 50))
+            .data(vector<string>{to_string(i + 1), "7", "Wed Jun 30 21:49:08 1993\n", "message " + to_string(i), "0", "0"});
+        roundtrip(database, results, std::move(stmt));
+    }
+
+    for (auto _ : state) {
+        Select stmt = select("message_id", "time", "message", "type", "flags", "sender")
+            .from("harpoon_irc_backlog")
+            .join("harpoon_irc_sender", "sender")
+            .where(make_var("channel_ref") == make_constant("1") && make_var("user_id") == make_constant("7"))
+            .order_by("message_id", "DESC")
+            .limit(100);
+        benchmark::DoNotOptimize(roundtrip(database, results, std::move(stmt)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MemoryBacklogQuery)->Arg(1000)->Arg(100000)->UseRealTime();
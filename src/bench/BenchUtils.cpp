@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+#include "utils/Base64.hpp"
+#include "utils/Ini.hpp"
+
+
+static string makeBinary(size_t length) {
+    string data(length, '\0');
+    for (size_t i = 0; i < length; ++i)
+        data[i] = static_cast<char>(i * 131 + 7);
+    return data;
+}
+
+static void BM_Base64Encode(benchmark::State& state) {
+    string data = makeBinary(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Base64::encode(data));
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Base64Encode)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+static void BM_Base64Decode(benchmark::State& state) {
+    string encoded = Base64::encode(makeBinary(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Base64::decode(encoded));
+    state.SetBytesProcessed(state.iterations() * encoded.size());
+}
+BENCHMARK(BM_Base64Decode)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+/// Compares the kernels, the first argument is the Base64::Kernel
+static void kernelArguments(benchmark::internal::Benchmark* bench) {
+    for (int kernel : {0, 1, 2})
+        for (int length : {16, 64, 1024, 1 << 20})
+            bench->Args({kernel, length});
+}
+
+static void BM_Base64EncodeKernel(benchmark::State& state) {
+    auto kernel = static_cast<Base64::Kernel>(state.range(0));
+    if (!Base64::isSupported(kernel)) {
+        state.SkipWithError("kernel not supported");
+        return;
+    }
+    string data = makeBinary(state.range(1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Base64::encode(data, kernel));
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Base64EncodeKernel)->Apply(kernelArguments);
+
+static void BM_Base64DecodeKernel(benchmark::State& state) {
+    auto kernel = static_cast<Base64::Kernel>(state.range(0));
+    if (!Base64::isSupported(kernel)) {
+        state.SkipWithError("kernel not supported");
+        return;
+    }
+    string encoded = Base64::encode(makeBinary(state.range(1)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Base64::decode(encoded, kernel));
+    state.SetBytesProcessed(state.iterations() * encoded.size());
+}
+BENCHMARK(BM_Base64DecodeKernel)->Apply(kernelArguments);
+
+
+static const char* iniFile = "harpoon_bench.ini";
+
+/// Fills an ini with categories of 10 entries each, like the server listings of irc.ini
+static void fillIni(Ini& ini, size_t categories) {
+    for (size_t c = 0; c < categories; ++c) {
+        auto& entries = ini.expectCategory("server" + to_string(c));
+        for (size_t e = 0; e < 10; ++e)
+            ini.setEntry(entries, "key" + to_string(e), "value of entry " + to_string(e));
+    }
+}
+
+static void BM_IniLoad(benchmark::State& state) {
+    {
+        Ini ini(iniFile);
+        fillIni(ini, state.range(0));
+        ini.write(true);
+    }
+    for (auto _ : state) {
+        Ini ini(iniFile);
+        benchmark::DoNotOptimize(ini.isNew());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 10);
+    remove(iniFile);
+}
+BENCHMARK(BM_IniLoad)->Arg(10)->Arg(1000);
+
+static void BM_IniWrite(benchmark::State& state) {
+    Ini ini(iniFile);
+    fillIni(ini, state.range(0));
+    for (auto _ : state)
+        ini.write(true);
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 10);
+    remove(iniFile);
+}
+BENCHMARK(BM_IniWrite)->Arg(10)->Arg(1000);
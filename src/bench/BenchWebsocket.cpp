@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "server/ws/WebsocketServer.hpp"
+#include "event/irc/EventIrcMessage.hpp"
+#include "event/irc/EventIrcAction.hpp"
+#include "event/irc/EventIrcTopic.hpp"
+#include "event/irc/EventIrcNickChanged.hpp"
+#include "event/irc/EventIrcModeChanged.hpp"
+#include "event/irc/EventIrcUserStatusChanged.hpp"
+#include "event/irc/EventIrcUserlistReceived.hpp"
+
+
+static void BM_EncodeEvent(benchmark::State& state, shared_ptr<IEvent> event, WebsocketEncoding encoding) {
+    size_t bytes = 0;
+    for (auto _ : state) {
+        string message = WebsocketServer::encodeEvent(event, encoding);
+        bytes += message.size();
+        benchmark::DoNotOptimize(message);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+}
+
+static shared_ptr<IEvent> makeUserlist(size_t users) {
+    auto event = make_shared<EventIrcUserlistReceived>(1, 1, "#harpoon");
+    event->reserveUsers(users);
+    for (size_t i = 0; i < users; ++i)
+        event->addUser("user" + to_string(i), i % 10 == 0 ? "o" : "");
+    return event;
+}
+
+static shared_ptr<IEvent> makeModeChange() {
+    vector<string> args{"alice", "bob"};
+    return make_shared<EventIrcModeChanged>(1, 1, "op", "#harpoon", "+ov", args.begin(), args.end());
+}
+
+static const string messageText = "the quick brown fox jumps over the lazy dog, \xc3\xa4\xc3\xb6\xc3\xbc";
+
+BENCHMARK_CAPTURE(BM_EncodeEvent, message,
+                  make_shared<EventIrcMessage>(1, 1, "alice", "#harpoon", messageText, IrcMessageType::Message),
+                  WebsocketEncoding::Json);
+BENCHMARK_CAPTURE(BM_EncodeEvent, message_msgpack,
+                  make_shared<EventIrcMessage>(1, 1, "alice", "#harpoon", messageText, IrcMessageType::Message),
+                  WebsocketEncoding::MessagePack);
+BENCHMARK_CAPTURE(BM_EncodeEvent, action,
+                  make_shared<EventIrcAction>(1, 1, "alice", "#harpoon", messageText),
+                  WebsocketEncoding::Json);
+BENCHMARK_CAPTURE(BM_EncodeEvent, joined,
+                  make_shared<EventIrcUserStatusChanged>(1, 1, EventIrcUserStatusChanged::Status::Joined, "alice", "#harpoon"),
+                  WebsocketEncoding::Json);
+BENCHMARK_CAPTURE(BM_EncodeEvent, topic,
+                  make_shared<EventIrcTopic>(1, 1, "alice", "#harpoon", messageText),
+                  WebsocketEncoding::Json);
+BENCHMARK_CAPTURE(BM_EncodeEvent, nick_changed,
+                  make_shared<EventIrcNickChanged>(1, 1, "alice", "alice_"),
+                  WebsocketEncoding::Json);
+BENCHMARK_CAPTURE(BM_EncodeEvent, mode_changed, makeModeChange(), WebsocketEncoding::Json);
+BENCHMARK_CAPTURE(BM_EncodeEvent, userlist_500, makeUserlist(500), WebsocketEncoding::Json);
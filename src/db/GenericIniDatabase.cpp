@@ -1,5 +1,4 @@
 #include "GenericIniDatabase.hpp"
-#include <iostream>
 #include <memory>
 #include <sstream>
 #include "queue/EventQueue.hpp"
@@ -7,9 +6,10 @@
 #include "utils/Ini.hpp"
 #include "utils/IdProvider.hpp"
 #include "utils/Filesystem.hpp"
+#include "utils/Logger.hpp"
 
-using std::cout;
-using std::endl;
+
+static LogModule& logModule = Logger::getInstance().getModule("database");
 
 
 GenericIniDatabase::GenericIniDatabase(const std::string& type)
@@ -36,7 +36,7 @@ bool GenericIniDatabase::addServer(size_t userId,
         serversConfig.setEntry(serverEntry, "id", serverIdStr);
         return true;
     }
-    cout << "IMPL ERROR: SERVER ALREADY EXISTS" << endl;
+    LOG_ERROR(logModule) << "server already exists" << logField("user", userId) << logField("name", serverName);
     return false;
 #pragma message "AddServer: handle server already exists case"
 }
@@ -143,7 +143,7 @@ bool GenericIniDatabase::addHost(size_t userId, size_t serverId,
         hostsConfig.setEntry(hostEntry, "ssl", ssl ? "y" : "n");
         return true;
     } else {
-        cout << "IMPL ERROR: HOST ALREADY EXISTS" << endl;
+        LOG_ERROR(logModule) << "host already exists" << logField("user", userId) << logField("host", hostKey.str());
     }
     return false;
 #pragma message "AddHost: handle host already exists case"
@@ -20,12 +20,15 @@
 #include "utils/Ini.hpp"
 #include "utils/IdProvider.hpp"
 #include "utils/ModuleProvider.hpp"
-#include <iostream>
+#include "utils/Logger.hpp"
 #include <sstream>
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("hack_database");
+
+
 PROVIDE_EVENTLOOP_MODULE("hack_database", "ini", HackDatabase_Ini)
 
 HackDatabase_Ini::HackDatabase_Ini(EventQueue* appQueue) :
@@ -45,7 +48,7 @@ bool HackDatabase_Ini::onEvent(std::shared_ptr<IEvent> event) {
     UUID eventType = event->getEventUuid();
     switch(eventType) {
     case EventQuit::uuid: {
-        std::cout << "HackDB received QUIT event" << std::endl;
+        LOG_DEBUG(logModule) << "received quit";
         return false;
     }
     case EventHackAddServer::uuid: {
@@ -66,7 +69,7 @@ bool HackDatabase_Ini::onEvent(std::shared_ptr<IEvent> event) {
 
             appQueue->sendEvent(make_shared<EventHackServerAdded>(add->getUserId(), serverId, add->getName()));
         } else {
-            cout << "IMPL ERROR: SERVER ALREADY EXISTS" << endl;
+            LOG_ERROR(logModule) << "server already exists" << logField("user", add->getUserId()) << logField("name", add->getName());
         }
         break;
     }
@@ -174,7 +177,7 @@ bool HackDatabase_Ini::onEvent(std::shared_ptr<IEvent> event) {
                                                                 add->getIpV6(),
                                                                 add->getSsl()));
         } else {
-            cout << "IMPL ERROR: HOST ALREADY EXISTS" << endl;
+            LOG_ERROR(logModule) << "host already exists" << logField("user", add->getUserId()) << logField("host", add->getHost());
         }
         break;
     }
@@ -255,7 +258,7 @@ bool HackDatabase_Ini::onEvent(std::shared_ptr<IEvent> event) {
         break;
     }
     case EventHackServiceInit::uuid: {
-        std::cout << "HackDB received INIT event" << std::endl;
+        LOG_DEBUG(logModule) << "received init";
 
         // activate service per user
         Ini usersConfig("config/users.ini");
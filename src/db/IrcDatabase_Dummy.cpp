@@ -1,4 +1,3 @@
-#include <iostream>
 #include "IrcDatabase_Dummy.hpp"
 #include "event/EventInit.hpp"
 #include "event/EventQuit.hpp"
@@ -8,10 +7,14 @@
 #include "service/irc/IrcServerConfiguration.hpp"
 #include "event/irc/EventIrcActivateService.hpp"
 #include "utils/ModuleProvider.hpp"
+#include "utils/Logger.hpp"
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("irc_database");
+
+
 PROVIDE_EVENTLOOP_MODULE("irc_database", "dummy", IrcDatabase_Dummy)
 
 IrcDatabase_Dummy::IrcDatabase_Dummy(EventQueue* appQueue)
@@ -30,10 +33,10 @@ IrcDatabase_Dummy::~IrcDatabase_Dummy() {
 bool IrcDatabase_Dummy::onEvent(std::shared_ptr<IEvent> event) {
     UUID eventType = event->getEventUuid();
     if (eventType == EventQuit::uuid) {
-        std::cout << "IrcDB received QUIT event" << std::endl;
+        LOG_DEBUG(logModule) << "received quit";
         return false;
     } else if (eventType == EventInit::uuid) {
-        std::cout << "IrcDB received INIT event" << std::endl;
+        LOG_DEBUG(logModule) << "received init";
 
         size_t userId = 1;
         auto login = make_shared<EventIrcActivateService>(userId);
@@ -21,12 +21,15 @@
 #include "utils/Ini.hpp"
 #include "utils/IdProvider.hpp"
 #include "utils/ModuleProvider.hpp"
-#include <iostream>
+#include "utils/Logger.hpp"
 #include <sstream>
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("irc_database");
+
+
 PROVIDE_EVENTLOOP_MODULE("irc_database", "ini", IrcDatabase_Ini)
 
 IrcDatabase_Ini::IrcDatabase_Ini(EventQueue* appQueue) :
@@ -54,7 +57,7 @@ bool IrcDatabase_Ini::onEvent(std::shared_ptr<IEvent> event) {
     UUID eventType = event->getEventUuid();
     switch(eventType) {
     case EventQuit::uuid: {
-        std::cout << "IrcDB received QUIT event" << std::endl;
+        LOG_DEBUG(logModule) << "received quit";
         return false;
     }
     case EventIrcAddServer::uuid: {
@@ -173,7 +176,7 @@ bool IrcDatabase_Ini::onEvent(std::shared_ptr<IEvent> event) {
         break;
     }
     case EventIrcServiceInit::uuid: {
-        std::cout << "IrcDB received INIT event" << std::endl;
+        LOG_DEBUG(logModule) << "received init";
 
         // activate service per user
         Ini usersConfig("config/users.ini");
@@ -0,0 +1,22 @@
+#include "IrcDatabase_Replay.hpp"
+#include "event/EventQuit.hpp"
+#include "utils/ModuleProvider.hpp"
+
+using namespace std;
+
+
+PROVIDE_EVENTLOOP_MODULE("irc_database", "replay", IrcDatabase_Replay)
+
+IrcDatabase_Replay::IrcDatabase_Replay(EventQueue* appQueue)
+    : EventLoop({
+          EventQuit::uuid
+      })
+{
+}
+
+IrcDatabase_Replay::~IrcDatabase_Replay() {
+}
+
+bool IrcDatabase_Replay::onEvent(std::shared_ptr<IEvent> event) {
+    return event->getEventUuid() != EventQuit::uuid;
+}
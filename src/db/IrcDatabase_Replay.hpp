@@ -0,0 +1,18 @@
+#ifndef IRCDATABASE_REPLAY_H
+#define IRCDATABASE_REPLAY_H
+
+#include "queue/EventQueue.hpp"
+#include "queue/EventLoop.hpp"
+
+
+/// Stand-in for replaying traces, no irc service is activated.
+/// The replayed irc events take the place of the connections.
+class IrcDatabase_Replay : public EventLoop {
+public:
+    explicit IrcDatabase_Replay(EventQueue* appQueue);
+    virtual ~IrcDatabase_Replay();
+
+    virtual bool onEvent(std::shared_ptr<IEvent> event) override;
+};
+
+#endif
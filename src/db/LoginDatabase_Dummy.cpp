@@ -1,21 +1,26 @@
-#include <iostream>
 #include "LoginDatabase_Dummy.hpp"
 #include "event/EventInit.hpp"
 #include "event/EventQuit.hpp"
 #include "event/EventLogin.hpp"
 #include "event/EventLoginResult.hpp"
+#include "event/EventLoginToken.hpp"
 #include "utils/ModuleProvider.hpp"
+#include "utils/Logger.hpp"
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("login_database");
+
+
 PROVIDE_EVENTLOOP_MODULE("login_database", "dummy", LoginDatabase_Dummy)
 
 LoginDatabase_Dummy::LoginDatabase_Dummy(EventQueue* appQueue)
     : EventLoop({
 		  EventInit::uuid,
           EventQuit::uuid,
-		  EventLogin::uuid
+		  EventLogin::uuid,
+		  EventLoginToken::uuid
 	  })
     , appQueue{appQueue}
 {
@@ -27,12 +32,15 @@ LoginDatabase_Dummy::~LoginDatabase_Dummy() {
 bool LoginDatabase_Dummy::onEvent(std::shared_ptr<IEvent> event) {
     UUID eventType = event->getEventUuid();
     if (eventType == EventQuit::uuid) {
-        std::cout << "DB received QUIT event" << std::endl;
+        LOG_DEBUG(logModule) << "received quit";
         return false;
     } else if (eventType == EventLogin::uuid) {
         auto login = event->as<EventLogin>();
         bool success = login->getUsername() == "user" && login->getPassword() == "password";
         appQueue->sendEvent(make_shared<EventLoginResult>(success, 1, login->getData()));
+    } else if (eventType == EventLoginToken::uuid) {
+        auto login = event->as<EventLoginToken>();
+        appQueue->sendEvent(make_shared<EventLoginResult>(login->getUserId() == 1, 1, login->getData()));
     }
     return true;
 }
@@ -1,53 +1,105 @@
-#include <iostream>
 #include "LoginDatabase_Ini.hpp"
 #include "event/EventInit.hpp"
 #include "event/EventQuit.hpp"
 #include "event/EventLogin.hpp"
 #include "event/EventLoginResult.hpp"
+#include "event/EventLoginToken.hpp"
 #include "utils/Password.hpp"
 #include "utils/ModuleProvider.hpp"
+#include "utils/Logger.hpp"
+#include "utils/Metrics.hpp"
+#include <sstream>
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("login_database");
+
+
 PROVIDE_EVENTLOOP_MODULE("login_database", "ini", LoginDatabase_Ini)
 
+static MetricsCounter& rejectedLogins = MetricsRegistry::getInstance().getCounter("harpoon_login_rejected_total",
+                                                                                   "Logins failed because the verification queue was full");
+
+/// Reads a number of the category "login" in config/core.ini
+static size_t readLoginSetting(Ini& coreIni, const std::string& name, size_t value) {
+    string data;
+    if (coreIni.getEntry("login", name, data))
+        istringstream(data) >> value;
+    return value;
+}
+
 LoginDatabase_Ini::LoginDatabase_Ini(EventQueue* appQueue)
     : EventLoop({
           EventInit::uuid,
           EventQuit::uuid,
-          EventLogin::uuid
+          EventLogin::uuid,
+          EventLoginToken::uuid
       })
     , appQueue{appQueue}
     , usersIni{"config/users.ini"}
 {
+    Ini coreIni("config/core.ini");
+    verifiers.reset(new WorkerPool(readLoginSetting(coreIni, "verify_threads", WorkerPool::defaultThreads()),
+                                   readLoginSetting(coreIni, "verify_queue", 1024)));
 }
 
 LoginDatabase_Ini::~LoginDatabase_Ini() {
+    verifiers->stop();
 }
 
 bool LoginDatabase_Ini::onEvent(std::shared_ptr<IEvent> event) {
     UUID eventType = event->getEventUuid();
     if (eventType == EventQuit::uuid) {
-        std::cout << "DB received QUIT event" << std::endl;
+        LOG_DEBUG(logModule) << "received quit";
+        verifiers->stop();
         return false;
     } else if (eventType == EventLogin::uuid) {
         auto login = event->as<EventLogin>();
 
-        bool success;
+        size_t userId = 1;
+        string salt, password, userIdStr;
         Ini::Entries* user = usersIni.getEntry(login->getUsername());
-        if (user) {
-            string salt, password;
-            success = (
-                       usersIni.getEntry(*user, "salt", salt)
-                       && usersIni.getEntry(*user, "password", password)
-                       && Password(salt, login->getPassword()).equals(password)
-                       );
-        } else {
-            success = false;
+        bool known = user
+            && usersIni.getEntry(*user, "salt", salt)
+            && usersIni.getEntry(*user, "password", password);
+        if (user && usersIni.getEntry(*user, "id", userIdStr))
+            istringstream(userIdStr) >> userId;
+        if (!known) {
+            appQueue->sendEvent(make_shared<EventLoginResult>(false, userId, login->getData()));
+            return true;
         }
 
-        appQueue->sendEvent(make_shared<EventLoginResult>(success, 1, login->getData()));
+        // hashing takes milliseconds, the entries are copied for the worker
+        EventQueue* queue = appQueue;
+        void* data = login->getData();
+        string attempt = login->getPassword();
+        bool posted = verifiers->post([queue, salt, password, attempt, userId, data] {
+            bool success = Password(salt, attempt).equals(password);
+            queue->sendEvent(make_shared<EventLoginResult>(success, userId, data));
+        });
+        if (!posted) {
+            rejectedLogins.increment();
+            LOG_WARNING(logModule) << "verification queue is full" << logField("user", login->getUsername());
+            appQueue->sendEvent(make_shared<EventLoginResult>(false, userId, login->getData()));
+        }
+    } else if (eventType == EventLoginToken::uuid) {
+        // tokens of deleted users are rejected, users without an id have the id 1
+        auto login = event->as<EventLoginToken>();
+        bool exists = false;
+        for (auto& user : usersIni) {
+            size_t userId = 1;
+            string data;
+            if (usersIni.getEntry(user.second, "id", data))
+                istringstream(data) >> userId;
+            if (userId == login->getUserId()
+                && usersIni.getEntry(user.second, "salt", data)
+                && usersIni.getEntry(user.second, "password", data)) {
+                exists = true;
+                break;
+            }
+        }
+        appQueue->sendEvent(make_shared<EventLoginResult>(exists, login->getUserId(), login->getData()));
     }
     return true;
 }
@@ -4,14 +4,19 @@
 #include "queue/EventQueue.hpp"
 #include "queue/EventLoop.hpp"
 #include "utils/Ini.hpp"
+#include "utils/WorkerPool.hpp"
 
 
 /// Used to validate users.
 /// Stores users as categories having salt and password.
 /// To add new users use the --genuser cmdline option together with --save.
+/// Passwords are hashed by a worker pool, configured with "verify_threads" and
+/// "verify_queue" in the category "login" of config/core.ini. Logins beyond the
+/// queue fail right away instead of delaying chat traffic.
 class LoginDatabase_Ini : public EventLoop {
     EventQueue* appQueue;
     Ini usersIni;
+    std::unique_ptr<WorkerPool> verifiers;
 public:
     explicit LoginDatabase_Ini(EventQueue* appQueue);
     virtual ~LoginDatabase_Ini();
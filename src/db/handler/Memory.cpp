@@ -0,0 +1,748 @@
+#include "Memory.hpp"
+#include "db/query/Database_Query.hpp"
+#include "utils/ModuleProvider.hpp"
+#include "event/EventQuit.hpp"
+#include "event/EventDatabaseQuery.hpp"
+#include "event/EventDatabaseResult.hpp"
+#include "queue/EventQueue.hpp"
+#include "utils/LatencyTracer.hpp"
+#include "utils/Metrics.hpp"
+#include "utils/Logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+
+static LogModule& logModule = Logger::getInstance().getModule("memory_database");
+
+
+namespace Database {
+
+    PROVIDE_EVENTLOOP_MODULE("database", "memory", Memory)
+
+
+    /// Sort key of an index entry, numbers for id and integer columns, text otherwise
+    struct MemoryKey {
+        long long number;
+        std::string text;
+
+        bool operator<(const MemoryKey& other) const {
+            return number < other.number || (number == other.number && text < other.text);
+        }
+    };
+
+    using MemoryRow = std::vector<std::string>;
+    using MemoryIndex = std::multimap<MemoryKey, size_t>;
+
+    struct MemoryColumn {
+        std::string name;
+        Query::FieldType type;
+    };
+
+    struct MemoryTable {
+        std::vector<MemoryColumn> columns;
+        std::unordered_map<std::string, size_t> columnPositions;
+        /// Rows by insertion number, iterating them gives the insertion order
+        std::map<size_t, MemoryRow> rows;
+        size_t nextRow;
+        /// Next value of the serial columns
+        long long nextSerial;
+        /// Ordered indexes by column position, created when a column is first looked up
+        std::map<size_t, MemoryIndex> indexes;
+
+        MemoryTable() : nextRow{0}, nextSerial{1} {}
+    };
+
+    /// Columns visible to a statement, the table itself followed by the joined tables
+    struct MemoryLayout {
+        std::vector<MemoryColumn> columns;
+        std::unordered_map<std::string, size_t> positions;
+
+        void add(const MemoryTable& table) {
+            for (auto& column : table.columns) {
+                positions.emplace(column.name, columns.size()); // first table wins on ambiguous names
+                columns.push_back(column);
+            }
+        }
+        bool find(const std::string& name, size_t& position) const {
+            auto it = positions.find(name);
+            if (it == positions.end()) return false;
+            position = it->second;
+            return true;
+        }
+    };
+
+    /// Filter with its columns resolved against a layout
+    struct MemoryCondition {
+        struct Operand {
+            bool isColumn;
+            size_t column;
+            std::string value;
+        };
+
+        Query::Op operation;
+        /// Operands of AND and OR
+        std::unique_ptr<MemoryCondition> left, right;
+        /// Operands of comparisons
+        Operand leftOperand, rightOperand;
+        /// Type the comparison is done in, taken from the compared column
+        Query::FieldType type;
+    };
+
+    /// Bounds of a column found in the conjunctions of a filter
+    struct MemoryRange {
+        bool hasLower, lowerInclusive;
+        bool hasUpper, upperInclusive;
+        MemoryKey lower, upper;
+
+        MemoryRange() : hasLower{false}, lowerInclusive{false}, hasUpper{false}, upperInclusive{false} {}
+        bool isEquality() const {
+            return hasLower && hasUpper && lowerInclusive && upperInclusive;
+        }
+    };
+
+    struct Memory_Impl {
+        EventQueue* appQueue;
+        std::map<std::string, MemoryTable> tables;
+        /// Query latencies by statement shape, e.g. "insert harpoon_irc_backlog"
+        std::map<std::string, MetricsHistogram*> queryHistograms;
+
+        explicit Memory_Impl(EventQueue* appQueue) : appQueue{appQueue} {};
+        bool onEvent(std::shared_ptr<IEvent> event);
+        /// Executes all queries of the event, stops at the first failing one
+        void handleQuery(std::shared_ptr<IEvent> event);
+        MetricsHistogram& getQueryHistogram(const std::string& shape);
+
+        bool query_createTable(Query::QueryCreate_Store* store, EventDatabaseResult* result);
+        bool query_insert(Query::QueryInsert_Store* store, EventDatabaseResult* result);
+        bool query_update(Query::QueryUpdate_Store* store, EventDatabaseResult* result);
+        bool query_select(Query::QuerySelect_Store* store, EventDatabaseResult* result);
+        bool query_delete(Query::QueryDelete_Store* store, EventDatabaseResult* result);
+
+        /// Identifiers are case insensitive like unquoted ones in sql
+        static std::string foldName(std::string name);
+        /// Converts ctime() output to the format timestamps are read back in
+        static std::string normalizeTime(const std::string& value);
+        static MemoryKey makeKey(Query::FieldType type, const std::string& value);
+        static int compareValues(Query::FieldType type, const std::string& left, const std::string& right);
+
+        MemoryTable* findTable(const std::string& name);
+        static MemoryIndex& getIndex(MemoryTable& table, size_t column);
+        /// Adds the row, assigning unset serial columns. Fails on duplicate ids
+        static bool insertRow(MemoryTable& table, MemoryRow&& row, size_t& rowId);
+        static void eraseIndexEntry(MemoryIndex& index, const MemoryKey& key, size_t rowId);
+
+        static std::unique_ptr<MemoryCondition> compileFilter(Query::Statement* statement, const MemoryLayout& layout);
+        static bool evaluate(const MemoryCondition& condition, const std::vector<const std::string*>& row);
+        /// Collects the bounds of the conjunctions comparing columns below columnCount with constants
+        static void collectRanges(const MemoryCondition* condition, size_t columnCount, std::map<size_t, MemoryRange>& ranges);
+        /// Visits the candidate rows in the index order of column or the insertion order if column is npos,
+        /// until visit returns false
+        template<class F>
+        static void scan(MemoryTable& table, size_t column, const MemoryRange& range, bool descending, F visit);
+        /// Picks the most selective column to scan for a filter
+        static size_t chooseIndex(const std::map<size_t, MemoryRange>& ranges);
+    };
+
+    Memory::Memory(EventQueue* appQueue)
+        : EventLoop{
+            {},
+            {
+                &EventGuard<IDatabaseEvent>
+            }
+        }
+        , impl{make_shared<Memory_Impl>(appQueue)}
+    {
+    }
+
+    Memory::~Memory() {
+    }
+
+    bool Memory::onEvent(std::shared_ptr<IEvent> event) {
+        return impl->onEvent(event);
+    }
+
+    std::string Memory_Impl::foldName(std::string name) {
+        transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return tolower(c); });
+        return name;
+    }
+
+    std::string Memory_Impl::normalizeTime(const std::string& value) {
+        std::tm t = {};
+        istringstream is(value);
+        is >> get_time(&t, "%a %b %d %H:%M:%S %Y");
+        if (is.fail())
+            return value;
+        ostringstream os;
+        os << put_time(&t, "%Y-%m-%d %H:%M:%S");
+        return os.str();
+    }
+
+    MemoryKey Memory_Impl::makeKey(Query::FieldType type, const std::string& value) {
+        if (type == Query::FieldType::Id || type == Query::FieldType::Integer)
+            return MemoryKey{strtoll(value.c_str(), nullptr, 10), {}};
+        return MemoryKey{0, value};
+    }
+
+    int Memory_Impl::compareValues(Query::FieldType type, const std::string& left, const std::string& right) {
+        if (type == Query::FieldType::Id || type == Query::FieldType::Integer) {
+            long long l = strtoll(left.c_str(), nullptr, 10);
+            long long r = strtoll(right.c_str(), nullptr, 10);
+            return l < r ? -1 : (r < l ? 1 : 0);
+        }
+        return left.compare(right);
+    }
+
+    MemoryTable* Memory_Impl::findTable(const std::string& name) {
+        auto it = tables.find(foldName(name));
+        if (it == tables.end()) {
+            LOG_WARNING(logModule) << "unknown table" << logField("table", name);
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    MemoryIndex& Memory_Impl::getIndex(MemoryTable& table, size_t column) {
+        auto it = table.indexes.find(column);
+        if (it != table.indexes.end())
+            return it->second;
+
+        auto& index = table.indexes[column];
+        auto type = table.columns[column].type;
+        for (auto& row : table.rows)
+            index.emplace_hint(index.end(), makeKey(type, row.second[column]), row.first);
+        return index;
+    }
+
+    bool Memory_Impl::insertRow(MemoryTable& table, MemoryRow&& row, size_t& rowId) {
+        for (size_t column = 0; column < table.columns.size(); ++column) {
+            if (table.columns[column].type != Query::FieldType::Id)
+                continue;
+            auto& value = row[column];
+            if (value.empty()) {
+                value = to_string(table.nextSerial++);
+            } else {
+                auto key = makeKey(Query::FieldType::Id, value);
+                if (getIndex(table, column).count(key) > 0) {
+                    LOG_WARNING(logModule) << "duplicate id" << logField("column", table.columns[column].name) << logField("id", value);
+                    return false;
+                }
+                table.nextSerial = max(table.nextSerial, key.number + 1);
+            }
+        }
+
+        rowId = table.nextRow++;
+        for (auto& index : table.indexes)
+            index.second.emplace(makeKey(table.columns[index.first].type, row[index.first]), rowId);
+        table.rows.emplace_hint(table.rows.end(), rowId, std::move(row));
+        return true;
+    }
+
+    void Memory_Impl::eraseIndexEntry(MemoryIndex& index, const MemoryKey& key, size_t rowId) {
+        auto range = index.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == rowId) {
+                index.erase(it);
+                return;
+            }
+        }
+    }
+
+    std::unique_ptr<MemoryCondition> Memory_Impl::compileFilter(Query::Statement* statement, const MemoryLayout& layout) {
+        using namespace Query;
+
+        auto expression = dynamic_cast<Expression*>(statement);
+        if (!expression || !expression->left || !expression->right) {
+            LOG_WARNING(logModule) << "filter is not an expression";
+            return nullptr;
+        }
+
+        auto condition = cpp11::make_unique<MemoryCondition>();
+        condition->operation = expression->operation;
+        if (expression->operation == Op::AND || expression->operation == Op::OR) {
+            condition->left = compileFilter(expression->left.get(), layout);
+            condition->right = compileFilter(expression->right.get(), layout);
+            if (!condition->left || !condition->right)
+                return nullptr;
+            return condition;
+        }
+
+        auto resolve = [&layout](Statement* side, MemoryCondition::Operand& operand) {
+            auto var = dynamic_cast<Var*>(side);
+            if (var) {
+                operand.isColumn = true;
+                if (!layout.find(foldName(var->name), operand.column)) {
+                    LOG_WARNING(logModule) << "unknown column" << logField("column", var->name);
+                    return false;
+                }
+                return true;
+            }
+            auto constant = dynamic_cast<Constant*>(side);
+            if (constant) {
+                operand.isColumn = false;
+                operand.value = constant->name;
+                return true;
+            }
+            return false;
+        };
+        if (!resolve(expression->left.get(), condition->leftOperand)
+            || !resolve(expression->right.get(), condition->rightOperand))
+            return nullptr;
+
+        condition->type = FieldType::Text;
+        if (condition->leftOperand.isColumn)
+            condition->type = layout.columns[condition->leftOperand.column].type;
+        else if (condition->rightOperand.isColumn)
+            condition->type = layout.columns[condition->rightOperand.column].type;
+        if (condition->type == FieldType::Time) {
+            for (auto operand : {&condition->leftOperand, &condition->rightOperand}) {
+                if (!operand->isColumn)
+                    operand->value = normalizeTime(operand->value);
+            }
+        }
+        return condition;
+    }
+
+    bool Memory_Impl::evaluate(const MemoryCondition& condition, const std::vector<const std::string*>& row) {
+        using namespace Query;
+
+        switch (condition.operation) {
+        case Op::AND:
+            return evaluate(*condition.left, row) && evaluate(*condition.right, row);
+        case Op::OR:
+            return evaluate(*condition.left, row) || evaluate(*condition.right, row);
+        default:
+            break;
+        }
+
+        auto& left = condition.leftOperand.isColumn ? *row[condition.leftOperand.column] : condition.leftOperand.value;
+        auto& right = condition.rightOperand.isColumn ? *row[condition.rightOperand.column] : condition.rightOperand.value;
+        int order = compareValues(condition.type, left, right);
+        switch (condition.operation) {
+        case Op::EQ: return order == 0;
+        case Op::NEQ: return order != 0;
+        case Op::LT: return order < 0;
+        case Op::GT: return order > 0;
+        default: return false;
+        }
+    }
+
+    void Memory_Impl::collectRanges(const MemoryCondition* condition, size_t columnCount, std::map<size_t, MemoryRange>& ranges) {
+        using namespace Query;
+
+        if (!condition || condition->operation == Op::OR || condition->operation == Op::NEQ)
+            return;
+        if (condition->operation == Op::AND) {
+            collectRanges(condition->left.get(), columnCount, ranges);
+            collectRanges(condition->right.get(), columnCount, ranges);
+            return;
+        }
+
+        auto& left = condition->leftOperand;
+        auto& right = condition->rightOperand;
+        if (left.isColumn == right.isColumn)
+            return;
+        auto& column = left.isColumn ? left : right;
+        auto& constant = left.isColumn ? right : left;
+        if (column.column >= columnCount)
+            return;
+
+        // "constant < column" bounds the column from below
+        Op operation = condition->operation;
+        if (!left.isColumn && operation != Op::EQ)
+            operation = operation == Op::LT ? Op::GT : Op::LT;
+
+        auto key = makeKey(condition->type, constant.value);
+        auto& range = ranges[column.column];
+        if (operation != Op::LT && (!range.hasLower || range.lower < key || (!(key < range.lower) && operation == Op::GT))) {
+            range.hasLower = true;
+            range.lower = key;
+            range.lowerInclusive = operation == Op::EQ;
+        }
+        if (operation != Op::GT && (!range.hasUpper || key < range.upper || (!(range.upper < key) && operation == Op::LT))) {
+            range.hasUpper = true;
+            range.upper = key;
+            range.upperInclusive = operation == Op::EQ;
+        }
+    }
+
+    size_t Memory_Impl::chooseIndex(const std::map<size_t, MemoryRange>& ranges) {
+        size_t column = std::numeric_limits<size_t>::max();
+        for (auto& range : ranges) {
+            if (range.second.isEquality())
+                return range.first;
+            if (column == std::numeric_limits<size_t>::max())
+                column = range.first;
+        }
+        return column;
+    }
+
+    template<class F>
+    void Memory_Impl::scan(MemoryTable& table, size_t column, const MemoryRange& range, bool descending, F visit) {
+        if (column == std::numeric_limits<size_t>::max()) {
+            if (descending) {
+                for (auto it = table.rows.rbegin(); it != table.rows.rend(); ++it)
+                    if (!visit(it->first, it->second)) return;
+            } else {
+                for (auto& row : table.rows)
+                    if (!visit(row.first, row.second)) return;
+            }
+            return;
+        }
+
+        auto& index = getIndex(table, column);
+        auto begin = index.begin(), end = index.end();
+        if (range.hasLower)
+            begin = range.lowerInclusive ? index.lower_bound(range.lower) : index.upper_bound(range.lower);
+        if (range.hasUpper)
+            end = range.upperInclusive ? index.upper_bound(range.upper) : index.lower_bound(range.upper);
+        if (range.hasLower && range.hasUpper && range.upper < range.lower)
+            return;
+
+        if (descending) {
+            for (auto it = end; it != begin;) {
+                --it;
+                if (!visit(it->second, table.rows[it->second])) return;
+            }
+        } else {
+            for (auto it = begin; it != end; ++it)
+                if (!visit(it->second, table.rows[it->second])) return;
+        }
+    }
+
+    bool Memory_Impl::query_createTable(Query::QueryCreate_Store* store, EventDatabaseResult* result) {
+        auto name = foldName(store->name);
+        if (tables.count(name) > 0)
+            return true; // like CREATE TABLE IF NOT EXISTS
+
+        MemoryTable table;
+        for (auto& field : store->fields) {
+            auto column = foldName(field.name);
+            if (!table.columnPositions.emplace(column, table.columns.size()).second) {
+                LOG_WARNING(logModule) << "duplicate column" << logField("table", name) << logField("column", column);
+                return false;
+            }
+            table.columns.push_back(MemoryColumn{column, field.type});
+        }
+        tables.emplace(name, std::move(table));
+        return true;
+    }
+
+    bool Memory_Impl::query_insert(Query::QueryInsert_Store* store, EventDatabaseResult* result) {
+        auto table = findTable(store->into);
+        if (!table) return false;
+
+        std::vector<size_t> format;
+        MemoryLayout layout;
+        layout.add(*table);
+        for (auto& name : store->format) {
+            size_t position;
+            if (!layout.find(foldName(name), position)) {
+                LOG_WARNING(logModule) << "unknown column" << logField("column", name);
+                return false;
+            }
+            format.push_back(position);
+        }
+        if (format.empty() || store->data.size() % format.size() != 0)
+            return false;
+
+        // looks up the referenced rows, adds the missing ones
+        std::vector<std::pair<size_t, std::string>> references;
+        for (auto& join : store->on) {
+            auto joinTable = findTable(join.table);
+            if (!joinTable) return false;
+            auto field = foldName(join.field);
+            size_t refColumn, valueColumn, idColumn;
+            if (!layout.find(field + "_ref", refColumn)) return false;
+            auto valueIt = joinTable->columnPositions.find(field);
+            auto idIt = joinTable->columnPositions.find(field + "_id");
+            if (valueIt == joinTable->columnPositions.end() || idIt == joinTable->columnPositions.end())
+                return false;
+            valueColumn = valueIt->second;
+            idColumn = idIt->second;
+
+            auto& index = getIndex(*joinTable, valueColumn);
+            auto found = index.find(makeKey(joinTable->columns[valueColumn].type, join.on));
+            size_t joinRow;
+            if (found != index.end()) {
+                joinRow = found->second;
+            } else {
+                MemoryRow row(joinTable->columns.size());
+                row[valueColumn] = join.on;
+                if (!insertRow(*joinTable, std::move(row), joinRow))
+                    return false;
+            }
+            references.emplace_back(refColumn, joinTable->rows[joinRow][idColumn]);
+        }
+
+        for (auto it = store->data.begin(); it != store->data.end();) {
+            MemoryRow row(table->columns.size());
+            for (size_t position : format) {
+                auto& value = *it++;
+                row[position] = table->columns[position].type == Query::FieldType::Time ? normalizeTime(value) : value;
+            }
+            for (auto& reference : references)
+                row[reference.first] = reference.second;
+            size_t rowId;
+            if (!insertRow(*table, std::move(row), rowId))
+                return false;
+        }
+        return true;
+    }
+
+    bool Memory_Impl::query_update(Query::QueryUpdate_Store* store, EventDatabaseResult* result) {
+        auto table = findTable(store->table);
+        if (!table) return false;
+
+        MemoryLayout layout;
+        layout.add(*table);
+        std::vector<size_t> format;
+        for (auto& name : store->format) {
+            size_t position;
+            if (!layout.find(foldName(name), position)) {
+                LOG_WARNING(logModule) << "unknown column" << logField("column", name);
+                return false;
+            }
+            format.push_back(position);
+        }
+        if (format.size() != store->data.size())
+            return false;
+
+        std::unique_ptr<MemoryCondition> condition;
+        if (store->filter && !(condition = compileFilter(store->filter.get(), layout)))
+            return false;
+        std::map<size_t, MemoryRange> ranges;
+        collectRanges(condition.get(), layout.columns.size(), ranges);
+        size_t column = chooseIndex(ranges);
+
+        // collect first, changing rows would move them inside the scanned index
+        std::vector<size_t> matches;
+        std::vector<const std::string*> view(layout.columns.size());
+        scan(*table, column, ranges[column], false, [&](size_t rowId, MemoryRow& row) {
+            for (size_t i = 0; i < row.size(); ++i)
+                view[i] = &row[i];
+            if (!condition || evaluate(*condition, view))
+                matches.push_back(rowId);
+            return true;
+        });
+
+        for (size_t rowId : matches) {
+            auto& row = table->rows[rowId];
+            for (size_t i = 0; i < format.size(); ++i) {
+                size_t position = format[i];
+                auto type = table->columns[position].type;
+                auto value = type == Query::FieldType::Time ? normalizeTime(store->data[i]) : store->data[i];
+                auto index = table->indexes.find(position);
+                if (index != table->indexes.end()) {
+                    eraseIndexEntry(index->second, makeKey(type, row[position]), rowId);
+                    index->second.emplace(makeKey(type, value), rowId);
+                }
+                row[position] = std::move(value);
+            }
+        }
+        return true;
+    }
+
+    bool Memory_Impl::query_select(Query::QuerySelect_Store* store, EventDatabaseResult* result) {
+        auto table = findTable(store->from);
+        if (!table) return false;
+
+        MemoryLayout layout;
+        layout.add(*table);
+        size_t tableColumns = layout.columns.size();
+
+        // LEFT JOIN table ON field_id = field_ref
+        struct JoinStep {
+            MemoryTable* table;
+            size_t refColumn, idColumn;
+        };
+        std::vector<JoinStep> joins;
+        for (auto& join : store->on) {
+            auto joinTable = findTable(join.table);
+            if (!joinTable) return false;
+            auto field = foldName(join.field);
+            size_t refColumn;
+            auto idIt = joinTable->columnPositions.find(field + "_id");
+            if (!layout.find(field + "_ref", refColumn) || idIt == joinTable->columnPositions.end())
+                return false;
+            joins.push_back(JoinStep{joinTable, refColumn, idIt->second});
+            layout.add(*joinTable);
+        }
+
+        std::vector<size_t> what;
+        for (auto& name : store->what) {
+            size_t position;
+            if (!layout.find(foldName(name), position)) {
+                LOG_WARNING(logModule) << "unknown column" << logField("column", name);
+                return false;
+            }
+            what.push_back(position);
+        }
+        std::vector<std::pair<size_t, bool>> order; // column, descending
+        for (auto& entry : store->order) {
+            size_t position;
+            if (!layout.find(foldName(entry.first), position)) {
+                LOG_WARNING(logModule) << "unknown column" << logField("column", entry.first);
+                return false;
+            }
+            order.emplace_back(position, foldName(entry.second) == "desc");
+        }
+
+        std::unique_ptr<MemoryCondition> condition;
+        if (store->filter && !(condition = compileFilter(store->filter.get(), layout)))
+            return false;
+
+        // ordering by a single column of the table walks its index, stopping at the limit
+        std::map<size_t, MemoryRange> ranges;
+        collectRanges(condition.get(), tableColumns, ranges);
+        bool indexOrder = order.size() == 1 && order.front().first < tableColumns;
+        size_t column = indexOrder ? order.front().first : chooseIndex(ranges);
+        bool descending = indexOrder && order.front().second;
+
+        static const std::string null;
+        std::vector<std::vector<const std::string*>> matches;
+        std::vector<const std::string*> view(layout.columns.size());
+        scan(*table, column, ranges[column], descending, [&](size_t rowId, MemoryRow& row) {
+            size_t position = 0;
+            for (auto& value : row)
+                view[position++] = &value;
+            for (auto& join : joins) {
+                auto& index = getIndex(*join.table, join.idColumn);
+                auto found = index.find(makeKey(Query::FieldType::Id, row[join.refColumn]));
+                auto joinRow = found != index.end() ? &join.table->rows[found->second] : nullptr;
+                for (size_t i = 0; i < join.table->columns.size(); ++i)
+                    view[position++] = joinRow ? &(*joinRow)[i] : &null;
+            }
+            if (condition && !evaluate(*condition, view))
+                return true;
+            matches.push_back(view);
+            return !indexOrder || matches.size() < store->limit;
+        });
+
+        if (!order.empty() && !indexOrder) {
+            stable_sort(matches.begin(), matches.end(), [&](const std::vector<const std::string*>& left,
+                                                           const std::vector<const std::string*>& right) {
+                for (auto& entry : order) {
+                    int comparison = compareValues(layout.columns[entry.first].type, *left[entry.first], *right[entry.first]);
+                    if (comparison != 0)
+                        return entry.second ? comparison > 0 : comparison < 0;
+                }
+                return false;
+            });
+        }
+        if (matches.size() > store->limit)
+            matches.resize(store->limit);
+
+        for (auto& match : matches) {
+            for (size_t position : what)
+                result->addResult(*match[position]);
+        }
+        return true;
+    }
+
+    bool Memory_Impl::query_delete(Query::QueryDelete_Store* store, EventDatabaseResult* result) {
+        auto table = findTable(store->from);
+        if (!table) return false;
+
+        MemoryLayout layout;
+        layout.add(*table);
+        std::unique_ptr<MemoryCondition> condition;
+        if (store->filter && !(condition = compileFilter(store->filter.get(), layout)))
+            return false;
+        std::map<size_t, MemoryRange> ranges;
+        collectRanges(condition.get(), layout.columns.size(), ranges);
+        size_t column = chooseIndex(ranges);
+
+        std::vector<size_t> matches;
+        std::vector<const std::string*> view(layout.columns.size());
+        scan(*table, column, ranges[column], false, [&](size_t rowId, MemoryRow& row) {
+            for (size_t i = 0; i < row.size(); ++i)
+                view[i] = &row[i];
+            if (!condition || evaluate(*condition, view))
+                matches.push_back(rowId);
+            return matches.size() < store->limit;
+        });
+
+        for (size_t rowId : matches) {
+            auto row = table->rows.find(rowId);
+            for (auto& index : table->indexes)
+                eraseIndexEntry(index.second, makeKey(table->columns[index.first].type, row->second[index.first]), rowId);
+            table->rows.erase(row);
+        }
+        return true;
+    }
+
+    void Memory_Impl::handleQuery(std::shared_ptr<IEvent> event) {
+        EventDatabaseQuery* query = event->as<EventDatabaseQuery>();
+        auto result = make_shared<EventDatabaseResult>(query->getEventOrigin());
+
+        bool success = true;
+        for (const auto& subQuery : query->getQueries()) {
+            auto ptr = subQuery.get();
+            auto started = chrono::steady_clock::now();
+            string shape; // statement type and table for the metrics
+            if (auto insert = dynamic_cast<Query::QueryInsert_Store*>(ptr)) {
+                success = query_insert(insert, result.get());
+                shape = "insert " + insert->into;
+            } else if (auto select = dynamic_cast<Query::QuerySelect_Store*>(ptr)) {
+                success = query_select(select, result.get());
+                shape = "select " + select->from;
+            } else if (auto update = dynamic_cast<Query::QueryUpdate_Store*>(ptr)) {
+                success = query_update(update, result.get());
+                shape = "update " + update->table;
+            } else if (auto erase = dynamic_cast<Query::QueryDelete_Store*>(ptr)) {
+                success = query_delete(erase, result.get());
+                shape = "delete " + erase->from;
+            } else if (auto create = dynamic_cast<Query::QueryCreate_Store*>(ptr)) {
+                success = query_createTable(create, result.get());
+                shape = "create " + create->name;
+            } else {
+                success = false;
+            }
+            if (!shape.empty())
+                getQueryHistogram(shape).observe(chrono::steady_clock::now() - started);
+            if (!success) {
+                LOG_WARNING(logModule) << "query failed" << logField("statement", shape);
+                break;
+            }
+        }
+        result->setSuccess(success);
+
+        auto origin = query->getEventOrigin();
+        if (origin && LatencyTracer::getInstance().isEnabled())
+            LatencyTracer::getInstance().record("memory/" + to_string(origin->getEventUuid()) + "/commit",
+                                                chrono::steady_clock::now() - origin->getCreated());
+
+        query->getTarget()->sendEvent(result);
+    }
+
+    MetricsHistogram& Memory_Impl::getQueryHistogram(const std::string& shape) {
+        auto& histogram = queryHistograms[shape];
+        if (!histogram)
+            histogram = &MetricsRegistry::getInstance().getHistogram("harpoon_db_query_duration_seconds",
+                                                                     "Duration of database statements",
+                                                                     {{"statement", shape}});
+        return *histogram;
+    }
+
+    bool Memory_Impl::onEvent(std::shared_ptr<IEvent> event) {
+        UUID eventType = event->getEventUuid();
+        if (eventType == EventQuit::uuid) {
+            return false;
+        } else if (eventType == EventDatabaseQuery::uuid) {
+            handleQuery(event);
+        }
+        return true;
+    }
+
+}
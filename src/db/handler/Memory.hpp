@@ -0,0 +1,27 @@
+#ifndef DATABASEMEMORY_H
+#define DATABASEMEMORY_H
+
+#include <memory>
+#include "queue/EventLoop.hpp"
+
+
+class EventQueue;
+namespace Database {
+
+    /// Database keeping all tables in memory, nothing survives a restart.
+    /// Implements the whole query DSL, used as test double and to measure
+    /// the backlog services without the cost of a database server.
+    struct Memory_Impl;
+    class Memory : public EventLoop {
+        std::shared_ptr<Memory_Impl> impl;
+    public:
+        explicit Memory(EventQueue* appQueue);
+        virtual ~Memory();
+
+        virtual bool onEvent(std::shared_ptr<IEvent> event) override;
+    };
+
+}
+
+
+#endif
@@ -6,15 +6,21 @@
 #include "event/EventDatabaseQuery.hpp"
 #include "event/EventDatabaseResult.hpp"
 #include "utils/Ini.hpp"
+#include "utils/LatencyTracer.hpp"
+#include "utils/Metrics.hpp"
+#include "utils/Logger.hpp"
 
-#include <iostream>
 #include <limits>
+#include <map>
 #include <type_traits>
 #include <soci/soci.h>
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("postgres");
+
+
 namespace Database {
 
     PROVIDE_EVENTLOOP_MODULE("database", "postgres", Postgres)
@@ -45,6 +51,9 @@ namespace Database {
         static Query::TraverseCallbacks getTraverseCallbacks(stringstream& ss, size_t& filterDataIndex);
 
         std::list<std::shared_ptr<IEvent>> heldBackQueries;
+        /// Query latencies by statement shape, e.g. "insert harpoon_irc_backlog"
+        std::map<std::string, MetricsHistogram*> queryHistograms;
+        MetricsHistogram& getQueryHistogram(const std::string& shape);
 
         friend Postgres;
     };
@@ -124,7 +133,7 @@ namespace Database {
         ss << ")" << endl;
 
 #ifdef DATABASE_VERBOSE_QUERY
-        cout << ss.str() << endl;
+        LOG_DEBUG(logModule) << "query" << logField("sql", ss.str());
 #endif
 
         sqlSession->once << ss.str();
@@ -146,7 +155,7 @@ namespace Database {
                    << " WHERE " << join.field << " = :data" << joinIndex << " LIMIT 1";
 
 #ifdef DATABASE_VERBOSE_QUERY
-        cout << ss.str() << endl;
+        LOG_DEBUG(logModule) << "query" << logField("sql", ss.str());
 #endif
 
                 sqlSession->once << ss.str(), soci::into(joinIds[joinIndex]), soci::use(join.on);
@@ -169,11 +178,11 @@ namespace Database {
                    << " (" << join.field << ") VALUES (:data)";
 
 #ifdef DATABASE_VERBOSE_QUERY
-                cout << ss.str() << endl;
+                LOG_DEBUG(logModule) << "query" << logField("sql", ss.str());
 #endif
                 sqlSession->once << ss.str(), soci::use(join.on);
 #ifdef DATABASE_VERBOSE_QUERY
-                cout << "SELECT CURRVAL('" << join.table << "_" << join.field << "_id_seq')" << endl;
+                LOG_DEBUG(logModule) << "query" << logField("sql", "SELECT CURRVAL('" + join.table + "_" + join.field + "_id_seq')");
 #endif
                 sqlSession->once << "SELECT CURRVAL('" << join.table << "_" << join.field << "_id_seq')", soci::into(joinIds[joinIndex]);
 
@@ -222,7 +231,7 @@ namespace Database {
             ss << ";";
 
 #ifdef DATABASE_VERBOSE_QUERY
-            cout << ss.str() << endl;
+            LOG_DEBUG(logModule) << "query" << logField("sql", ss.str());
 #endif
 
             {
@@ -262,7 +271,7 @@ namespace Database {
             ss << ";";
 
 #ifdef DATABASE_VERBOSE_QUERY
-            cout << ss.str() << endl;
+            LOG_DEBUG(logModule) << "query" << logField("sql", ss.str());
 #endif
 
             {
@@ -324,7 +333,7 @@ namespace Database {
             ss << " LIMIT " << store->limit;
 
 #ifdef DATABASE_VERBOSE_QUERY
-        cout << ss.str() << endl;
+        LOG_DEBUG(logModule) << "query" << logField("sql", ss.str());
 #endif
 
         {
@@ -374,7 +383,7 @@ namespace Database {
             ss << " LIMIT " << store->limit;
 
 #ifdef DATABASE_VERBOSE_QUERY
-        cout << ss.str() << endl;
+        LOG_DEBUG(logModule) << "query" << logField("sql", ss.str());
 #endif
 
         {
@@ -405,35 +414,59 @@ namespace Database {
 
         for (const auto& subQuery : db->getQueries()) {
             auto ptr = subQuery.get();
+            auto started = chrono::steady_clock::now();
+            string shape; // statement type and table for the metrics
             auto insert = dynamic_cast<Query::QueryInsert_Store*>(ptr);
             if (insert) { // INSERT
                 query_insert(insert, result.get());
+                shape = "insert " + insert->into;
             } else {
                 auto select = dynamic_cast<Query::QuerySelect_Store*>(ptr);
                 if (select) { // SELECT
                     query_select(select, result.get());
+                    shape = "select " + select->from;
                 } else {
                     auto update = dynamic_cast<Query::QueryUpdate_Store*>(ptr);
                     if (update) { // UPDATE
                         query_update(update, result.get());
+                        shape = "update " + update->table;
                     } else {
                         auto erase = dynamic_cast<Query::QueryDelete_Store*>(ptr);
                         if (erase) { // DELETE
                             query_delete(erase, result.get());
+                            shape = "delete " + erase->from;
                         } else {
                             auto create = dynamic_cast<Query::QueryCreate_Store*>(ptr);
                             if (create) { // CREATE
                                 query_createTable(create, result.get());
+                                shape = "create " + create->name;
                             }
                         }
                     }
                 }
             }
+            if (!shape.empty())
+                getQueryHistogram(shape).observe(chrono::steady_clock::now() - started);
         }
 
+        // statements are committed on execution, e.g. the backlog INSERT of a chat message
+        auto origin = query->getEventOrigin();
+        if (origin && LatencyTracer::getInstance().isEnabled())
+            LatencyTracer::getInstance().record("postgres/" + to_string(origin->getEventUuid()) + "/commit",
+                                                chrono::steady_clock::now() - origin->getCreated());
+
         query->getTarget()->sendEvent(result);
     }
 
+    MetricsHistogram& Postgres_Impl::getQueryHistogram(const std::string& shape) {
+        auto& histogram = queryHistograms[shape];
+        if (!histogram)
+            histogram = &MetricsRegistry::getInstance().getHistogram("harpoon_db_query_duration_seconds",
+                                                                     "Duration of database statements",
+                                                                     {{"statement", shape}});
+        return *histogram;
+    }
+
     bool Postgres_Impl::onEvent(std::shared_ptr<IEvent> event) {
         UUID eventType = event->getEventUuid();
         if (eventType == EventQuit::uuid) {
@@ -476,7 +509,7 @@ namespace Database {
                 sqlSession = make_shared<soci::session>(login.str());
             } catch(soci_error& e) {
                 connectionFailed = true;
-                cout << "Could not connect to database server. Reason: " << endl << e.what() << endl << endl;
+                LOG_ERROR(logModule) << "could not connect to the database server" << logField("reason", e.what());
             }
 
             for (auto query : heldBackQueries)
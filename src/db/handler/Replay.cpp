@@ -0,0 +1,41 @@
+#include "Replay.hpp"
+#include "utils/ModuleProvider.hpp"
+#include "event/EventQuit.hpp"
+#include "event/EventDatabaseQuery.hpp"
+#include "event/EventDatabaseResult.hpp"
+#include "queue/EventQueue.hpp"
+
+using namespace std;
+
+
+namespace Database {
+
+    PROVIDE_EVENTLOOP_MODULE("database", "replay", Replay)
+
+    Replay::Replay(EventQueue* appQueue)
+        : EventLoop{
+            {},
+            {
+                &EventGuard<IDatabaseEvent>
+            }
+        }
+    {
+    }
+
+    Replay::~Replay() {
+    }
+
+    bool Replay::onEvent(std::shared_ptr<IEvent> event) {
+        UUID eventType = event->getEventUuid();
+        if (eventType == EventQuit::uuid) {
+            return false;
+        } else if (eventType == EventDatabaseQuery::uuid) {
+            auto query = event->as<EventDatabaseQuery>();
+            auto result = make_shared<EventDatabaseResult>(query->getEventOrigin());
+            result->setSuccess(true);
+            query->getTarget()->sendEvent(result);
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,24 @@
+#ifndef DATABASEREPLAY_H
+#define DATABASEREPLAY_H
+
+#include <memory>
+#include "queue/EventLoop.hpp"
+
+
+class EventQueue;
+namespace Database {
+
+    /// Stand-in database for replaying traces.
+    /// Every query succeeds without returning rows, nothing is stored.
+    class Replay : public EventLoop {
+    public:
+        explicit Replay(EventQueue* appQueue);
+        virtual ~Replay();
+
+        virtual bool onEvent(std::shared_ptr<IEvent> event) override;
+    };
+
+}
+
+
+#endif
@@ -51,6 +51,9 @@ namespace Query {
         inline Statement()
         { }
 
+        virtual inline ~Statement()
+        { }
+
         virtual inline void traverse(const TraverseCallbacks& cb) {};
     };
 
@@ -0,0 +1,29 @@
+#include "EventClientOption.hpp"
+
+
+UUID EventClientOption::getEventUuid() const {
+    return this->uuid;
+}
+
+EventPriority EventClientOption::getPriority() const {
+    return EventPriority::High;
+}
+
+EventClientOption::EventClientOption(void* data, const std::string& name, const std::string& value)
+    : data{data}
+    , name{name}
+    , value{value}
+{
+}
+
+void* EventClientOption::getData() const {
+    return data;
+}
+
+std::string EventClientOption::getName() const {
+    return name;
+}
+
+std::string EventClientOption::getValue() const {
+    return value;
+}
@@ -0,0 +1,29 @@
+#ifndef EVENTCLIENTOPTION_H
+#define EVENTCLIENTOPTION_H
+
+#include "IEvent.hpp"
+#include <string>
+
+/// A client connection requested some protocol option (e.g. compression)
+class EventClientOption : public IEvent {
+    void* data;
+    std::string name;
+    std::string value;
+public:
+    static constexpr UUID uuid = 72;
+    virtual UUID getEventUuid() const override;
+    /// Same lane as login results and logouts, options must not be overtaken by them
+    virtual EventPriority getPriority() const override;
+
+    /// Constructor
+    ///
+    /// \param data Custom data for identification of the client connection
+    /// \param name Name of the requested option
+    /// \param value Requested value for the option
+    EventClientOption(void* data, const std::string& name, const std::string& value);
+    void* getData() const;
+    std::string getName() const;
+    std::string getValue() const;
+};
+
+#endif
@@ -5,6 +5,10 @@ UUID EventDatabaseQuery::getEventUuid() const {
     return this->uuid;
 }
 
+EventPriority EventDatabaseQuery::getPriority() const {
+    return eventOrigin ? eventOrigin->getPriority() : EventPriority::Normal;
+}
+
 EventQueue* EventDatabaseQuery::getTarget() const {
     return target;
 }
@@ -29,6 +29,8 @@ class EventDatabaseQuery : public IDatabaseEvent {
 public:
     static constexpr UUID uuid = 1;
     virtual UUID getEventUuid() const override;
+    /// Same lane as the event which caused the query
+    virtual EventPriority getPriority() const override;
 
     /// Constructor adding all supplied queries into the event
     template<class... T>
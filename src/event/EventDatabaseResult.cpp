@@ -5,6 +5,10 @@ UUID EventDatabaseResult::getEventUuid() const {
     return this->uuid;
 }
 
+EventPriority EventDatabaseResult::getPriority() const {
+    return eventOrigin ? eventOrigin->getPriority() : EventPriority::Normal;
+}
+
 EventDatabaseResult::EventDatabaseResult(std::shared_ptr<IEvent> eventOrigin)
     : success{false}
     , eventOrigin{eventOrigin}
@@ -4,6 +4,7 @@
 #include "IDatabaseEvent.hpp"
 #include <memory>
 #include <list>
+#include <string>
 
 
 class EventQueue;
@@ -14,6 +15,8 @@ class EventDatabaseResult : public IDatabaseEvent {
 public:
     static constexpr UUID uuid = 2;
     virtual UUID getEventUuid() const override;
+    /// Same lane as the event which caused the query
+    virtual EventPriority getPriority() const override;
 
     explicit EventDatabaseResult(std::shared_ptr<IEvent> eventOrigin);
     void setSuccess(bool success);
@@ -5,3 +5,7 @@ UUID EventInit::getEventUuid() const {
     return this->uuid;
 }
 
+EventPriority EventInit::getPriority() const {
+    return EventPriority::High;
+}
+
@@ -8,6 +8,7 @@ class EventInit : public IEvent {
 public:
     static constexpr UUID uuid = 3;
     virtual UUID getEventUuid() const override;
+    virtual EventPriority getPriority() const override;
 };
 
 #endif
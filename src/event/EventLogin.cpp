@@ -5,6 +5,10 @@ UUID EventLogin::getEventUuid() const {
     return this->uuid;
 }
 
+EventPriority EventLogin::getPriority() const {
+    return EventPriority::High;
+}
+
 EventLogin::EventLogin(void* data, const std::string& username, const std::string& password)
     : data{data}
     , username{username}
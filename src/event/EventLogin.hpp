@@ -2,6 +2,7 @@
 #define EVENTLOGIN_H
 
 #include <memory>
+#include <string>
 #include "IEvent.hpp"
 
 
@@ -21,6 +22,7 @@ public:
 
     static constexpr UUID uuid = 4;
     virtual UUID getEventUuid() const override;
+    virtual EventPriority getPriority() const override;
 
     EventQueue* getTarget() const;
     void* getData() const;
@@ -5,6 +5,10 @@ UUID EventLoginResult::getEventUuid() const {
 	return this->uuid;
 }
 
+EventPriority EventLoginResult::getPriority() const {
+	return EventPriority::High;
+}
+
 EventLoginResult::EventLoginResult(bool success,
 								   size_t userId,
 								   void* data)
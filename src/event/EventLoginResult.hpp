@@ -14,6 +14,7 @@ class EventLoginResult : public ISingleClientEvent {
 public:
     static constexpr UUID uuid = 5;
     virtual UUID getEventUuid() const override;
+    virtual EventPriority getPriority() const override;
 
     /// Constructor
     ///
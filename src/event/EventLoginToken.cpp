@@ -0,0 +1,24 @@
+#include "EventLoginToken.hpp"
+
+
+UUID EventLoginToken::getEventUuid() const {
+    return this->uuid;
+}
+
+EventPriority EventLoginToken::getPriority() const {
+    return EventPriority::High;
+}
+
+EventLoginToken::EventLoginToken(void* data, size_t userId)
+    : data{data}
+    , userId{userId}
+{
+}
+
+void* EventLoginToken::getData() const {
+    return data;
+}
+
+size_t EventLoginToken::getUserId() const {
+    return userId;
+}
@@ -0,0 +1,26 @@
+#ifndef EVENTLOGINTOKEN_H
+#define EVENTLOGINTOKEN_H
+
+#include "IEvent.hpp"
+#include <cstdlib>
+
+/// Event for checking if the user of a verified session token still exists,
+/// answered by the login database with an EventLoginResult
+class EventLoginToken : public IEvent {
+    void* data;
+    size_t userId;
+public:
+    static constexpr UUID uuid = 76;
+    virtual UUID getEventUuid() const override;
+    virtual EventPriority getPriority() const override;
+
+    /// Constructor
+    ///
+    /// \param data Custom data for identification purposes
+    /// \param userId User id stored in the token
+    EventLoginToken(void* data, size_t userId);
+    void* getData() const;
+    size_t getUserId() const;
+};
+
+#endif
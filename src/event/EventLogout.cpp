@@ -5,6 +5,10 @@ UUID EventLogout::getEventUuid() const {
     return this->uuid;
 }
 
+EventPriority EventLogout::getPriority() const {
+    return EventPriority::High;
+}
+
 EventLogout::EventLogout(void* data)
     : data{data}
 {
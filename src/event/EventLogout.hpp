@@ -10,6 +10,7 @@ class EventLogout : public IEvent {
 public:
     static constexpr UUID uuid = 6;
     virtual UUID getEventUuid() const override;
+    virtual EventPriority getPriority() const override;
 
     explicit EventLogout(void* data);
     void* getData() const;
@@ -4,6 +4,7 @@
 enum class EventQueryType
 {
     Chats, ///< requests a listing of all active servers and chats
+    ChatsWithoutUsers, ///< like Chats, but channels only contain the amount of users
     Settings ///< returns configuration data like server+channel settings
 };
 
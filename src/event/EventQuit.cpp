@@ -5,3 +5,7 @@ UUID EventQuit::getEventUuid() const {
     return this->uuid;
 }
 
+EventPriority EventQuit::getPriority() const {
+    return EventPriority::High;
+}
+
@@ -8,6 +8,7 @@ class EventQuit : public IEvent {
 public:
     static constexpr UUID uuid = 8;
     virtual UUID getEventUuid() const override;
+    virtual EventPriority getPriority() const override;
 };
 
 #endif
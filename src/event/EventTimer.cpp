@@ -0,0 +1,15 @@
+#include "EventTimer.hpp"
+
+
+UUID EventTimer::getEventUuid() const {
+    return this->uuid;
+}
+
+EventTimer::EventTimer(size_t timerId)
+    : timerId{timerId}
+{
+}
+
+size_t EventTimer::getTimerId() const {
+    return timerId;
+}
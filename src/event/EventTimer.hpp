@@ -0,0 +1,18 @@
+#ifndef EVENTTIMER_H
+#define EVENTTIMER_H
+
+#include "IEvent.hpp"
+#include <cstdlib>
+
+/// A timer of an event loop expired, only delivered to the loop which scheduled it
+class EventTimer : public IEvent {
+    size_t timerId;
+public:
+    static constexpr UUID uuid = 75;
+    virtual UUID getEventUuid() const override;
+
+    explicit EventTimer(size_t timerId);
+    size_t getTimerId() const;
+};
+
+#endif
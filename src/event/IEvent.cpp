@@ -3,9 +3,18 @@
 
 IEvent::IEvent()
     : timestamp(std::chrono::system_clock::now())
+    , created(std::chrono::steady_clock::now())
 {
 }
 
+EventPriority IEvent::getPriority() const {
+    return EventPriority::Normal;
+}
+
 decltype(IEvent::timestamp) IEvent::getTimestamp() const {
     return timestamp;
 }
+
+decltype(IEvent::created) IEvent::getCreated() const {
+    return created;
+}
@@ -5,13 +5,26 @@
 #include <chrono>
 
 
+/// Lane of an event inside an EventQueue, higher lanes are processed first
+enum class EventPriority {
+    /// Control flow like logins and quitting
+    High,
+    /// Everything else, events of this lane keep their order
+    Normal
+};
+
 class IEvent {
     std::chrono::time_point<std::chrono::system_clock> timestamp;
+    /// Monotonic creation time for latency measurements
+    std::chrono::steady_clock::time_point created;
 protected:
     IEvent();
 public:
     virtual UUID getEventUuid() const = 0;
+    /// Lane of the event type, normal by default
+    virtual EventPriority getPriority() const;
     decltype(timestamp) getTimestamp() const;
+    decltype(created) getCreated() const;
     template <class T>
     T* as() { return dynamic_cast<T*>(this); }
 };
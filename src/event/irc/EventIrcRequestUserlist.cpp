@@ -0,0 +1,45 @@
+#include "EventIrcRequestUserlist.hpp"
+
+
+UUID EventIrcRequestUserlist::getEventUuid() const {
+    return this->uuid;
+}
+
+EventIrcRequestUserlist::EventIrcRequestUserlist(size_t userId,
+                                                 size_t serverId,
+                                                 const std::string& channel,
+                                                 const std::string& after,
+                                                 size_t count,
+                                                 void* data)
+    : userId{userId}
+    , serverId{serverId}
+    , channel{channel}
+    , after{after}
+    , count{count}
+    , data{data}
+{
+}
+
+size_t EventIrcRequestUserlist::getUserId() const {
+    return userId;
+}
+
+size_t EventIrcRequestUserlist::getServerId() const {
+    return serverId;
+}
+
+std::string EventIrcRequestUserlist::getChannel() const {
+    return channel;
+}
+
+std::string EventIrcRequestUserlist::getAfter() const {
+    return after;
+}
+
+size_t EventIrcRequestUserlist::getCount() const {
+    return count;
+}
+
+void* EventIrcRequestUserlist::getData() const {
+    return data;
+}
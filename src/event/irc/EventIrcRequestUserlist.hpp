@@ -0,0 +1,39 @@
+#ifndef EVENTIRCREQUESTUSERLIST_H
+#define EVENTIRCREQUESTUSERLIST_H
+
+#include "IIrcCommand.hpp"
+#include <string>
+
+
+/// Requests a page of the users of a channel for a single client
+class EventIrcRequestUserlist : public IIrcCommand {
+    size_t userId;
+    size_t serverId;
+    std::string channel;
+    std::string after;
+    size_t count;
+    void* data;
+public:
+    static constexpr UUID uuid = 73;
+    virtual UUID getEventUuid() const override;
+
+    /// Constructor
+    ///
+    /// \param after Nick of the last user of the previous page, empty for the first page
+    /// \param count Maximum amount of users in the page
+    /// \param data Custom data for identification of the client connection
+    EventIrcRequestUserlist(size_t userId,
+                            size_t serverId,
+                            const std::string& channel,
+                            const std::string& after,
+                            size_t count,
+                            void* data);
+    virtual size_t getUserId() const override;
+    virtual size_t getServerId() const override;
+    std::string getChannel() const;
+    std::string getAfter() const;
+    size_t getCount() const;
+    void* getData() const;
+};
+
+#endif
@@ -53,3 +53,11 @@ std::string EventIrcUserStatusChanged::getMode() const {
 std::string EventIrcUserStatusChanged::getReason() const {
     return reason;
 }
+
+void EventIrcUserStatusChanged::addChannel(const std::string& lchannel) {
+    channels.push_back(lchannel);
+}
+
+const std::vector<std::string>& EventIrcUserStatusChanged::getChannels() const {
+    return channels;
+}
@@ -4,6 +4,7 @@
 #include "../IClientEvent.hpp"
 #include "IrcLoggable.hpp"
 #include <string>
+#include <vector>
 
 
 /// Event for notifying that a irc user's status changed
@@ -24,6 +25,7 @@ private:
     Status status;
     std::string targetOrMode;
     std::string reason;
+    std::vector<std::string> channels;
 public:
     static constexpr UUID uuid = 34;
     virtual UUID getEventUuid() const override;
@@ -43,6 +45,10 @@ public:
     std::string getReason() const;
     std::string getTarget() const;
     std::string getMode() const;
+    /// Adds a channel the user was in, used on quits
+    void addChannel(const std::string& channel);
+    /// Returns the channels the user was in when quitting
+    const std::vector<std::string>& getChannels() const;
 };
 
 #endif
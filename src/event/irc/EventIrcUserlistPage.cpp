@@ -0,0 +1,53 @@
+#include "EventIrcUserlistPage.hpp"
+
+
+UUID EventIrcUserlistPage::getEventUuid() const {
+    return this->uuid;
+}
+
+EventIrcUserlistPage::EventIrcUserlistPage(size_t userId,
+                                           size_t serverId,
+                                           const std::string& channel,
+                                           size_t userCount,
+                                           bool complete,
+                                           void* data)
+    : userId{userId}
+    , serverId{serverId}
+    , channel{channel}
+    , userCount{userCount}
+    , complete{complete}
+    , data{data}
+{
+}
+
+void EventIrcUserlistPage::addUser(const std::string& nick, const std::string& mode) {
+    users.emplace_back(nick, mode);
+}
+
+size_t EventIrcUserlistPage::getUserId() const {
+    return userId;
+}
+
+size_t EventIrcUserlistPage::getServerId() const {
+    return serverId;
+}
+
+std::string EventIrcUserlistPage::getChannel() const {
+    return channel;
+}
+
+size_t EventIrcUserlistPage::getUserCount() const {
+    return userCount;
+}
+
+bool EventIrcUserlistPage::getComplete() const {
+    return complete;
+}
+
+const std::list<IrcChannelUser>& EventIrcUserlistPage::getUsers() const {
+    return users;
+}
+
+void* EventIrcUserlistPage::getData() const {
+    return data;
+}
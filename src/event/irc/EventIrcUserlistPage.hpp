@@ -0,0 +1,43 @@
+#ifndef EVENTIRCUSERLISTPAGE_H
+#define EVENTIRCUSERLISTPAGE_H
+
+#include "../ISingleClientEvent.hpp"
+#include "IrcChannelUser.hpp"
+#include <string>
+#include <list>
+
+
+/// A page of channel users, answer to EventIrcRequestUserlist
+class EventIrcUserlistPage : public ISingleClientEvent {
+    size_t userId;
+    size_t serverId;
+    std::string channel;
+    size_t userCount;
+    bool complete;
+    std::list<IrcChannelUser> users;
+    void* data;
+public:
+    static constexpr UUID uuid = 74;
+    virtual UUID getEventUuid() const override;
+
+    /// Constructor
+    ///
+    /// \param userCount Amount of users in the whole channel
+    /// \param complete True if this is the last page
+    EventIrcUserlistPage(size_t userId,
+                         size_t serverId,
+                         const std::string& channel,
+                         size_t userCount,
+                         bool complete,
+                         void* data);
+    void addUser(const std::string& nick, const std::string& mode);
+    virtual size_t getUserId() const override;
+    size_t getServerId() const;
+    std::string getChannel() const;
+    size_t getUserCount() const;
+    bool getComplete() const;
+    const std::list<IrcChannelUser>& getUsers() const;
+    virtual void* getData() const override;
+};
+
+#endif
@@ -20,6 +20,10 @@ EventIrcUserlistReceived::EventIrcUserlistReceived(size_t userId,
 {
 }
 
+void EventIrcUserlistReceived::reserveUsers(size_t count) {
+    users.reserve(count);
+}
+
 void EventIrcUserlistReceived::addUser(const std::string& nick,
                                        const std::string& mode) {
     users.emplace_back(nick, mode);
@@ -37,6 +41,6 @@ std::string EventIrcUserlistReceived::getChannel() const {
     return channel;
 }
 
-const std::list<EventIrcUserlistReceived::User>& EventIrcUserlistReceived::getUsers() const {
+const std::vector<EventIrcUserlistReceived::User>& EventIrcUserlistReceived::getUsers() const {
     return users;
 }
@@ -3,7 +3,7 @@
 
 #include "../IClientEvent.hpp"
 #include <string>
-#include <list>
+#include <vector>
 
 
 class EventIrcUserlistReceived : public IClientEvent {
@@ -17,7 +17,7 @@ class EventIrcUserlistReceived : public IClientEvent {
     size_t userId;
     size_t serverId;
     std::string channel;
-    std::list<User> users;
+    std::vector<User> users;
 public:
     static constexpr UUID uuid = 45;
     virtual UUID getEventUuid() const override;
@@ -25,11 +25,13 @@ public:
     EventIrcUserlistReceived(size_t userId,
                              size_t serverId,
                              const std::string& channel);
+    /// Reserves space for the users of a complete NAMES reply
+    void reserveUsers(size_t count);
     void addUser(const std::string& nick, const std::string& mode);
     virtual size_t getUserId() const override;
     size_t getServerId() const;
     std::string getChannel() const;
-    const std::list<User>& getUsers() const;
+    const std::vector<User>& getUsers() const;
 };
 
 #endif
@@ -5,18 +5,28 @@ IrcChannelListing::IrcChannelListing(const std::string& channelName,
                                      bool disabled)
     : channelName{channelName}
     , channelTopic{channelTopic}
+    , userCount{0}
     , disabled{disabled}
 {
 }
 
 void IrcChannelListing::addUser(const std::string& nick, const std::string& mode) {
     users.emplace_back(nick, mode);
+    ++userCount;
+}
+
+void IrcChannelListing::setUserCount(size_t luserCount) {
+    userCount = luserCount;
 }
 
 const std::list<IrcChannelUser>& IrcChannelListing::getUsers() const {
     return users;
 }
 
+size_t IrcChannelListing::getUserCount() const {
+    return userCount;
+}
+
 
 std::string IrcChannelListing::getChannelName() const {
     return channelName;
@@ -10,6 +10,7 @@ class IrcChannelListing {
     std::string channelName;
     std::string channelTopic;
     std::list<IrcChannelUser> users;
+    size_t userCount;
     bool disabled;
 public:
     IrcChannelListing(const std::string& channelName,
@@ -17,7 +18,10 @@ public:
                       bool disabled);
 
     void addUser(const std::string& nick, const std::string& mode);
+    /// Sets the amount of users if they are not added to the listing
+    void setUserCount(size_t userCount);
     const std::list<IrcChannelUser>& getUsers() const;
+    size_t getUserCount() const;
     std::string getChannelName() const;
     std::string getChannelTopic() const;
     bool getDisabled() const;
@@ -1,13 +1,15 @@
-#include <iostream>
 #include <algorithm>
 #include <array>
 #include <sstream>
 #include "app/Application.hpp"
 #include "app/ArgumentParser.hpp"
+#include "utils/Logger.hpp"
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("application");
+
 int main(int argc, char** argv) {
     // Includes check for setup flags for generation of the config files
     if (!ArgumentParser::checkArgs(argc, argv))
@@ -16,10 +18,11 @@ int main(int argc, char** argv) {
     try {
         Application app;
     } catch(runtime_error& run) {
-        cout << run.what() << endl;
+        LOG_ERROR(logModule) << run.what();
     }
 
-    std::cout << "Application stopped" << std::endl;
+    LOG_INFO(logModule) << "application stopped";
+    Logger::getInstance().flush();
     return 0;
 }
 
@@ -5,11 +5,30 @@
 using namespace std;
 
 
+size_t EventLoop::addMetricsCollector(EventLoop* loop) {
+    auto& registry = MetricsRegistry::getInstance();
+    static bool described = [&registry] {
+        registry.describe("harpoon_queue_depth", "Events waiting per event loop and priority lane", "gauge");
+        registry.describe("harpoon_queue_enqueued_total", "Events sent per event loop and priority lane", "counter");
+        registry.describe("harpoon_queue_dropped_total", "Events dropped by the overflow policy", "counter");
+        registry.describe("harpoon_queue_spilled", "Events waiting behind the lane with the spill policy", "gauge");
+        registry.describe("harpoon_queue_enqueue_rate", "Events sent per second", "gauge");
+        return true;
+    }();
+    (void)described;
+    return registry.addCollector([loop](MetricsRegistry::Collection& collection) {
+        loop->collectMetrics(collection);
+    });
+}
+
 EventLoop::EventLoop()
     : queue{}
     , threaded{true}
     , t{std::thread([this]{ run(); })}
     , destruction{false}
+    , name{"loop"}
+    , nameChanged{false}
+    , metricsCollector{addMetricsCollector(this)}
 {
 }
 
@@ -17,12 +36,16 @@ EventLoop::EventLoop(const std::set<UUID>& processableEvents, const std::list<bo
     : queue{processableEvents, eventGuards}
     , threaded{threaded}
     , destruction{false}
+    , name{"loop"}
+    , nameChanged{false}
+    , metricsCollector{addMetricsCollector(this)}
 {
     if (threaded)
         t = std::thread([this]{ run(); });
 }
 
 EventLoop::~EventLoop() {
+    MetricsRegistry::getInstance().removeCollector(metricsCollector);
     destruction = true;
     if (threaded) {
         queue.stop();
@@ -32,17 +55,84 @@ EventLoop::~EventLoop() {
 
 void EventLoop::run() {
     std::shared_ptr<IEvent> event; // will be filled by getEvent
+    chrono::steady_clock::time_point queued;
+    auto& tracer = LatencyTracer::getInstance();
 
-    int eventResult;
-    // loop and wait for events with a timeout of 1000
-    while ((eventResult = queue.getEvent(event)) >= 0) {
+    // loop and wait for events, timers are delivered as events
+    while (queue.getEvent(event, queued)) {
         if (destruction) break;
-        if (eventResult < 0) break; // error
-        if (eventResult == 0) continue; // timeout
-        if (!onEvent(event)) break;
+        if (!tracer.isEnabled()) {
+            if (!onEvent(event)) break;
+            continue;
+        }
+
+        // stamp the hops enqueue, dequeue and handler end
+        auto dequeued = chrono::steady_clock::now();
+        bool result = onEvent(event);
+        auto handled = chrono::steady_clock::now();
+        auto& paths = getTracePaths(event->getEventUuid());
+        paths.wait->record(dequeued - queued);
+        paths.handle->record(handled - dequeued);
+        paths.age->record(handled - event->getCreated());
+        if (!result) break;
+    }
+}
+
+EventLoop::TracePaths& EventLoop::getTracePaths(UUID eventUuid) {
+    if (nameChanged.exchange(false))
+        tracePaths.clear();
+    auto it = tracePaths.find(eventUuid);
+    if (it != tracePaths.end()) return it->second;
+
+    string prefix;
+    {
+        lock_guard<mutex> lock(nameMutex);
+        prefix = name + "/" + to_string(eventUuid) + "/";
+    }
+    auto& tracer = LatencyTracer::getInstance();
+    TracePaths paths{tracer.getPath(prefix + "wait"), tracer.getPath(prefix + "handle"), tracer.getPath(prefix + "age")};
+    return tracePaths.emplace(eventUuid, paths).first->second;
+}
+
+void EventLoop::setName(const std::string& lname) {
+    {
+        lock_guard<mutex> lock(nameMutex);
+        name = lname;
     }
+    nameChanged = true;
 }
 
 EventQueue* EventLoop::getEventQueue() {
     return &queue;
 }
+
+size_t EventLoop::scheduleAfter(std::chrono::milliseconds delay) {
+    return queue.addTimer(delay);
+}
+
+size_t EventLoop::scheduleEvery(std::chrono::milliseconds interval) {
+    return queue.addTimer(interval, interval);
+}
+
+bool EventLoop::cancelTimer(size_t timerId) {
+    return queue.cancelTimer(timerId);
+}
+
+void EventLoop::collectMetrics(MetricsRegistry::Collection& collection) {
+    string loopName;
+    {
+        lock_guard<mutex> lock(nameMutex);
+        loopName = name;
+    }
+    // loops of the same name, like the irc connections, are summed up
+    auto statistics = queue.getStatistics();
+    for (size_t lane = 0; lane < statistics.size(); ++lane) {
+        MetricsRegistry::Labels labels{{"loop", loopName},
+                                       {"lane", lane == static_cast<size_t>(EventPriority::High) ? "high" : "normal"}};
+        collection.add("harpoon_queue_depth", labels, statistics[lane].depth);
+        collection.add("harpoon_queue_enqueued_total", labels, statistics[lane].enqueued);
+        collection.add("harpoon_queue_dropped_total", labels, statistics[lane].dropped);
+        collection.add("harpoon_queue_spilled", labels, statistics[lane].spilled);
+        collection.add("harpoon_queue_enqueue_rate", labels, statistics[lane].enqueueRate);
+    }
+}
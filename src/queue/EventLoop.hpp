@@ -5,8 +5,15 @@
 #include <memory>
 #include <set>
 #include <list>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <unordered_map>
 #include "utils/uuid.hpp"
 #include "queue/EventQueue.hpp"
+#include "utils/LatencyTracer.hpp"
+#include "utils/Metrics.hpp"
 
 
 /// Used to filter for only specific events. A dynamic_cast is used to filter by event class.
@@ -25,6 +32,29 @@ class EventLoop {
     bool threaded;
     std::thread t;
     bool destruction;
+
+    /// Latency histograms of an event type
+    struct TracePaths {
+        LatencyTracer::Path* wait;
+        LatencyTracer::Path* handle;
+        LatencyTracer::Path* age;
+    };
+    std::mutex nameMutex;
+    /// Prefix of the latency paths, guarded by nameMutex
+    std::string name;
+    std::atomic<bool> nameChanged;
+    /// Only used by the loop thread
+    std::unordered_map<UUID, TracePaths> tracePaths;
+    /// Publishes the queue statistics
+    size_t metricsCollector;
+
+    /// Describes the queue metrics once and registers the collector of a loop
+    static size_t addMetricsCollector(EventLoop* loop);
+    /// Adds the queue statistics to the metrics, called while rendering them
+    void collectMetrics(MetricsRegistry::Collection& collection);
+
+    /// Returns the cached latency paths of an event type
+    TracePaths& getTracePaths(UUID eventUuid);
 protected:
     /// Callback for when events are received
     virtual bool onEvent(std::shared_ptr<IEvent> event) = 0;
@@ -39,6 +69,21 @@ public:
     void run();
     /// Accessor for the EventQueue instance.
     EventQueue* getEventQueue();
+    /// Names the loop in latency traces, can be called from any thread.
+    void setName(const std::string& name);
+
+    /// Delivers an EventTimer to onEvent once after the delay, can be called from any thread.
+    ///
+    /// \returns Id of the timer
+    size_t scheduleAfter(std::chrono::milliseconds delay);
+    /// Delivers an EventTimer to onEvent every interval, can be called from any thread.
+    ///
+    /// \returns Id of the timer
+    size_t scheduleEvery(std::chrono::milliseconds interval);
+    /// Stops a scheduled timer.
+    ///
+    /// \returns false if the timer is unknown or a one-shot timer already expired.
+    bool cancelTimer(size_t timerId);
 };
 
 
@@ -1,11 +1,205 @@
 #include "EventQueue.hpp"
 #include "EventQueue_Impl.hpp"
+#include "event/EventTimer.hpp"
 
 #include <chrono>
 
 using namespace std;
 
 
+const size_t EventQueue::laneCount;
+const size_t EventQueue::starvationLimit;
+
+EventQueue::LaneStatistics::LaneStatistics()
+    : depth{0}
+    , maxDepth{0}
+    , processed{0}
+    , enqueued{0}
+    , dropped{0}
+    , spilled{0}
+    , enqueueRate{0}
+    , totalWait{0}
+    , maxWait{0}
+{
+}
+
+EventQueue::Limits::Limits()
+    : capacity{0}
+    , policy{OverflowPolicy::DropOldest}
+    , encode{nullptr}
+    , decode{nullptr}
+{
+}
+
+EventQueue_Impl::EventQueue_Impl()
+    : skipped{}
+    , rateCount{}
+    , spillRead{0}
+    , spillWrite{0}
+{
+    auto now = chrono::steady_clock::now();
+    for (auto& start : rateStart)
+        start = now;
+}
+
+size_t EventQueue_Impl::getLane(const IEvent* event) {
+    return min(static_cast<size_t>(event->getPriority()), EventQueue::laneCount - 1);
+}
+
+void EventQueue_Impl::push(std::shared_ptr<IEvent> event) {
+    size_t lane = getLane(event.get());
+    auto now = chrono::steady_clock::now();
+    lanes[lane].push_back(QueuedEvent{move(event), now});
+
+    auto& laneStatistics = statistics[lane];
+    laneStatistics.depth = lanes[lane].size();
+    laneStatistics.maxDepth = max(laneStatistics.maxDepth, laneStatistics.depth);
+    laneStatistics.enqueued += 1;
+    updateRate(lane, now);
+    rateCount[lane] += 1;
+}
+
+void EventQueue_Impl::updateRate(size_t lane, std::chrono::steady_clock::time_point now) {
+    auto elapsed = chrono::duration<double>(now - rateStart[lane]);
+    if (elapsed < chrono::seconds(1)) return;
+    statistics[lane].enqueueRate = rateCount[lane] / elapsed.count();
+    rateStart[lane] = now;
+    rateCount[lane] = 0;
+}
+
+size_t EventQueue_Impl::getBoundedDepth() const {
+    size_t depth = 0;
+    for (size_t i = static_cast<size_t>(EventPriority::Normal); i < EventQueue::laneCount; ++i)
+        depth += lanes[i].size();
+    return depth;
+}
+
+bool EventQueue_Impl::dropOldest(const std::set<UUID>& droppable) {
+    // the lowest lane loses its events first
+    for (size_t i = EventQueue::laneCount; i-- > static_cast<size_t>(EventPriority::Normal);) {
+        auto& lane = lanes[i];
+        for (auto it = lane.begin(); it != lane.end(); ++it) {
+            if (!droppable.empty() && droppable.count(it->event->getEventUuid()) == 0)
+                continue;
+            lane.erase(it);
+            statistics[i].depth = lane.size();
+            statistics[i].dropped += 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+void EventQueue_Impl::spill(std::shared_ptr<IEvent> event) {
+    size_t lane = getLane(event.get());
+    auto now = chrono::steady_clock::now();
+    if (!spillFile.is_open() && limits.encode && !limits.spillFile.empty()) {
+        spillFile.open(limits.spillFile, ios::in | ios::out | ios::binary | ios::trunc);
+        spillRead = spillWrite = 0;
+    }
+    if (spillFile.is_open() && limits.encode(event, spillBuffer)) {
+        uint64_t header[2] = {event->getEventUuid(), spillBuffer.size()};
+        spillFile.seekp(spillWrite);
+        spillFile.write(reinterpret_cast<const char*>(header), sizeof(header));
+        spillFile.write(spillBuffer.data(), spillBuffer.size());
+        // a failed record is overwritten by the next one, the event stays in memory
+        if (spillFile) {
+            spillWrite = spillFile.tellp();
+            event.reset();
+        } else {
+            spillFile.clear();
+        }
+    }
+    spilled.push_back(QueuedEvent{move(event), now});
+
+    auto& laneStatistics = statistics[lane];
+    laneStatistics.spilled = spilled.size();
+    laneStatistics.enqueued += 1;
+    updateRate(lane, now);
+    rateCount[lane] += 1;
+}
+
+std::shared_ptr<IEvent> EventQueue_Impl::readSpilled() {
+    uint64_t header[2];
+    spillFile.seekg(spillRead);
+    if (spillFile.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        spillBuffer.resize(header[1]);
+        if (spillFile.read(&spillBuffer[0], spillBuffer.size())) {
+            spillRead = spillFile.tellg();
+            return limits.decode ? limits.decode(header[0], spillBuffer) : nullptr;
+        }
+    }
+    spillFile.clear();
+    return nullptr;
+}
+
+void EventQueue_Impl::unspill() {
+    if (spilled.empty()) return;
+    const size_t normal = static_cast<size_t>(EventPriority::Normal);
+    while (!spilled.empty() && (limits.capacity == 0 || getBoundedDepth() < limits.capacity)) {
+        QueuedEvent queuedEvent = move(spilled.front());
+        spilled.pop_front();
+        if (!queuedEvent.event)
+            queuedEvent.event = readSpilled();
+        if (!queuedEvent.event) {
+            statistics[normal].dropped += 1;
+            continue;
+        }
+        size_t lane = getLane(queuedEvent.event.get());
+        lanes[lane].push_back(move(queuedEvent));
+        statistics[lane].depth = lanes[lane].size();
+        statistics[lane].maxDepth = max(statistics[lane].maxDepth, statistics[lane].depth);
+    }
+    statistics[normal].spilled = spilled.size();
+    // reopened with truncation by the next spilled event
+    if (spilled.empty() && spillFile.is_open())
+        spillFile.close();
+}
+
+bool EventQueue_Impl::pop(std::shared_ptr<IEvent>& event, std::chrono::steady_clock::time_point& queued) {
+    unspill();
+    size_t lane = EventQueue::laneCount;
+    // starving lanes are served first, the lowest one wins
+    for (size_t i = EventQueue::laneCount; i-- > 1;) {
+        if (!lanes[i].empty() && skipped[i] >= EventQueue::starvationLimit) {
+            lane = i;
+            break;
+        }
+    }
+    for (size_t i = 0; i < EventQueue::laneCount && lane == EventQueue::laneCount; ++i) {
+        if (!lanes[i].empty())
+            lane = i;
+    }
+    if (lane == EventQueue::laneCount) return false;
+
+    QueuedEvent& queuedEvent = lanes[lane].front();
+    auto wait = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - queuedEvent.queued);
+    event = move(queuedEvent.event);
+    queued = queuedEvent.queued;
+    lanes[lane].pop_front();
+
+    skipped[lane] = 0;
+    for (size_t i = lane + 1; i < EventQueue::laneCount; ++i) {
+        if (!lanes[i].empty())
+            skipped[i] += 1;
+    }
+
+    auto& laneStatistics = statistics[lane];
+    laneStatistics.depth = lanes[lane].size();
+    laneStatistics.processed += 1;
+    laneStatistics.totalWait += wait;
+    laneStatistics.maxWait = max(laneStatistics.maxWait, wait);
+    return true;
+}
+
+bool EventQueue_Impl::isEmpty() const {
+    for (auto& lane : lanes) {
+        if (!lane.empty()) return false;
+    }
+    return spilled.empty();
+}
+
+
 EventQueue::EventQueue()
     : impl{make_shared<EventQueue_Impl>()}
     , enabled{true}
@@ -25,10 +219,67 @@ EventQueue::EventQueue(const std::set<UUID>& eventsToBeProcessed, const std::lis
 EventQueue::~EventQueue() {
 }
 
+void EventQueue::setLimits(const Limits& limits) {
+    std::unique_lock<std::mutex> lock(impl->queueMutex);
+    impl->limits = limits;
+    impl->spaceCondition.notify_all();
+}
+
+bool EventQueue::parseOverflowPolicy(const std::string& name, OverflowPolicy& policy) {
+    if (name == "block")
+        policy = OverflowPolicy::Block;
+    else if (name == "drop_oldest")
+        policy = OverflowPolicy::DropOldest;
+    else if (name == "drop_by_class")
+        policy = OverflowPolicy::DropByClass;
+    else if (name == "spill")
+        policy = OverflowPolicy::Spill;
+    else
+        return false;
+    return true;
+}
+
 void EventQueue::sendEvent(std::shared_ptr<IEvent> event) {
     if (enabled) {
         std::unique_lock<std::mutex> lock(impl->queueMutex);
-        impl->events.push_back(event);
+
+        // high priority events are never held back
+        const Limits& limits = impl->limits;
+        size_t lane = EventQueue_Impl::getLane(event.get());
+        // once events are spilled, later ones queue up behind them to keep the order
+        if (lane != static_cast<size_t>(EventPriority::High) && !impl->spilled.empty()) {
+            impl->spill(event);
+            impl->eventCondition.notify_one();
+            return;
+        }
+        if (limits.capacity > 0 && lane != static_cast<size_t>(EventPriority::High)
+            && impl->getBoundedDepth() >= limits.capacity) {
+            switch (limits.policy) {
+            case OverflowPolicy::Block:
+                if (this_thread::get_id() != impl->consumer) {
+                    impl->spaceCondition.wait(lock, [this] {
+                        return impl->limits.capacity == 0 || impl->getBoundedDepth() < impl->limits.capacity || !running;
+                    });
+                }
+                break;
+            case OverflowPolicy::DropOldest:
+                impl->dropOldest({});
+                break;
+            case OverflowPolicy::DropByClass:
+                if (limits.droppableEvents.count(event->getEventUuid()) > 0) {
+                    impl->statistics[lane].dropped += 1;
+                    return;
+                }
+                impl->dropOldest(limits.droppableEvents);
+                break;
+            case OverflowPolicy::Spill:
+                impl->spill(event);
+                impl->eventCondition.notify_one();
+                return;
+            }
+        }
+
+        impl->push(event);
         impl->eventCondition.notify_one();
     }
 }
@@ -38,24 +289,73 @@ void EventQueue::setEnabled(bool lenabled) {
 }
 
 bool EventQueue::getEvent(std::shared_ptr<IEvent>& event) {
+    chrono::steady_clock::time_point queued;
+    return getEvent(event, queued);
+}
+
+bool EventQueue::getEvent(std::shared_ptr<IEvent>& event, std::chrono::steady_clock::time_point& queued) {
     std::unique_lock<std::mutex> lock(impl->queueMutex);
+    impl->consumer = this_thread::get_id();
+
+    while (running) {
+        if (!impl->timers.isEmpty()) {
+            // expired timers are queued behind the waiting events
+            impl->timers.advance(chrono::steady_clock::now(), impl->expiredTimers);
+            if (enabled) {
+                for (size_t timerId : impl->expiredTimers)
+                    impl->push(make_shared<EventTimer>(timerId));
+            }
+            impl->expiredTimers.clear();
+        }
 
-    if (impl->events.size() == 0) {
-        // wait until queue is filled or timeout
-        impl->eventCondition.wait(lock);
-        if (!running) return false;
+        // get and remove event from queue
+        if (impl->pop(event, queued)) {
+            if (impl->limits.capacity > 0 && impl->limits.policy == OverflowPolicy::Block)
+                impl->spaceCondition.notify_all();
+            return true;
+        }
+
+        // wait until queue is filled or the next timer expires
+        auto deadline = impl->timers.getNextDeadline();
+        if (deadline == chrono::steady_clock::time_point::max())
+            impl->eventCondition.wait(lock);
+        else
+            impl->eventCondition.wait_until(lock, deadline);
     }
+    return false;
+}
 
-    // get and remove event from queue
-    event = impl->events.front();
-    impl->events.pop_front();
-    return true;
+size_t EventQueue::addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds interval) {
+    std::unique_lock<std::mutex> lock(impl->queueMutex);
+    size_t timerId = impl->timers.add(chrono::steady_clock::now() + delay, interval);
+    // the waiting loop might sleep past the new deadline
+    impl->eventCondition.notify_one();
+    return timerId;
+}
+
+bool EventQueue::cancelTimer(size_t timerId) {
+    std::unique_lock<std::mutex> lock(impl->queueMutex);
+    return impl->timers.cancel(timerId);
+}
+
+bool EventQueue::isEmpty() {
+    std::unique_lock<std::mutex> lock(impl->queueMutex);
+    return impl->isEmpty();
+}
+
+std::vector<EventQueue::LaneStatistics> EventQueue::getStatistics() {
+    std::unique_lock<std::mutex> lock(impl->queueMutex);
+    auto now = chrono::steady_clock::now();
+    for (size_t lane = 0; lane < laneCount; ++lane)
+        impl->updateRate(lane, now);
+    return std::vector<LaneStatistics>(impl->statistics, impl->statistics + laneCount);
 }
 
 void EventQueue::stop() {
     running = false;
     std::unique_lock<std::mutex> lock(impl->queueMutex);
     impl->eventCondition.notify_one();
+    impl->spaceCondition.notify_all();
 }
 
 bool EventQueue::canProcessEvent(IEvent* event) {
@@ -2,8 +2,12 @@
 #define EVENTQUEUE_H
 
 #include <set>
+#include <chrono>
 #include <memory>
 #include <list>
+#include <vector>
+#include <cstdint>
+#include <string>
 #include "utils/uuid.hpp"
 
 
@@ -12,6 +16,63 @@ class EventQueue_Impl;
 /// Base class for receiving events.
 /// For the event loop getEvent can be used to process pending events.
 class EventQueue {
+public:
+    /// Depth and waiting times of a priority lane
+    struct LaneStatistics {
+        LaneStatistics();
+        /// Events currently waiting
+        size_t depth;
+        /// Highest depth seen
+        size_t maxDepth;
+        /// Events taken from the lane
+        uint64_t processed;
+        /// Events sent to the lane
+        uint64_t enqueued;
+        /// Events discarded by the overflow policy
+        uint64_t dropped;
+        /// Events waiting behind the lane with the spill policy
+        size_t spilled;
+        /// Events sent per second, measured over the last second
+        double enqueueRate;
+        /// Summed up time between sending and taking the events
+        std::chrono::microseconds totalWait;
+        std::chrono::microseconds maxWait;
+    };
+
+    /// What happens to events sent to a full queue
+    enum class OverflowPolicy {
+        /// The sending thread waits until the consumer made room
+        Block,
+        /// The oldest queued event is dropped
+        DropOldest,
+        /// Events of the droppable types are dropped, other events are still accepted
+        DropByClass,
+        /// Events are written to the spill file and read back in order once the lane has room.
+        /// Events without codec wait in memory between them.
+        Spill
+    };
+
+    /// Bounds the normal priority lane, high priority events are always accepted
+    struct Limits {
+        Limits();
+        /// Maximum of queued events, 0 for no limit
+        size_t capacity;
+        OverflowPolicy policy;
+        /// Event types which may be dropped with DropByClass
+        std::set<UUID> droppableEvents;
+        /// File of the spill policy, truncated whenever it was read completely
+        std::string spillFile;
+        /// Serializes spilled events, returns false for events which have to stay in memory
+        bool (*encode)(std::shared_ptr<IEvent> event, std::string& payload);
+        /// Recreates spilled events, returns nullptr on errors
+        std::shared_ptr<IEvent> (*decode)(UUID uuid, const std::string& payload);
+    };
+
+    /// One lane per EventPriority
+    static const size_t laneCount = 2;
+    /// A lower lane with events is served once after being passed over this often
+    static const size_t starvationLimit = 32;
+private:
     std::shared_ptr<EventQueue_Impl> impl;
     std::set<UUID> eventsToBeProcessed;
     std::list<bool(*)(IEvent*)> eventGuards;
@@ -35,13 +96,44 @@ public:
     /// Useful when the queue was stopped.
     void setEnabled(bool enabled);
 
+    /// Limits the amount of queued events, the queue is unbounded by default.
+    /// Blocking is skipped for events sent by the consuming thread to avoid waiting for itself.
+    void setLimits(const Limits& limits);
+
+    /// Parses the name of an overflow policy (block, drop_oldest, drop_by_class, spill)
+    ///
+    /// \returns false if the name is unknown.
+    static bool parseOverflowPolicy(const std::string& name, OverflowPolicy& policy);
+
     /// Adds some event into the queue for processing.
+    /// Applies the overflow policy if the queue is full.
     void sendEvent(std::shared_ptr<IEvent> event);
 
     /// Blocks the thread till some event is received or stop is called.
+    /// Events of higher priority lanes are returned first.
+    /// Waits until the next timer expires at most, expired timers are queued as EventTimer.
     ///
     /// \returns true if some event was retrieved and the event loop will continue.
     bool getEvent(std::shared_ptr<IEvent>& event);
+    /// Like getEvent, additionally returns when the event was queued.
+    bool getEvent(std::shared_ptr<IEvent>& event, std::chrono::steady_clock::time_point& queued);
+
+    /// Queues an EventTimer after the delay, can be called from any thread.
+    ///
+    /// \param interval Repeats the timer if positive
+    /// \returns Id of the timer, passed with the EventTimer
+    size_t addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds interval = std::chrono::milliseconds::zero());
+
+    /// Removes a pending timer. Events of already expired timers stay in the queue.
+    ///
+    /// \returns false if the timer is unknown or has already expired.
+    bool cancelTimer(size_t timerId);
+
+    /// Returns true if no events are waiting for processing.
+    bool isEmpty();
+
+    /// Returns the statistics of every lane, indexed by EventPriority.
+    std::vector<LaneStatistics> getStatistics();
 
     /// Filters events. Only if event guards of a set matches the events uuid it is added into the queue.
     ///
@@ -3,19 +3,85 @@
 
 #include <mutex>
 #include <condition_variable>
-#include <list>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <set>
 #include <memory>
+#include <vector>
+#include <thread>
 #include "event/IEvent.hpp"
+#include "EventQueue.hpp"
+#include "TimerWheel.hpp"
 
 
 class EventQueue_Impl {
 public:
+    struct QueuedEvent {
+        std::shared_ptr<IEvent> event;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    EventQueue_Impl();
+
     /// lock for the condition variable
     std::mutex queueMutex;
-    /// contains all received and accepted events
-    std::list<std::shared_ptr<IEvent>> events;
+    /// received and accepted events, one lane per EventPriority
+    std::deque<QueuedEvent> lanes[EventQueue::laneCount];
+    /// times a lane had events but a higher lane was served
+    size_t skipped[EventQueue::laneCount];
+    EventQueue::LaneStatistics statistics[EventQueue::laneCount];
+    /// start and amount of events of the running enqueue rate measurement
+    std::chrono::steady_clock::time_point rateStart[EventQueue::laneCount];
+    size_t rateCount[EventQueue::laneCount];
+    EventQueue::Limits limits;
+    /// for producers waiting for room with the block policy
+    std::condition_variable spaceCondition;
+    /// thread which called getEvent last, never blocked by the queue
+    std::thread::id consumer;
     /// for waiting till the next event if the queue is empty
     std::condition_variable eventCondition;
+    /// timers of the owning event loop, their events are added on expiry
+    TimerWheel timers;
+    /// reused for the ids of expired timers
+    std::vector<size_t> expiredTimers;
+    /// events behind the normal lane with the spill policy, in order.
+    /// Events stored in the spill file are represented by nullptr.
+    std::deque<QueuedEvent> spilled;
+    std::fstream spillFile;
+    /// positions of the next record to read and of the end of the written records
+    std::streamoff spillRead;
+    std::streamoff spillWrite;
+    /// reused for the payloads of spilled events
+    std::string spillBuffer;
+
+    /// Adds an event to the lane of its priority, requires the lock
+    void push(std::shared_ptr<IEvent> event);
+    /// Takes the next event, higher lanes first unless a lower lane starves, requires the lock
+    ///
+    /// \returns false if all lanes are empty
+    bool pop(std::shared_ptr<IEvent>& event, std::chrono::steady_clock::time_point& queued);
+    /// Returns true if all lanes are empty, requires the lock
+    bool isEmpty() const;
+    /// Returns the lane of an event
+    static size_t getLane(const IEvent* event);
+    /// Events in the lanes which are limited, requires the lock
+    size_t getBoundedDepth() const;
+    /// Drops the oldest limited event matching the filter, requires the lock
+    ///
+    /// \param droppable Only events of these types are dropped, any event if empty
+    /// \returns false if no event matched
+    bool dropOldest(const std::set<UUID>& droppable);
+    /// Updates the enqueue rate of a lane if the measurement period is over, requires the lock
+    void updateRate(size_t lane, std::chrono::steady_clock::time_point now);
+    /// Queues an event behind the spilled events, requires the lock
+    void spill(std::shared_ptr<IEvent> event);
+    /// Moves spilled events back to their lane while it has room, requires the lock
+    void unspill();
+    /// Reads the next event of the spill file, requires the lock
+    ///
+    /// \returns nullptr if the record can't be read or decoded
+    std::shared_ptr<IEvent> readSpilled();
 };
 
 #endif
@@ -0,0 +1,125 @@
+#include "TimerWheel.hpp"
+#include <algorithm>
+
+using namespace std;
+
+
+const size_t TimerWheel::levels;
+const size_t TimerWheel::slotBits;
+const size_t TimerWheel::slotsPerLevel;
+const std::chrono::milliseconds TimerWheel::tickDuration{10};
+
+TimerWheel::TimerWheel(Clock::time_point now)
+    : startTime{now}
+    , currentTick{0}
+    , lastTimerId{0}
+    , slots(levels * slotsPerLevel)
+{
+}
+
+uint64_t TimerWheel::toTick(Clock::time_point deadline) const {
+    if (deadline <= startTime) return 0;
+    auto elapsed = deadline - startTime;
+    auto ticks = elapsed / tickDuration;
+    if (startTime + ticks * tickDuration < deadline)
+        ticks += 1;
+    return static_cast<uint64_t>(ticks);
+}
+
+void TimerWheel::insert(size_t timerId, Timer& timer, uint64_t firstTick) {
+    const uint64_t range = uint64_t(1) << (slotBits * levels);
+    uint64_t due = max(timer.dueTick, firstTick);
+    // timers out of range wait in the last slot of the top level
+    if (due - currentTick >= range)
+        due = currentTick + range - 1;
+
+    uint64_t delta = due - currentTick;
+    size_t level = 0;
+    while (level + 1 < levels && delta >= (uint64_t(1) << (slotBits * (level + 1))))
+        ++level;
+
+    size_t index = (due >> (slotBits * level)) & (slotsPerLevel - 1);
+    auto& slot = slots[level * slotsPerLevel + index];
+    timer.slot = &slot;
+    timer.position = slot.insert(slot.end(), timerId);
+}
+
+void TimerWheel::cascade(size_t level) {
+    size_t index = (currentTick >> (slotBits * level)) & (slotsPerLevel - 1);
+    list<size_t> pending;
+    pending.swap(slots[level * slotsPerLevel + index]);
+    // the current tick is not processed yet, timers due now still expire in this step
+    for (size_t timerId : pending)
+        insert(timerId, timers.at(timerId), currentTick);
+}
+
+void TimerWheel::step(std::vector<size_t>& expired) {
+    currentTick += 1;
+    // higher levels are cascaded whenever the lower level wrapped around
+    for (size_t level = 1; level < levels; ++level) {
+        if ((currentTick & ((uint64_t(1) << (slotBits * level)) - 1)) != 0) break;
+        cascade(level);
+    }
+
+    list<size_t> due;
+    due.swap(slots[currentTick & (slotsPerLevel - 1)]);
+    for (size_t timerId : due) {
+        auto it = timers.find(timerId);
+        Timer& timer = it->second;
+        expired.push_back(timerId);
+        if (timer.intervalTicks == 0) {
+            timers.erase(it);
+        } else {
+            // missed runs are skipped instead of fired at once
+            timer.dueTick = max(timer.dueTick + timer.intervalTicks, currentTick + 1);
+            insert(timerId, timer, currentTick + 1);
+        }
+    }
+}
+
+size_t TimerWheel::add(Clock::time_point deadline, Clock::duration interval) {
+    size_t timerId = ++lastTimerId;
+    Timer& timer = timers[timerId];
+    timer.dueTick = toTick(deadline);
+    timer.intervalTicks = 0;
+    if (interval > Clock::duration::zero()) {
+        auto intervalTicks = interval / tickDuration;
+        timer.intervalTicks = max<uint64_t>(1, static_cast<uint64_t>(intervalTicks));
+    }
+    insert(timerId, timer, currentTick + 1);
+    return timerId;
+}
+
+bool TimerWheel::cancel(size_t timerId) {
+    auto it = timers.find(timerId);
+    if (it == timers.end()) return false;
+    it->second.slot->erase(it->second.position);
+    timers.erase(it);
+    return true;
+}
+
+bool TimerWheel::isEmpty() const {
+    return timers.empty();
+}
+
+void TimerWheel::advance(Clock::time_point now, std::vector<size_t>& expired) {
+    uint64_t target = now <= startTime ? 0 : static_cast<uint64_t>((now - startTime) / tickDuration);
+    if (timers.empty()) {
+        // nothing to expire, skip idle ticks at once
+        currentTick = max(currentTick, target);
+        return;
+    }
+    while (currentTick < target && !timers.empty())
+        step(expired);
+    currentTick = max(currentTick, target);
+}
+
+TimerWheel::Clock::time_point TimerWheel::getNextDeadline() const {
+    if (timers.empty()) return Clock::time_point::max();
+    // level 0 covers the next 64 ticks, the wrap around cascades the next level
+    for (uint64_t tick = currentTick + 1; ; ++tick) {
+        size_t index = tick & (slotsPerLevel - 1);
+        if (index == 0 || !slots[index].empty())
+            return startTime + tickDuration * static_cast<int64_t>(tick);
+    }
+}
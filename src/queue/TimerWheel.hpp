@@ -0,0 +1,72 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+
+/// Hierarchical timer wheel with a resolution of 10ms.
+/// Four levels of 64 slots cover about 46 hours, later timers are cascaded down once in range.
+/// Adding, cancelling and expiring a timer is O(1), the wheel is not thread safe.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+private:
+    static const size_t levels = 4;
+    static const size_t slotBits = 6;
+    static const size_t slotsPerLevel = 1 << slotBits;
+    static const std::chrono::milliseconds tickDuration;
+
+    struct Timer {
+        uint64_t dueTick;
+        /// Ticks between runs, 0 for one-shot timers
+        uint64_t intervalTicks;
+        std::list<size_t>* slot;
+        std::list<size_t>::iterator position;
+    };
+
+    Clock::time_point startTime;
+    /// Last processed tick
+    uint64_t currentTick;
+    size_t lastTimerId;
+    std::unordered_map<size_t, Timer> timers;
+    /// Timer ids, levels * slotsPerLevel lists
+    std::vector<std::list<size_t>> slots;
+
+    /// Converts a deadline to the first tick not before it
+    uint64_t toTick(Clock::time_point deadline) const;
+    /// Puts a timer into the slot matching its distance to the current tick
+    ///
+    /// \param firstTick Earlier due ticks are moved to this tick
+    void insert(size_t timerId, Timer& timer, uint64_t firstTick);
+    /// Moves the timers of the current slot of a level to the lower levels
+    void cascade(size_t level);
+    /// Processes the next tick
+    void step(std::vector<size_t>& expired);
+public:
+    explicit TimerWheel(Clock::time_point now = Clock::now());
+
+    /// Adds a timer
+    ///
+    /// \param interval Runs the timer periodically after the first deadline if positive
+    /// \returns Id of the timer, never 0
+    size_t add(Clock::time_point deadline, Clock::duration interval = Clock::duration::zero());
+    /// Removes a timer
+    ///
+    /// \returns False if the timer is unknown or a one-shot timer already expired
+    bool cancel(size_t timerId);
+    /// Returns true if no timers are pending
+    bool isEmpty() const;
+    /// Processes all ticks until now
+    ///
+    /// \param expired Receives the ids of due timers in the order of their deadlines
+    void advance(Clock::time_point now, std::vector<size_t>& expired);
+    /// Time until advance has to be called again, max() without timers.
+    /// May be earlier than the next deadline when far timers have to be cascaded.
+    Clock::time_point getNextDeadline() const;
+};
+
+#endif
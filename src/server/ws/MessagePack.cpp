@@ -0,0 +1,247 @@
+#include "MessagePack.hpp"
+#include <cstring>
+
+using namespace std;
+
+
+/// Maximum nesting of arrays and maps accepted from clients
+static const int maxDepth = 32;
+
+static void writeBigEndian(string& result, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i)
+        result += static_cast<char>((value >> (i * 8)) & 0xff);
+}
+
+static void writeHeader(string& result, uint64_t length, uint8_t fix, uint8_t type16) {
+    // the 32 bit type always follows the 16 bit one
+    if (length < 16) {
+        result += static_cast<char>(fix | length);
+    } else if (length <= 0xffff) {
+        result += static_cast<char>(type16);
+        writeBigEndian(result, length, 2);
+    } else {
+        result += static_cast<char>(type16 + 1);
+        writeBigEndian(result, length, 4);
+    }
+}
+
+static void writeValue(string& result, const Json::Value& value) {
+    switch (value.type()) {
+    case Json::nullValue:
+        result += '\xc0';
+        break;
+    case Json::booleanValue:
+        result += value.asBool() ? '\xc3' : '\xc2';
+        break;
+    case Json::uintValue: {
+        uint64_t number = value.asLargestUInt();
+        if (number < 0x80) {
+            result += static_cast<char>(number);
+        } else if (number <= 0xff) {
+            result += '\xcc';
+            writeBigEndian(result, number, 1);
+        } else if (number <= 0xffff) {
+            result += '\xcd';
+            writeBigEndian(result, number, 2);
+        } else if (number <= 0xffffffff) {
+            result += '\xce';
+            writeBigEndian(result, number, 4);
+        } else {
+            result += '\xcf';
+            writeBigEndian(result, number, 8);
+        }
+        break;
+    }
+    case Json::intValue: {
+        int64_t number = value.asLargestInt();
+        if (number >= 0) {
+            writeValue(result, Json::Value(static_cast<Json::LargestUInt>(number)));
+        } else if (number >= -32) {
+            result += static_cast<char>(number);
+        } else if (number >= INT8_MIN) {
+            result += '\xd0';
+            writeBigEndian(result, static_cast<uint64_t>(number), 1);
+        } else if (number >= INT16_MIN) {
+            result += '\xd1';
+            writeBigEndian(result, static_cast<uint64_t>(number), 2);
+        } else if (number >= INT32_MIN) {
+            result += '\xd2';
+            writeBigEndian(result, static_cast<uint64_t>(number), 4);
+        } else {
+            result += '\xd3';
+            writeBigEndian(result, static_cast<uint64_t>(number), 8);
+        }
+        break;
+    }
+    case Json::realValue: {
+        double number = value.asDouble();
+        uint64_t bits;
+        memcpy(&bits, &number, sizeof(bits));
+        result += '\xcb';
+        writeBigEndian(result, bits, 8);
+        break;
+    }
+    case Json::stringValue: {
+        const char* begin;
+        const char* end;
+        value.getString(&begin, &end);
+        size_t length = end - begin;
+        if (length < 32) {
+            result += static_cast<char>(0xa0 | length);
+        } else if (length <= 0xff) {
+            result += '\xd9';
+            writeBigEndian(result, length, 1);
+        } else if (length <= 0xffff) {
+            result += '\xda';
+            writeBigEndian(result, length, 2);
+        } else {
+            result += '\xdb';
+            writeBigEndian(result, length, 4);
+        }
+        result.append(begin, length);
+        break;
+    }
+    case Json::arrayValue:
+        writeHeader(result, value.size(), 0x90, 0xdc);
+        for (auto& element : value)
+            writeValue(result, element);
+        break;
+    case Json::objectValue:
+        writeHeader(result, value.size(), 0x80, 0xde);
+        for (auto it = value.begin(); it != value.end(); ++it) {
+            writeValue(result, Json::Value(it.name()));
+            writeValue(result, *it);
+        }
+        break;
+    }
+}
+
+std::string MessagePack::write(const Json::Value& root) {
+    string result;
+    writeValue(result, root);
+    return result;
+}
+
+std::string MessagePack::writeArrayHeader(size_t length) {
+    string result;
+    writeHeader(result, length, 0x90, 0xdc);
+    return result;
+}
+
+
+namespace {
+    /// Bounds checked cursor over the input buffer
+    struct Reader {
+        const uint8_t* data;
+        const uint8_t* end;
+
+        bool readBigEndian(uint64_t& value, int bytes) {
+            if (end - data < bytes) return false;
+            value = 0;
+            for (int i = 0; i < bytes; ++i)
+                value = (value << 8) | *data++;
+            return true;
+        }
+
+        bool readString(Json::Value& value, uint64_t length) {
+            if (static_cast<uint64_t>(end - data) < length) return false;
+            value = Json::Value(reinterpret_cast<const char*>(data),
+                                reinterpret_cast<const char*>(data + length));
+            data += length;
+            return true;
+        }
+
+        bool readArray(Json::Value& value, uint64_t length, int depth) {
+            value = Json::Value(Json::arrayValue);
+            // every element needs at least one byte
+            if (static_cast<uint64_t>(end - data) < length) return false;
+            for (uint64_t i = 0; i < length; ++i)
+                if (!readValue(value[static_cast<Json::ArrayIndex>(i)], depth + 1)) return false;
+            return true;
+        }
+
+        bool readMap(Json::Value& value, uint64_t length, int depth) {
+            value = Json::Value(Json::objectValue);
+            if (static_cast<uint64_t>(end - data) / 2 < length) return false;
+            for (uint64_t i = 0; i < length; ++i) {
+                Json::Value key;
+                if (!readValue(key, depth + 1) || !key.isString()) return false;
+                if (!readValue(value[key.asString()], depth + 1)) return false;
+            }
+            return true;
+        }
+
+        bool readValue(Json::Value& value, int depth) {
+            if (depth > maxDepth || data == end) return false;
+            uint8_t type = *data++;
+            uint64_t number;
+
+            if (type < 0x80) {
+                value = Json::Value(static_cast<Json::LargestUInt>(type));
+                return true;
+            } else if (type >= 0xe0) {
+                value = Json::Value(static_cast<Json::LargestInt>(static_cast<int8_t>(type)));
+                return true;
+            } else if ((type & 0xf0) == 0x80) {
+                return readMap(value, type & 0x0f, depth);
+            } else if ((type & 0xf0) == 0x90) {
+                return readArray(value, type & 0x0f, depth);
+            } else if ((type & 0xe0) == 0xa0) {
+                return readString(value, type & 0x1f);
+            }
+
+            switch (type) {
+            case 0xc0:
+                value = Json::Value(Json::nullValue);
+                return true;
+            case 0xc2:
+            case 0xc3:
+                value = Json::Value(type == 0xc3);
+                return true;
+            case 0xc4: case 0xc5: case 0xc6: // bin is treated as string
+                return readBigEndian(number, 1 << (type - 0xc4)) && readString(value, number);
+            case 0xca: {
+                float real;
+                if (!readBigEndian(number, 4)) return false;
+                uint32_t bits = static_cast<uint32_t>(number);
+                memcpy(&real, &bits, sizeof(real));
+                value = Json::Value(static_cast<double>(real));
+                return true;
+            }
+            case 0xcb: {
+                double real;
+                if (!readBigEndian(number, 8)) return false;
+                memcpy(&real, &number, sizeof(real));
+                value = Json::Value(real);
+                return true;
+            }
+            case 0xcc: case 0xcd: case 0xce: case 0xcf:
+                if (!readBigEndian(number, 1 << (type - 0xcc))) return false;
+                value = Json::Value(static_cast<Json::LargestUInt>(number));
+                return true;
+            case 0xd0: case 0xd1: case 0xd2: case 0xd3: {
+                int bytes = 1 << (type - 0xd0);
+                if (!readBigEndian(number, bytes)) return false;
+                // sign extension of the shorter types
+                int shift = 64 - bytes * 8;
+                int64_t signedNumber = static_cast<int64_t>(number << shift) >> shift;
+                value = Json::Value(static_cast<Json::LargestInt>(signedNumber));
+                return true;
+            }
+            case 0xd9: case 0xda: case 0xdb:
+                return readBigEndian(number, 1 << (type - 0xd9)) && readString(value, number);
+            case 0xdc: case 0xdd:
+                return readBigEndian(number, 2 << (type - 0xdc)) && readArray(value, number, depth);
+            case 0xde: case 0xdf:
+                return readBigEndian(number, 2 << (type - 0xde)) && readMap(value, number, depth);
+            default: // extension types are not supported
+                return false;
+            }
+        }
+    };
+}
+
+bool MessagePack::read(const uint8_t* data, size_t length, Json::Value& root) {
+    Reader reader{data, data + length};
+    return reader.readValue(root, 0) && reader.data == reader.end;
+}
@@ -0,0 +1,21 @@
+#ifndef MESSAGEPACK_H
+#define MESSAGEPACK_H
+
+#include <string>
+#include <cstdint>
+#include <json/json.h>
+
+
+/// Converts json documents to MessagePack and back.
+/// Only types which can be represented by Json::Value are supported.
+class MessagePack {
+public:
+    /// Serializes the document as MessagePack
+    static std::string write(const Json::Value& root);
+    /// Returns the header of an array, to be followed by the serialized elements
+    static std::string writeArrayHeader(size_t length);
+    /// Parses a single MessagePack document and returns if it was valid
+    static bool read(const uint8_t* data, size_t length, Json::Value& root);
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include "MetricsPageHandler.hpp"
+#include <seasocks/Request.h>
+#include <seasocks/ResponseBuilder.h>
+#include "utils/Metrics.hpp"
+
+using namespace std;
+
+
+std::shared_ptr<seasocks::Response> MetricsPageHandler::handle(const seasocks::Request& request) {
+    if (request.getRequestUri() != "/metrics")
+        return seasocks::Response::unhandled();
+    seasocks::ResponseBuilder builder;
+    builder.withContentType("text/plain; version=0.0.4");
+    builder.withHeader("Cache-Control", "no-store");
+    builder << MetricsRegistry::getInstance().render();
+    return builder.build();
+}
@@ -0,0 +1,13 @@
+#ifndef METRICSPAGEHANDLER_H
+#define METRICSPAGEHANDLER_H
+
+#include <seasocks/PageHandler.h>
+
+
+/// Serves the metrics registry in the Prometheus text format on /metrics
+class MetricsPageHandler : public seasocks::PageHandler {
+public:
+    virtual std::shared_ptr<seasocks::Response> handle(const seasocks::Request& request) override;
+};
+
+#endif
@@ -0,0 +1,170 @@
+#include "WebsocketDeflate.hpp"
+#include <chrono>
+#include <sstream>
+#include <set>
+#include <stdexcept>
+
+using namespace std;
+
+
+WebsocketDeflate::Settings::Settings()
+    : enabled{true}
+    , level{Z_DEFAULT_COMPRESSION}
+    , memLevel{8}
+    , maxWindowBits{15}
+    , contextTakeover{true}
+    , threshold{256}
+{
+}
+
+WebsocketDeflate::Statistics::Statistics()
+    : messages{0}
+    , compressedMessages{0}
+    , bytesIn{0}
+    , bytesOut{0}
+    , nanoseconds{0}
+{
+}
+
+WebsocketDeflate::WebsocketDeflate(const Settings& settings,
+                                   int windowBits,
+                                   bool contextTakeover,
+                                   Statistics* statistics,
+                                   bool compressAll)
+    : stream{}
+    , threshold{compressAll ? 0 : settings.threshold}
+    , contextTakeover{contextTakeover}
+    , compressAll{compressAll}
+    , statistics{statistics}
+{
+    // negative window bits: raw deflate without zlib header (RFC 7692 7.2.1)
+    if (deflateInit2(&stream,
+                     settings.level,
+                     Z_DEFLATED,
+                     -windowBits,
+                     settings.memLevel,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+        throw runtime_error("Could not initialize deflate stream");
+}
+
+WebsocketDeflate::~WebsocketDeflate() {
+    deflateEnd(&stream);
+}
+
+bool WebsocketDeflate::compress(const std::string& message, std::string& result) {
+    ++statistics->messages;
+    if (message.size() < threshold) return false;
+
+    auto start = chrono::steady_clock::now();
+
+    size_t used = 0;
+    result.resize(message.size() / 2 + 64);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(message.data()));
+    stream.avail_in = message.size();
+
+    int status;
+    do {
+        if (used == result.size())
+            result.resize(result.size() * 2);
+        stream.next_out = reinterpret_cast<Bytef*>(&result[used]);
+        stream.avail_out = result.size() - used;
+        status = deflate(&stream, Z_SYNC_FLUSH);
+        used = result.size() - stream.avail_out;
+    } while (status == Z_OK && stream.avail_out == 0);
+
+    if (status != Z_OK && status != Z_BUF_ERROR) {
+        // the client never sees this message compressed, so the state can be dropped
+        deflateReset(&stream);
+        return false;
+    }
+
+    // remove the empty block of the sync flush (RFC 7692 7.2.1)
+    if (used >= 4
+        && result[used-4] == '\x00'
+        && result[used-3] == '\x00'
+        && result[used-2] == '\xff'
+        && result[used-1] == '\xff')
+        used -= 4;
+    result.resize(used);
+
+    if (!contextTakeover)
+        deflateReset(&stream);
+
+    statistics->nanoseconds += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+
+    // with context takeover the client needs every message to keep its window in sync
+    if (!contextTakeover && !compressAll && used >= message.size())
+        return false;
+
+    ++statistics->compressedMessages;
+    statistics->bytesIn += message.size();
+    statistics->bytesOut += used;
+    return true;
+}
+
+bool WebsocketDeflate::negotiate(const std::string& offer,
+                                 const Settings& settings,
+                                 std::string& response,
+                                 int& windowBits,
+                                 bool& contextTakeover) {
+    if (!settings.enabled) return false;
+
+    // each offer is separated by ',' and its parameters by ';'
+    istringstream offers(offer);
+    string extension;
+    while (getline(offers, extension, ',')) {
+        istringstream parameters(extension);
+        string parameter;
+        bool first = true;
+        bool accepted = true;
+        bool requestedWindowBits = false;
+        set<string> seen;
+
+        windowBits = settings.maxWindowBits;
+        contextTakeover = settings.contextTakeover;
+
+        while (accepted && getline(parameters, parameter, ';')) {
+            size_t begin = parameter.find_first_not_of(" \t");
+            size_t end = parameter.find_last_not_of(" \t");
+            parameter = begin == string::npos ? "" : parameter.substr(begin, end - begin + 1);
+
+            if (first) {
+                accepted = parameter == "permessage-deflate";
+                first = false;
+                continue;
+            }
+
+            string name = parameter.substr(0, parameter.find('='));
+            string value = name.size() < parameter.size() ? parameter.substr(name.size() + 1) : "";
+            if (!seen.insert(name).second) {
+                accepted = false; // duplicate parameters invalidate the offer
+            } else if (name == "server_no_context_takeover") {
+                contextTakeover = false;
+            } else if (name == "server_max_window_bits") {
+                int bits = 0;
+                istringstream(value) >> bits;
+                // zlib does not support raw deflate with a 256 byte window
+                if (bits < 9 || bits > 15)
+                    accepted = false;
+                else if (bits < windowBits)
+                    windowBits = bits;
+                requestedWindowBits = true;
+            } else if (name == "client_no_context_takeover"
+                       || name == "client_max_window_bits") {
+                // clients send uncompressed data only
+            } else {
+                accepted = false;
+            }
+        }
+
+        if (!accepted || first) continue;
+
+        response = "permessage-deflate";
+        if (!contextTakeover)
+            response += "; server_no_context_takeover";
+        if (requestedWindowBits || windowBits < 15)
+            response += "; server_max_window_bits=" + to_string(windowBits);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,96 @@
+#ifndef WEBSOCKETDEFLATE_H
+#define WEBSOCKETDEFLATE_H
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <zlib.h>
+
+
+/// Message compression for a single client as described in RFC 7692 (permessage-deflate).
+/// Seasocks neither exposes the extension handshake nor the RSV1 bit, so the
+/// negotiation happens inside the protocol and compressed messages are sent as
+/// binary frames while uncompressed messages are sent as text frames.
+class WebsocketDeflate {
+public:
+    /// Server side configuration, read from config/websocket.ini
+    struct Settings {
+        Settings();
+        /// Accept compression offers of clients
+        bool enabled;
+        /// zlib compression level (1-9)
+        int level;
+        /// zlib memory level (1-9)
+        int memLevel;
+        /// Largest LZ77 window the server will use (9-15)
+        int maxWindowBits;
+        /// Keep the compression context between messages
+        bool contextTakeover;
+        /// Messages smaller than this amount of bytes are sent uncompressed
+        size_t threshold;
+    };
+
+    /// Collected data of all clients for monitoring purposes
+    struct Statistics {
+        Statistics();
+        /// Messages which were passed to compress
+        std::atomic<uint64_t> messages;
+        /// Messages which were sent compressed
+        std::atomic<uint64_t> compressedMessages;
+        /// Uncompressed size of all compressed messages
+        std::atomic<uint64_t> bytesIn;
+        /// Compressed size of all compressed messages
+        std::atomic<uint64_t> bytesOut;
+        /// Time spent inside zlib
+        std::atomic<uint64_t> nanoseconds;
+    };
+
+private:
+    z_stream stream;
+    size_t threshold;
+    bool contextTakeover;
+    bool compressAll;
+    Statistics* statistics;
+
+public:
+    /// Constructor
+    ///
+    /// \param settings Server configuration
+    /// \param windowBits The negotiated window size
+    /// \param contextTakeover False if the client requested server_no_context_takeover
+    /// \param statistics Shared statistics which are updated on every message
+    /// \param compressAll Compress every message, needed if uncompressed messages can't be told apart
+    WebsocketDeflate(const Settings& settings,
+                     int windowBits,
+                     bool contextTakeover,
+                     Statistics* statistics,
+                     bool compressAll = false);
+    /// Destructor
+    ~WebsocketDeflate();
+
+    WebsocketDeflate(const WebsocketDeflate&) = delete;
+    WebsocketDeflate& operator=(const WebsocketDeflate&) = delete;
+
+    /// Compresses a single message
+    ///
+    /// \param message The uncompressed message
+    /// \param result Receives the compressed payload without the trailing 0x00 0x00 0xff 0xff
+    /// \returns false if the message should be sent uncompressed
+    bool compress(const std::string& message, std::string& result);
+
+    /// Evaluates the extension offer of a client
+    ///
+    /// \param offer The offered extensions, e.g. "permessage-deflate; server_max_window_bits=10"
+    /// \param settings Server configuration
+    /// \param response Receives the accepted extension parameters
+    /// \param windowBits Receives the window size to use for compression
+    /// \param contextTakeover Receives if the compression context is kept between messages
+    /// \returns true if permessage-deflate was accepted
+    static bool negotiate(const std::string& offer,
+                          const Settings& settings,
+                          std::string& response,
+                          int& windowBits,
+                          bool& contextTakeover);
+};
+
+#endif
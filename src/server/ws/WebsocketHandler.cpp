@@ -1,6 +1,7 @@
 #include "WebsocketServer.hpp"
 #include "event/EventLogin.hpp"
 #include "event/EventLogout.hpp"
+#include "event/EventClientOption.hpp"
 #include "event/EventQuery.hpp"
 #include "event/EventQueryType.hpp"
 #include "event/irc/EventIrcMessageType.hpp"
@@ -16,6 +17,11 @@
 #include "event/irc/EventIrcUserStatusRequest.hpp"
 #include "event/irc/EventIrcChangeNick.hpp"
 #include "event/irc/EventIrcRequestBacklog.hpp"
+#include "event/irc/EventIrcRequestUserlist.hpp"
+#include "MessagePack.hpp"
+#include "utils/Logger.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <sstream>
 #include <json/json.h>
@@ -23,20 +29,41 @@
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("websocket");
+
+
 WebsocketHandler::WebsocketHandler(EventQueue* appQueue,
                                    EventQueue* queue,
                                    const std::unordered_map<seasocks::WebSocket*, std::list<WebsocketClientData>::iterator>& clients)
     : appQueue{appQueue}
     , queue{queue}
     , clients{clients}
+    , lastConnectionId{0}
 {
 }
 
 WebsocketHandler::~WebsocketHandler() {
 }
 
+bool WebsocketHandler::withConnection(void* loginData,
+                                      const std::function<void(seasocks::WebSocket*, std::shared_ptr<WebsocketOutboundQueue>&)>& function) {
+    lock_guard<mutex> lock(connectionMutex);
+    auto it = connections.find(reinterpret_cast<uintptr_t>(loginData));
+    if (it == connections.end()) return false;
+    function(it->second, sockets.at(it->second).outbound);
+    return true;
+}
+
+void* WebsocketHandler::getLoginData(seasocks::WebSocket* connection) {
+    lock_guard<mutex> lock(connectionMutex);
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(sockets.at(connection).id));
+}
+
 void WebsocketHandler::onConnect(seasocks::WebSocket* connection) {
-    // no action required
+    lock_guard<mutex> lock(connectionMutex);
+    size_t connectionId = ++lastConnectionId;
+    connections.emplace(connectionId, connection);
+    sockets.emplace(connection, Connection{connectionId, nullptr});
 }
 
 void WebsocketHandler::onData(seasocks::WebSocket* connection, const char* cdata) {
@@ -57,157 +84,221 @@ void WebsocketHandler::onData(seasocks::WebSocket* connection, const char* cdata
                 getline(lis, username, ' ');
                 string password;
                 getline(lis, password, ' ');
-                appQueue->sendEvent(make_shared<EventLogin>(connection, username, password));
+                appQueue->sendEvent(make_shared<EventLogin>(getLoginData(connection), username, password));
+            } else if (cmd == "TOKEN") {
+                // session token of a previous login, verified without hashing
+                string token;
+                getline(lis, token, ' ');
+                queue->sendEvent(make_shared<EventClientOption>(getLoginData(connection), "token", token));
+            } else if (cmd == "EXTENSIONS") {
+                // same syntax as the Sec-WebSocket-Extensions header
+                string extensions;
+                getline(lis, extensions);
+                queue->sendEvent(make_shared<EventClientOption>(connection, "extensions", extensions));
+            } else if (cmd == "ENCODING") {
+                string encoding;
+                getline(lis, encoding, ' ');
+                queue->sendEvent(make_shared<EventClientOption>(connection, "encoding", encoding));
+            } else if (cmd == "COALESCE") {
+                // window in milliseconds
+                string window;
+                getline(lis, window, ' ');
+                queue->sendEvent(make_shared<EventClientOption>(connection, "coalesce", window));
+            } else if (cmd == "RESUME") {
+                // epoch and sequence number of the last received message
+                string resume;
+                getline(lis, resume);
+                queue->sendEvent(make_shared<EventClientOption>(connection, "resume", resume));
+            } else if (cmd == "USERLIST") {
+                // "lazy" to receive only the amount of users in chat listings
+                string mode;
+                getline(lis, mode, ' ');
+                queue->sendEvent(make_shared<EventClientOption>(connection, "userlist", mode));
             }
         }
     } else { // logged in
-        WebsocketClientData& clientData = *(it->second);
         Json::Value root;
         Json::Reader reader;
-        cout << "Parsing: " << data << endl;
+        LOG_TRACE(logModule) << "received command" << logField("user", it->second->userId) << logField("data", data);
         if (!reader.parse(data, root)) return;
+        onCommand(connection, *(it->second), root);
+    }
+}
 
-        try {
-            string cmd = root.get("cmd", "").asString();
-            string protocol = root.get("protocol", "").asString();
-            if (protocol == "") {
-                if (cmd == "querysettings") {
-                    appQueue->sendEvent(make_shared<EventQuery>(clientData.userId, connection, EventQueryType::Settings));
-                }
-            } else if (protocol == "irc") {
-                if (cmd == "chat") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    string channel = root.get("channel", "").asString();
-                    string message = root.get("msg", "").asString();
-                    appQueue->sendEvent(make_shared<EventIrcSendMessage>(clientData.userId, serverId, channel, message, IrcMessageType::Message));
-                } else if (cmd == "requestbacklog") {
-                    size_t serverId, fromId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    string channel = root.get("channel", "").asString();
-                    istringstream(root.get("from", std::to_string(std::numeric_limits<size_t>::max())).asString()) >> fromId;
-                    int count = root.get("count", 100).asInt();
-                    appQueue->sendEvent(make_shared<EventIrcRequestBacklog>(clientData.userId, serverId, channel, fromId, count));
-                } else if (cmd == "action") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    string channel = root.get("channel", "").asString();
-                    string message = root.get("msg", "").asString();
-                    appQueue->sendEvent(make_shared<EventIrcSendAction>(clientData.userId, serverId, channel, message));
-                } else if (cmd == "join") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    string channel = root.get("channel", "").asString();
-                    string password = root.get("password", "").asString();
-                    auto statusRequest = make_shared<EventIrcUserStatusRequest>(EventIrcUserStatusRequest::Status::Join,
-                                                                                clientData.userId,
-                                                                                serverId,
-                                                                                channel,
-                                                                                password);
-                    appQueue->sendEvent(statusRequest);
-                } else if (cmd == "part") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    string channel = root.get("channel", "").asString();
-                    auto statusRequest = make_shared<EventIrcUserStatusRequest>(EventIrcUserStatusRequest::Status::Part,
-                                                                                clientData.userId,
-                                                                                serverId,
-                                                                                channel);
-                    appQueue->sendEvent(statusRequest);
-                } else if (cmd == "nick") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    string nick = root.get("nick", "").asString();
-                    appQueue->sendEvent(make_shared<EventIrcChangeNick>(clientData.userId, serverId, nick));
-                } else if (cmd == "addserver") {
-                    string name = root.get("name", "").asString();
-                    appQueue->sendEvent(make_shared<EventIrcAddServer>(clientData.userId, name));
-                } else if (cmd == "deleteserver") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    if (serverId != 0)
-                        appQueue->sendEvent(make_shared<EventIrcDeleteServer>(clientData.userId, serverId));
-                } else if (cmd == "deletechannel") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    string channel = root.get("channel", "").asString();
-                    if (serverId != 0 && channel != "")
-                        appQueue->sendEvent(make_shared<EventIrcDeleteChannel>(clientData.userId, serverId, channel));
-                } else if (cmd == "addhost") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    string host = root.get("host", "").asString();
-                    string password = root.get("password", "").asString();
-                    int port = root.get("port", -1).asInt();
-                    bool ipV6 = root.get("ipv6", true).asBool();
-                    bool ssl = root.get("ssl", true).asBool();
-
-                    appQueue->sendEvent(make_shared<EventIrcAddHost>(clientData.userId,
-                                                                     serverId,
-                                                                     host,
-                                                                     port,
-                                                                     password,
-                                                                     ipV6,
-                                                                     ssl));
-                } else if (cmd == "modifyhost") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    string oldHost = root.get("oldhost", "").asString();
-                    int oldPort = root.get("oldport", -1).asInt();
-                    string host = root.get("host", "").asString();
-                    string password = root.get("password", "").asString();
-                    int port = root.get("port", -1).asInt();
-                    bool ipV6 = root.get("ipv6", true).asBool();
-                    bool ssl = root.get("ssl", true).asBool();
-
-                    appQueue->sendEvent(make_shared<EventIrcDeleteHost>(clientData.userId,
-                                                                        serverId,
-                                                                        oldHost,
-                                                                        oldPort));
-
-                    appQueue->sendEvent(make_shared<EventIrcAddHost>(clientData.userId,
-                                                                     serverId,
-                                                                     host,
-                                                                     port,
-                                                                     password,
-                                                                     ipV6,
-                                                                     ssl));
-                } else if (cmd == "modifynick") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    string oldNick = root.get("oldnick", "").asString();
-                    string newNick = root.get("newnick", "").asString();
-
-                    appQueue->sendEvent(make_shared<EventIrcModifyNick>(clientData.userId,
-                                                                        serverId,
-                                                                        oldNick,
-                                                                        newNick));
-                } else if (cmd == "reconnect") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-
-                    appQueue->sendEvent(make_shared<EventIrcReconnectServer>(clientData.userId,
-                                                                             serverId));
-                } else if (cmd == "deletehost") {
-                    size_t serverId;
-                    istringstream(root.get("server", "0").asString()) >> serverId;
-                    string host = root.get("host", "").asString();
-                    int port = root.get("port", -1).asInt();
-
-                    appQueue->sendEvent(make_shared<EventIrcDeleteHost>(clientData.userId,
-                                                                        serverId,
-                                                                        host,
-                                                                        port));
-                }
+void WebsocketHandler::onData(seasocks::WebSocket* connection, const uint8_t* data, size_t length) {
+    // binary messages are only accepted from logged in clients
+    auto it = clients.find(connection);
+    if (it == clients.end()) return;
+
+    Json::Value root;
+    if (!MessagePack::read(data, length, root)) return;
+    onCommand(connection, *(it->second), root);
+}
+
+void WebsocketHandler::onCommand(seasocks::WebSocket* connection, WebsocketClientData& clientData, const Json::Value& root) {
+    try {
+        string cmd = root.get("cmd", "").asString();
+        string protocol = root.get("protocol", "").asString();
+        if (protocol == "") {
+            if (cmd == "querysettings") {
+                appQueue->sendEvent(make_shared<EventQuery>(clientData.userId, connection, EventQueryType::Settings));
+            } else if (cmd == "revokesession") {
+                string token = root.get("token", "").asString();
+                queue->sendEvent(make_shared<EventClientOption>(connection, "revoke", token));
+            } else if (cmd == "revokesessions") {
+                queue->sendEvent(make_shared<EventClientOption>(connection, "revoke_all", ""));
+            }
+        } else if (protocol == "irc") {
+            if (cmd == "chat") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string channel = root.get("channel", "").asString();
+                string message = root.get("msg", "").asString();
+                appQueue->sendEvent(make_shared<EventIrcSendMessage>(clientData.userId, serverId, channel, message, IrcMessageType::Message));
+            } else if (cmd == "requestbacklog") {
+                size_t serverId, fromId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string channel = root.get("channel", "").asString();
+                istringstream(root.get("from", std::to_string(std::numeric_limits<size_t>::max())).asString()) >> fromId;
+                int count = root.get("count", 100).asInt();
+                appQueue->sendEvent(make_shared<EventIrcRequestBacklog>(clientData.userId, serverId, channel, fromId, count));
+            } else if (cmd == "requestuserlist") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string channel = root.get("channel", "").asString();
+                string after = root.get("after", "").asString();
+                int count = root.get("count", 100).asInt();
+                if (count > 0)
+                    appQueue->sendEvent(make_shared<EventIrcRequestUserlist>(clientData.userId, serverId, channel, after, min(count, 1000), connection));
+            } else if (cmd == "action") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string channel = root.get("channel", "").asString();
+                string message = root.get("msg", "").asString();
+                appQueue->sendEvent(make_shared<EventIrcSendAction>(clientData.userId, serverId, channel, message));
+            } else if (cmd == "join") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string channel = root.get("channel", "").asString();
+                string password = root.get("password", "").asString();
+                auto statusRequest = make_shared<EventIrcUserStatusRequest>(EventIrcUserStatusRequest::Status::Join,
+                                                                            clientData.userId,
+                                                                            serverId,
+                                                                            channel,
+                                                                            password);
+                appQueue->sendEvent(statusRequest);
+            } else if (cmd == "part") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string channel = root.get("channel", "").asString();
+                auto statusRequest = make_shared<EventIrcUserStatusRequest>(EventIrcUserStatusRequest::Status::Part,
+                                                                            clientData.userId,
+                                                                            serverId,
+                                                                            channel);
+                appQueue->sendEvent(statusRequest);
+            } else if (cmd == "nick") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string nick = root.get("nick", "").asString();
+                appQueue->sendEvent(make_shared<EventIrcChangeNick>(clientData.userId, serverId, nick));
+            } else if (cmd == "addserver") {
+                string name = root.get("name", "").asString();
+                appQueue->sendEvent(make_shared<EventIrcAddServer>(clientData.userId, name));
+            } else if (cmd == "deleteserver") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                if (serverId != 0)
+                    appQueue->sendEvent(make_shared<EventIrcDeleteServer>(clientData.userId, serverId));
+            } else if (cmd == "deletechannel") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string channel = root.get("channel", "").asString();
+                if (serverId != 0 && channel != "")
+                    appQueue->sendEvent(make_shared<EventIrcDeleteChannel>(clientData.userId, serverId, channel));
+            } else if (cmd == "addhost") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string host = root.get("host", "").asString();
+                string password = root.get("password", "").asString();
+                int port = root.get("port", -1).asInt();
+                bool ipV6 = root.get("ipv6", true).asBool();
+                bool ssl = root.get("ssl", true).asBool();
+
+                appQueue->sendEvent(make_shared<EventIrcAddHost>(clientData.userId,
+                                                                 serverId,
+                                                                 host,
+                                                                 port,
+                                                                 password,
+                                                                 ipV6,
+                                                                 ssl));
+            } else if (cmd == "modifyhost") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string oldHost = root.get("oldhost", "").asString();
+                int oldPort = root.get("oldport", -1).asInt();
+                string host = root.get("host", "").asString();
+                string password = root.get("password", "").asString();
+                int port = root.get("port", -1).asInt();
+                bool ipV6 = root.get("ipv6", true).asBool();
+                bool ssl = root.get("ssl", true).asBool();
+
+                appQueue->sendEvent(make_shared<EventIrcDeleteHost>(clientData.userId,
+                                                                    serverId,
+                                                                    oldHost,
+                                                                    oldPort));
+
+                appQueue->sendEvent(make_shared<EventIrcAddHost>(clientData.userId,
+                                                                 serverId,
+                                                                 host,
+                                                                 port,
+                                                                 password,
+                                                                 ipV6,
+                                                                 ssl));
+            } else if (cmd == "modifynick") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string oldNick = root.get("oldnick", "").asString();
+                string newNick = root.get("newnick", "").asString();
+
+                appQueue->sendEvent(make_shared<EventIrcModifyNick>(clientData.userId,
+                                                                    serverId,
+                                                                    oldNick,
+                                                                    newNick));
+            } else if (cmd == "reconnect") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+
+                appQueue->sendEvent(make_shared<EventIrcReconnectServer>(clientData.userId,
+                                                                         serverId));
+            } else if (cmd == "deletehost") {
+                size_t serverId;
+                istringstream(root.get("server", "0").asString()) >> serverId;
+                string host = root.get("host", "").asString();
+                int port = root.get("port", -1).asInt();
+
+                appQueue->sendEvent(make_shared<EventIrcDeleteHost>(clientData.userId,
+                                                                    serverId,
+                                                                    host,
+                                                                    port));
             }
-        } catch(std::exception const& error) {
-            cout << "Error while reading JSON command:" << endl
-                 << error.what() << endl
-                 << data << endl;
         }
+    } catch(std::exception const& error) {
+        LOG_WARNING(logModule) << "could not read a command" << logField("user", clientData.userId)
+                               << logField("error", error.what()) << logField("command", Json::FastWriter().write(root));
     }
 }
 
 void WebsocketHandler::onDisconnect(seasocks::WebSocket* connection) {
+    // seasocks deletes the connection afterwards
+    {
+        lock_guard<mutex> lock(connectionMutex);
+        auto it = sockets.find(connection);
+        if (it != sockets.end()) {
+            if (it->second.outbound)
+                it->second.outbound->close();
+            connections.erase(it->second.id);
+            sockets.erase(it);
+        }
+    }
     queue->sendEvent(make_shared<EventLogout>(connection));
 }
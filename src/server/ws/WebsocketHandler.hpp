@@ -1,15 +1,27 @@
 #ifndef WEBSOCKETHANDLER_H
 #define WEBSOCKETHANDLER_H
 
+#include <functional>
 #include <list>
 #include <unordered_map>
+#include <memory>
+#include <mutex>
 #include <seasocks/WebSocket.h>
 #include <seasocks/Server.h>
 #include "WebsocketProtocolHandler.hpp"
+#include "WebsocketOutboundQueue.hpp"
 
 
 class EventQueue;
 
+/// Message formats of logged in clients
+enum class WebsocketEncoding {
+    /// Json text messages, the default
+    Json,
+    /// MessagePack binary messages
+    MessagePack
+};
+
 /// Session storage for websocket connections
 struct WebsocketClientData {
 public:
@@ -19,6 +31,12 @@ public:
     size_t userId;
     /// Socket for communication with the client
     seasocks::WebSocket* socket;
+    /// Negotiated message format
+    WebsocketEncoding encoding;
+    /// Chat listings without users, the client requests them page by page
+    bool lazyUserlists;
+    /// Messages which were not sent yet, only used by the seasocks thread
+    std::shared_ptr<WebsocketOutboundQueue> outbound;
 };
 
 /// Handles all websocket related commands, sent by the connected clients
@@ -31,6 +49,18 @@ class WebsocketHandler : public seasocks::WebSocket::Handler {
     std::map<std::string, std::unique_ptr<WebsocketProtocolHandler>> protocolHandlers;
     /// Client list
     const std::unordered_map<seasocks::WebSocket*, std::list<WebsocketClientData>::iterator>& clients;
+    /// State of an open connection
+    struct Connection {
+        size_t id;
+        /// Set once logged in, closed on disconnect
+        std::shared_ptr<WebsocketOutboundQueue> outbound;
+    };
+    /// Guards the open connections, disconnects wait while a login is accepted
+    std::mutex connectionMutex;
+    size_t lastConnectionId;
+    /// Open connections by id, ids are never reused unlike socket addresses
+    std::unordered_map<size_t, seasocks::WebSocket*> connections;
+    std::unordered_map<seasocks::WebSocket*, Connection> sockets;
 
 public:
     /// Constructs the general websocket handler
@@ -39,11 +69,25 @@ public:
                      const std::unordered_map<seasocks::WebSocket*, std::list<WebsocketClientData>::iterator>& clients);
     virtual ~WebsocketHandler();
 
+    /// Runs the function with the socket of a login request if the connection is still open
+    ///
+    /// \param loginData Data of the EventLogin sent for the connection
+    /// \param function Sets the outbound queue of logged in clients, which is closed on disconnect
+    /// \returns False if the connection was closed meanwhile
+    bool withConnection(void* loginData,
+                        const std::function<void(seasocks::WebSocket*, std::shared_ptr<WebsocketOutboundQueue>&)>& function);
+
 private:
+    /// Identifies the connection in login requests, as login results may arrive after it was closed
+    void* getLoginData(seasocks::WebSocket* connection);
     /// Seasocks callback on established connections
     virtual void onConnect(seasocks::WebSocket* connection);
     /// Seasocks callback once data was received
     virtual void onData(seasocks::WebSocket* connection, const char* data);
+    /// Seasocks callback once binary data was received
+    virtual void onData(seasocks::WebSocket* connection, const uint8_t* data, size_t length);
+    /// Handles a command of a logged in client, independent of the encoding
+    void onCommand(seasocks::WebSocket* connection, WebsocketClientData& clientData, const Json::Value& root);
     /// Seasocks callback on disconnects
     virtual void onDisconnect(seasocks::WebSocket* connection);
 };
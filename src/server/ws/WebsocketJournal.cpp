@@ -0,0 +1,36 @@
+#include "WebsocketJournal.hpp"
+#include "event/IEvent.hpp"
+
+using namespace std;
+
+
+WebsocketJournal::WebsocketJournal(size_t capacity)
+    : capacity{capacity}
+    , lastSequence{0}
+{
+}
+
+uint64_t WebsocketJournal::append(std::shared_ptr<IEvent> event) {
+    entries.emplace_back(++lastSequence, event);
+    while (entries.size() > capacity)
+        entries.pop_front();
+    return lastSequence;
+}
+
+uint64_t WebsocketJournal::getLastSequence() const {
+    return lastSequence;
+}
+
+bool WebsocketJournal::since(uint64_t sequence, std::vector<Entry>& result) const {
+    if (sequence > lastSequence) return false; // from some other journal
+    // the first missing event must still be stored
+    uint64_t oldest = entries.empty() ? lastSequence + 1 : entries.front().first;
+    if (sequence + 1 < oldest) return false;
+
+    result.clear();
+    for (auto& entry : entries) {
+        if (entry.first > sequence)
+            result.push_back(entry);
+    }
+    return true;
+}
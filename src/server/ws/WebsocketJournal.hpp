@@ -0,0 +1,40 @@
+#ifndef WEBSOCKETJOURNAL_H
+#define WEBSOCKETJOURNAL_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+class IEvent;
+
+/// Bounded history of the events sent to all clients of a user.
+/// Reconnecting clients present the last sequence number they saw and
+/// get the missing events replayed instead of a full chat listing.
+class WebsocketJournal {
+public:
+    /// Sequence number and event
+    using Entry = std::pair<uint64_t, std::shared_ptr<IEvent>>;
+private:
+    size_t capacity;
+    uint64_t lastSequence;
+    std::deque<Entry> entries;
+public:
+    /// Constructor
+    ///
+    /// \param capacity Maximum amount of stored events, older events are dropped
+    explicit WebsocketJournal(size_t capacity);
+
+    /// Stores an event and returns its sequence number (starting with 1)
+    uint64_t append(std::shared_ptr<IEvent> event);
+    /// Sequence number of the newest event, 0 if there was none
+    uint64_t getLastSequence() const;
+    /// Collects all events newer than the given sequence number
+    ///
+    /// \returns false if events after the sequence number were already dropped
+    bool since(uint64_t sequence, std::vector<Entry>& result) const;
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "WebsocketOutboundQueue.hpp"
+#include <seasocks/Connection.h>
+#include "MessagePack.hpp"
+#include "utils/Metrics.hpp"
+
+using namespace std;
+
+
+WebsocketOutboundQueue::Settings::Settings()
+    : highWatermark{4 * 1024 * 1024}
+    , lowWatermark{256 * 1024}
+    , maxCoalesceWindow{20}
+    , maxBatchSize{64 * 1024}
+{
+}
+
+WebsocketOutboundQueue::WebsocketOutboundQueue(seasocks::WebSocket* socket,
+                                               const Settings& settings,
+                                               std::unique_ptr<WebsocketDeflate> deflate,
+                                               bool binary,
+                                               const std::string& resyncNotice,
+                                               std::function<void()> onResync,
+                                               std::chrono::milliseconds coalesceWindow,
+                                               MetricsGauge& userDepth)
+    : socket{socket}
+    , settings(settings)
+    , deflate{move(deflate)}
+    , binary{binary}
+    , resyncNotice{resyncNotice}
+    , onResync{onResync}
+    , coalesceWindow{coalesceWindow}
+    , batchBytes{0}
+    , queuedBytes{0}
+    , state{State::Active}
+    , depth{0}
+    , resyncs{0}
+    , userDepth{&userDepth}
+{
+}
+
+void WebsocketOutboundQueue::setDepth(size_t newDepth) {
+    userDepth->add(static_cast<int64_t>(newDepth) - static_cast<int64_t>(depth.load()));
+    depth = newDepth;
+}
+
+size_t WebsocketOutboundQueue::bufferedBytes() const {
+    // every websocket handed out by seasocks is a connection
+    return static_cast<seasocks::Connection*>(socket)->outputBufferSize();
+}
+
+bool WebsocketOutboundQueue::sendMessage(const std::string& message) {
+    static MetricsCounter& bytesSent = MetricsRegistry::getInstance().getCounter("harpoon_websocket_bytes_sent_total",
+                                                                                 "Payload bytes sent to websocket clients");
+    string compressed;
+    if (deflate && deflate->compress(message, compressed)) {
+        socket->send(reinterpret_cast<const uint8_t*>(compressed.c_str()), compressed.size());
+        bytesSent.increment(compressed.size());
+    } else if (binary && deflate) {
+        // the client inflates every binary frame, an uncompressed one can't be told apart
+        return false;
+    } else if (!deflate) {
+        socket->send(reinterpret_cast<const uint8_t*>(message.c_str()), message.size());
+        bytesSent.increment(message.size());
+    } else {
+        // with compression, uncompressed json is sent as text frame
+        socket->send(message.c_str());
+        bytesSent.increment(message.size());
+    }
+    return true;
+}
+
+void WebsocketOutboundQueue::abort() {
+    close();
+    // seasocks calls onDisconnect afterwards, the client logs in again
+    socket->close();
+}
+
+void WebsocketOutboundQueue::enqueue(const std::string& message) {
+    messages.push_back(message);
+    queuedBytes += message.size();
+    if (queuedBytes + bufferedBytes() > settings.highWatermark) {
+        // the deltas are useless once one is missing, the client gets a full listing instead
+        messages.clear();
+        queuedBytes = 0;
+        state = State::ResyncRequired;
+        ++resyncs;
+    }
+}
+
+void WebsocketOutboundQueue::flushBatch() {
+    if (batch.empty()) return;
+    if (batch.size() == 1) {
+        enqueue(batch.front());
+    } else if (binary) {
+        string packed = MessagePack::writeArrayHeader(batch.size());
+        packed.reserve(packed.size() + batchBytes);
+        for (auto& message : batch)
+            packed += message;
+        enqueue(packed);
+    } else {
+        // concatenates the json messages without their trailing newline
+        string packed = "[";
+        packed.reserve(batchBytes + batch.size() + 2);
+        for (auto& message : batch) {
+            if (packed.size() > 1)
+                packed += ',';
+            size_t length = message.size();
+            while (length > 0 && message[length - 1] == '\n')
+                --length;
+            packed.append(message, 0, length);
+        }
+        packed += "]\n";
+        enqueue(packed);
+    }
+    batch.clear();
+    batchBytes = 0;
+}
+
+bool WebsocketOutboundQueue::push(const std::string& message) {
+    if (state != State::Active) return state == State::ResyncRequired;
+
+    if (coalesceWindow.count() > 0) {
+        if (batch.empty())
+            batchDeadline = chrono::steady_clock::now() + coalesceWindow;
+        batch.push_back(message);
+        batchBytes += message.size();
+        if (batchBytes < settings.maxBatchSize) {
+            setDepth(queuedBytes + batchBytes + bufferedBytes());
+            return true;
+        }
+        flushBatch();
+    } else {
+        enqueue(message);
+    }
+    return drain();
+}
+
+bool WebsocketOutboundQueue::drain() {
+    if (state == State::Closed) return false;
+
+    if (!batch.empty() && state == State::Active && chrono::steady_clock::now() >= batchDeadline)
+        flushBatch();
+
+    size_t buffered = bufferedBytes();
+    if (state == State::ResyncRequired && buffered <= settings.lowWatermark) {
+        state = State::Active;
+        if (!sendMessage(resyncNotice)) {
+            abort();
+            return false;
+        }
+        onResync();
+        buffered = bufferedBytes();
+    }
+
+    while (state == State::Active && !messages.empty() && buffered < settings.lowWatermark) {
+        queuedBytes -= messages.front().size();
+        if (!sendMessage(messages.front())) {
+            abort();
+            return false;
+        }
+        messages.pop_front();
+        buffered = bufferedBytes();
+    }
+
+    setDepth(queuedBytes + batchBytes + buffered);
+    return state == State::ResyncRequired || !messages.empty() || !batch.empty();
+}
+
+void WebsocketOutboundQueue::close() {
+    state = State::Closed;
+    messages.clear();
+    queuedBytes = 0;
+    batch.clear();
+    batchBytes = 0;
+    setDepth(0);
+}
+
+WebsocketOutboundQueue::State WebsocketOutboundQueue::getState() const {
+    return state;
+}
+
+bool WebsocketOutboundQueue::hasBatch() const {
+    return !batch.empty();
+}
+
+std::chrono::steady_clock::time_point WebsocketOutboundQueue::getBatchDeadline() const {
+    return batchDeadline;
+}
+
+size_t WebsocketOutboundQueue::getDepth() const {
+    return depth;
+}
+
+uint64_t WebsocketOutboundQueue::getResyncs() const {
+    return resyncs;
+}
@@ -0,0 +1,131 @@
+#ifndef WEBSOCKETOUTBOUNDQUEUE_H
+#define WEBSOCKETOUTBOUNDQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <string>
+#include <seasocks/WebSocket.h>
+#include "WebsocketDeflate.hpp"
+
+class MetricsGauge;
+
+
+/// Messages for a single client which were not handed to seasocks yet.
+/// Seasocks buffers everything that is sent, so a stalled client would
+/// grow the buffer without limit. Messages are only passed on while the
+/// socket buffer is below the low watermark. If the queue grows above the
+/// high watermark, all queued messages are dropped and the client needs
+/// a resync once it drained its buffer.
+/// Clients can request a coalescing window, messages within the window
+/// are packed into a single array frame.
+///
+/// Except for getDepth, all methods must be called from the seasocks thread.
+class WebsocketOutboundQueue {
+public:
+    /// Server side configuration, read from config/websocket.ini
+    struct Settings {
+        Settings();
+        /// Queued bytes (including the socket buffer) which require a resync
+        size_t highWatermark;
+        /// Socket buffer size below which messages are sent
+        size_t lowWatermark;
+        /// Largest coalescing window a client may request, 0 disables coalescing
+        std::chrono::milliseconds maxCoalesceWindow;
+        /// A batch is sent before the window ends if it grows beyond this size
+        size_t maxBatchSize;
+    };
+
+    /// Delivery state of the client
+    enum class State {
+        /// Messages are queued and sent
+        Active,
+        /// Messages were dropped, waiting for the socket buffer to drain
+        ResyncRequired,
+        /// The connection was closed
+        Closed
+    };
+
+private:
+    seasocks::WebSocket* socket;
+    Settings settings;
+    std::unique_ptr<WebsocketDeflate> deflate;
+    bool binary;
+    std::string resyncNotice;
+    std::function<void()> onResync;
+
+    std::chrono::milliseconds coalesceWindow;
+    std::vector<std::string> batch;
+    size_t batchBytes;
+    std::chrono::steady_clock::time_point batchDeadline;
+
+    std::deque<std::string> messages;
+    size_t queuedBytes;
+    State state;
+    std::atomic<size_t> depth;
+    std::atomic<uint64_t> resyncs;
+    /// Queued bytes of all clients of the user, shared with the other queues of the user
+    MetricsGauge* userDepth;
+
+    /// Updates the depth and the difference in the gauge of the user
+    void setDepth(size_t newDepth);
+    /// Returns the amount of bytes which seasocks did not write to the socket yet
+    size_t bufferedBytes() const;
+    /// Compresses (if negotiated) and hands the message to seasocks
+    ///
+    /// \returns False if the message couldn't be sent, the connection has to be closed then
+    bool sendMessage(const std::string& message);
+    /// Closes the queue and the connection after a failed message
+    void abort();
+    /// Adds a message to the queue, dropping the queue above the high watermark
+    void enqueue(const std::string& message);
+    /// Packs the current batch into one message and enqueues it
+    void flushBatch();
+public:
+    /// Constructor
+    ///
+    /// \param socket The client connection
+    /// \param settings Watermark configuration
+    /// \param deflate Compression state, null if compression is not used
+    /// \param binary True if the encoding uses binary frames
+    /// \param resyncNotice Encoded message which tells the client to discard its state
+    /// \param onResync Called once a resynced client can receive messages again
+    /// \param coalesceWindow Time messages are collected into one frame, 0 to send them directly
+    /// \param userDepth Gauge of the user's queued bytes, updated by the seasocks thread
+    WebsocketOutboundQueue(seasocks::WebSocket* socket,
+                           const Settings& settings,
+                           std::unique_ptr<WebsocketDeflate> deflate,
+                           bool binary,
+                           const std::string& resyncNotice,
+                           std::function<void()> onResync,
+                           std::chrono::milliseconds coalesceWindow,
+                           MetricsGauge& userDepth);
+
+    /// Appends a message and sends as much as possible
+    ///
+    /// \returns true if messages are still pending
+    bool push(const std::string& message);
+    /// Sends queued messages as long as the socket buffer allows it.
+    /// A batch is only sent once its window ended.
+    ///
+    /// \returns true if messages are still pending
+    bool drain();
+    /// Stops all further sending, the socket must not be used anymore
+    void close();
+
+    /// Current state of the queue
+    State getState() const;
+    /// Returns if messages are waiting for the coalescing window to end
+    bool hasBatch() const;
+    /// Time when the current batch has to be sent
+    std::chrono::steady_clock::time_point getBatchDeadline() const;
+    /// Queued bytes including the socket buffer, can be called from any thread
+    size_t getDepth() const;
+    /// Number of resyncs of this client, can be called from any thread
+    uint64_t getResyncs() const;
+};
+
+#endif
@@ -1,9 +1,15 @@
 #include "WebsocketServer.hpp"
 #include <sstream>
 #include <map>
+#include <algorithm>
+#include <vector>
 #include <json/json.h>
 #include "event/IUserEvent.hpp"
 #include "event/EventQuit.hpp"
+#include "event/EventTimer.hpp"
+#include "utils/LatencyTracer.hpp"
+#include "utils/Metrics.hpp"
+#include "MetricsPageHandler.hpp"
 #include "event/irc/EventIrcMessage.hpp"
 #include "event/irc/EventIrcAction.hpp"
 #include "event/irc/EventIrcUserStatusChanged.hpp"
@@ -16,15 +22,23 @@
 #include "event/irc/EventIrcHostAdded.hpp"
 #include "event/irc/EventIrcHostDeleted.hpp"
 #include "event/irc/EventIrcUserlistReceived.hpp"
+#include "event/irc/EventIrcUserlistPage.hpp"
 #include "event/irc/EventIrcNickModified.hpp"
 #include "event/irc/EventIrcModeChanged.hpp"
 #include "event/irc/EventIrcBacklogResponse.hpp"
 #include "event/EventLoginResult.hpp"
+#include "event/EventLoginToken.hpp"
 #include "event/EventLogout.hpp"
+#include "event/EventClientOption.hpp"
 #include "event/EventQuery.hpp"
 #include "event/EventQueryType.hpp"
 #include "service/irc/IrcDatabaseMessageType.hpp"
 #include "utils/ModuleProvider.hpp"
+#include "utils/Ini.hpp"
+#include "utils/Base64.hpp"
+#include "utils/Crypto.hpp"
+#include "utils/Cpp11Utils.hpp"
+#include "MessagePack.hpp"
 
 
 #ifdef USE_WEBSOCKET_SERVER_VERBOSE
@@ -48,10 +62,27 @@ const std::map<IrcDatabaseMessageType, std::string> databaseMessageTypeToName {
     { IrcDatabaseMessageType::Action, "action" }
 };
 
+/// Json clients get ids as strings, jsoncpp has no clue of size_t and javascript numbers
+/// can't hold 64 bit values. Binary encodings use native integers.
+static Json::Value toId(size_t id, WebsocketEncoding encoding) {
+    if (encoding == WebsocketEncoding::Json)
+        return to_string(id);
+    return static_cast<Json::UInt64>(id);
+}
+
+/// Serializes a document tree with the given encoding
+static std::string encodeValue(const Json::Value& root, WebsocketEncoding encoding) {
+    if (encoding == WebsocketEncoding::MessagePack)
+        return MessagePack::write(root);
+    return Json::FastWriter{}.write(root);
+}
+
 
 WebsocketClientData::WebsocketClientData(size_t userId, seasocks::WebSocket* socket)
     : userId{userId}
     , socket{socket}
+    , encoding{WebsocketEncoding::Json}
+    , lazyUserlists{false}
 {
 }
 
@@ -60,75 +91,266 @@ PROVIDE_EVENTLOOP_MODULE("server", "websocket", WebsocketServer)
 
 
 
+static MetricsGauge& getClientGauge() {
+    static MetricsGauge& gauge = MetricsRegistry::getInstance().getGauge("harpoon_websocket_clients",
+                                                                         "Logged in websocket clients");
+    return gauge;
+}
+
 WebsocketServer::WebsocketServer(EventQueue* appQueue)
     : appQueue{appQueue}
+    , deflateCollector{addDeflateCollector()}
+    , journalEpoch{static_cast<uint64_t>(chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count())}
+    , journalSize{1000}
+    , hasBacklog{false}
     , server{make_shared<WEBSOCKET_LOGGER_TYPE>()}
+    , flushTimer{0}
+    , nextFlush{chrono::steady_clock::time_point::max()}
 {
-    server.addWebSocketHandler("/ws", make_shared<WebsocketHandler>(appQueue, getEventQueue(), clients));
+    loadSettings();
+    websocketHandler = make_shared<WebsocketHandler>(appQueue, getEventQueue(), clients);
+    server.addWebSocketHandler("/ws", websocketHandler);
+    server.addPageHandler(make_shared<MetricsPageHandler>());
     serverThread = thread([this]{
         server.serve("public", 8080);
     });
+    retryTimer = scheduleEvery(chrono::milliseconds(50));
 }
 
 WebsocketServer::~WebsocketServer() {
+    MetricsRegistry::getInstance().removeCollector(deflateCollector);
+    cancelTimer(retryTimer);
+    {
+        lock_guard<mutex> lock(drainMutex);
+        if (flushTimer != 0)
+            cancelTimer(flushTimer);
+    }
     server.terminate();
     serverThread.join();
 }
 
+void WebsocketServer::loadSettings() {
+    Ini websocketIni("config/websocket.ini");
+    auto& compression = websocketIni.expectCategory("compression");
+    auto& queue = websocketIni.expectCategory("queue");
+    auto& journal = websocketIni.expectCategory("journal");
+    auto& session = websocketIni.expectCategory("session");
+
+    // missing entries are written with their defaults
+    auto entry = [&](Ini::Entries& category, const string& name, const string& defaultValue) {
+        string value;
+        if (!websocketIni.getEntry(category, name, value)) {
+            value = defaultValue;
+            websocketIni.setEntry(category, name, value);
+        }
+        return value;
+    };
+
+    deflateSettings.enabled = entry(compression, "enabled", deflateSettings.enabled ? "y" : "n") == "y";
+    istringstream(entry(compression, "level", to_string(deflateSettings.level))) >> deflateSettings.level;
+    istringstream(entry(compression, "mem_level", to_string(deflateSettings.memLevel))) >> deflateSettings.memLevel;
+    istringstream(entry(compression, "window_bits", to_string(deflateSettings.maxWindowBits))) >> deflateSettings.maxWindowBits;
+    deflateSettings.contextTakeover = entry(compression, "context_takeover", deflateSettings.contextTakeover ? "y" : "n") == "y";
+    istringstream(entry(compression, "threshold", to_string(deflateSettings.threshold))) >> deflateSettings.threshold;
+
+    deflateSettings.level = max(-1, min(9, deflateSettings.level));
+    deflateSettings.memLevel = max(1, min(9, deflateSettings.memLevel));
+    deflateSettings.maxWindowBits = max(9, min(15, deflateSettings.maxWindowBits));
+
+    istringstream(entry(queue, "high_watermark", to_string(queueSettings.highWatermark))) >> queueSettings.highWatermark;
+    istringstream(entry(queue, "low_watermark", to_string(queueSettings.lowWatermark))) >> queueSettings.lowWatermark;
+    queueSettings.lowWatermark = min(queueSettings.lowWatermark, queueSettings.highWatermark);
+    auto maxCoalesceWindow = queueSettings.maxCoalesceWindow.count();
+    istringstream(entry(queue, "max_coalesce_window", to_string(queueSettings.maxCoalesceWindow.count()))) >> maxCoalesceWindow;
+    queueSettings.maxCoalesceWindow = chrono::milliseconds(max<decltype(maxCoalesceWindow)>(0, maxCoalesceWindow));
+    istringstream(entry(queue, "max_batch_size", to_string(queueSettings.maxBatchSize))) >> queueSettings.maxBatchSize;
+
+    istringstream(entry(journal, "size", to_string(journalSize))) >> journalSize;
+
+    // the secret is generated once, tokens stay valid across restarts
+    WebsocketSessionTokens::Settings sessionSettings;
+    sessionSettings.enabled = entry(session, "enabled", sessionSettings.enabled ? "y" : "n") == "y";
+    sessionSettings.secret = Base64::decode(entry(session, "secret", Base64::encode(Crypto().genSalt(32))));
+    auto lifetime = sessionSettings.lifetime.count();
+    istringstream(entry(session, "lifetime", to_string(lifetime))) >> lifetime;
+    sessionSettings.lifetime = chrono::seconds(lifetime);
+    sessionTokens = cpp11::make_unique<WebsocketSessionTokens>(sessionSettings, "config/sessions.ini");
+}
+
+size_t WebsocketServer::addDeflateCollector() {
+    auto& registry = MetricsRegistry::getInstance();
+    registry.describe("harpoon_websocket_deflate_messages_total", "Messages passed to the compression of clients", "counter");
+    registry.describe("harpoon_websocket_deflate_compressed_total", "Messages sent compressed", "counter");
+    registry.describe("harpoon_websocket_deflate_bytes_in_total", "Uncompressed size of the compressed messages", "counter");
+    registry.describe("harpoon_websocket_deflate_bytes_out_total", "Compressed size of the compressed messages", "counter");
+    registry.describe("harpoon_websocket_deflate_seconds_total", "Time spent compressing messages", "counter");
+    auto* statistics = &deflateStatistics;
+    return registry.addCollector([statistics](MetricsRegistry::Collection& collection) {
+        collection.add("harpoon_websocket_deflate_messages_total", {}, statistics->messages);
+        collection.add("harpoon_websocket_deflate_compressed_total", {}, statistics->compressedMessages);
+        collection.add("harpoon_websocket_deflate_bytes_in_total", {}, statistics->bytesIn);
+        collection.add("harpoon_websocket_deflate_bytes_out_total", {}, statistics->bytesOut);
+        collection.add("harpoon_websocket_deflate_seconds_total", {}, statistics->nanoseconds / 1e9);
+    });
+}
+
 bool WebsocketServer::onEvent(std::shared_ptr<IEvent> event) {
     UUID eventType = event->getEventUuid();
 
     if (eventType == EventQuit::uuid) {
         return false;
+    } else if (eventType == EventTimer::uuid) {
+        size_t timerId = event->as<EventTimer>()->getTimerId();
+        bool flush = false;
+        {
+            lock_guard<mutex> lock(drainMutex);
+            if (flushTimer != 0 && timerId == flushTimer) {
+                flushTimer = 0;
+                nextFlush = chrono::steady_clock::time_point::max();
+                flush = true;
+            }
+        }
+        if (flush || (timerId == retryTimer && hasBacklog))
+            server.execute([this]{ drainBackloggedQueues(); });
+        return true;
+    } else if (eventType == EventClientOption::uuid) {
+        auto option = event->as<EventClientOption>();
+        auto socket = (seasocks::WebSocket*)option->getData();
+        string name = option->getName();
+        if (name == "token")
+            handleTokenLogin(option->getData(), option->getValue());
+        else if (name == "revoke" || name == "revoke_all")
+            handleSessionOption(socket, name, option->getValue());
+        else if (clients.find(socket) == clients.end())
+            pendingOptions[socket][name] = option->getValue();
+        return true;
     } else if (eventType == EventLoginResult::uuid) {
         auto* loginResult = event->as<EventLoginResult>();
-        auto socket = (seasocks::WebSocket*)loginResult->getData();
-        if (loginResult->getSuccess()) {
-            addClient(loginResult->getUserId(), socket);
-        } else {
-            server.execute([socket] {
-                socket->close();
+        bool success = loginResult->getSuccess();
+        size_t userId = loginResult->getUserId();
+        void* loginData = loginResult->getData();
+        // the login was requested by connection id, results of closed connections are dropped
+        seasocks::WebSocket* socket = nullptr;
+        bool added = false;
+        websocketHandler->withConnection(loginData, [&](seasocks::WebSocket* connection,
+                                                        shared_ptr<WebsocketOutboundQueue>& outbound) {
+            socket = connection;
+            if (success && clients.find(connection) == clients.end()) {
+                addClient(userId, connection);
+                outbound = clients.at(connection)->outbound;
+                added = true;
+            }
+        });
+        if (!socket) return true;
+        if (!success) {
+            pendingOptions.erase(socket);
+            auto handler = websocketHandler;
+            server.execute([handler, loginData] {
+                seasocks::WebSocket* connection = nullptr;
+                if (handler->withConnection(loginData, [&connection](seasocks::WebSocket* open,
+                                                                     shared_ptr<WebsocketOutboundQueue>&) { connection = open; }))
+                    connection->close();
             });
+            return true;
         }
+        if (!added) return true; // logged in already
+        // clients receive the result by their socket
+        event = make_shared<EventLoginResult>(success, userId, socket);
     }
 
     auto userEvent = event->as<IClientEvent>();
     if (userEvent) {
+        // every encoding is serialized at most once per event, json is needed to tell if clients see it
+        map<WebsocketEncoding, string> messages;
+        auto singleClientEvent = event->as<ISingleClientEvent>();
+        uint64_t sequence = 0;
+        auto journalIt = journals.find(userEvent->getUserId());
+        if (!singleClientEvent && journalIt != journals.end()) {
+            sequence = journalIt->second.getLastSequence() + 1;
+            auto& json = messages[WebsocketEncoding::Json] = encodeEvent(event, WebsocketEncoding::Json, sequence);
+            if (json.size() > 0)
+                journalIt->second.append(event);
+        }
+
         auto it = userToClients.find(userEvent->getUserId());
         if (it != userToClients.end()) {
-            std::string json = eventToJson(event);
-            if (json.size() > 0) {
-                list<WebsocketClientData>& clientDataList = it->second;
-                auto singleClientEvent = event->as<ISingleClientEvent>();
-                if (singleClientEvent) {
-                    void* data = singleClientEvent->getData();
-                    for (auto& clientData : clientDataList) {
-                        if (clientData.socket == data) {
-                            auto socket = clientData.socket;
-                            server.execute([socket, json] {
-                                    socket->send(reinterpret_cast<const uint8_t*>(json.c_str()), json.size());
-                                });
-                        }
-                    }
-                } else {
-                    for (auto& clientData : clientDataList) {
-                        auto socket = clientData.socket;
-                        server.execute([socket, json] {
-                                socket->send(reinterpret_cast<const uint8_t*>(json.c_str()), json.size());
-                            });
-                    }
-                }
+            for (auto& clientData : it->second) {
+                if (singleClientEvent && clientData.socket != singleClientEvent->getData())
+                    continue;
+                auto messageIt = messages.find(clientData.encoding);
+                if (messageIt == messages.end())
+                    messageIt = messages.emplace(clientData.encoding, encodeEvent(event, clientData.encoding, sequence)).first;
+                if (messageIt->second.size() > 0)
+                    sendToClient(clientData, messageIt->second, event.get());
             }
         }
     }
 
+    // the login result must be sent before anything else
+    if (eventType == EventLoginResult::uuid && event->as<EventLoginResult>()->getSuccess()) {
+        auto socket = (seasocks::WebSocket*)event->as<EventLoginResult>()->getData();
+        issueSessionToken(socket);
+        synchronizeClient(socket);
+    }
+
     if (eventType == EventLogout::uuid) {
         auto logout = event->as<EventLogout>();
-        removeClient((seasocks::WebSocket*)logout->getData());
+        auto socket = (seasocks::WebSocket*)logout->getData();
+        pendingOptions.erase(socket);
+        removeClient(socket);
     }
     return true;
 }
 
+void WebsocketServer::sendToClient(WebsocketClientData& clientData, const std::string& message, const IEvent* event) {
+    auto outbound = clientData.outbound;
+    LatencyTracer::Path* tracePath = nullptr;
+    chrono::steady_clock::time_point created;
+    if (event && LatencyTracer::getInstance().isEnabled()) {
+        tracePath = LatencyTracer::getInstance().getPath("websocket/" + to_string(event->getEventUuid()) + "/write");
+        created = event->getCreated();
+    }
+    server.execute([this, outbound, message, tracePath, created] {
+            bool backlogged = outbound->push(message);
+            if (tracePath)
+                tracePath->record(chrono::steady_clock::now() - created);
+            if (backlogged) {
+                backloggedQueues.insert(outbound);
+                hasBacklog = true;
+                if (outbound->hasBatch())
+                    scheduleFlush(outbound->getBatchDeadline());
+            }
+        });
+}
+
+void WebsocketServer::scheduleFlush(std::chrono::steady_clock::time_point deadline) {
+    lock_guard<mutex> lock(drainMutex);
+    if (deadline >= nextFlush) return;
+    nextFlush = deadline;
+
+    // an already queued event of the replaced timer is ignored
+    if (flushTimer != 0)
+        cancelTimer(flushTimer);
+    auto delay = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+    flushTimer = scheduleAfter(max(delay, chrono::milliseconds(0)));
+}
+
+void WebsocketServer::drainBackloggedQueues() {
+    auto deadline = chrono::steady_clock::time_point::max();
+    for (auto it = backloggedQueues.begin(); it != backloggedQueues.end();) {
+        if ((*it)->drain()) {
+            if ((*it)->hasBatch())
+                deadline = min(deadline, (*it)->getBatchDeadline());
+            ++it;
+        } else {
+            it = backloggedQueues.erase(it);
+        }
+    }
+    hasBacklog = !backloggedQueues.empty();
+    if (deadline != chrono::steady_clock::time_point::max())
+        scheduleFlush(deadline);
+}
+
 void WebsocketServer::addClient(size_t userId, seasocks::WebSocket* socket) {
     auto it = userToClients.find(userId);
     bool found = it != userToClients.end();
@@ -143,9 +365,193 @@ void WebsocketServer::addClient(size_t userId, seasocks::WebSocket* socket) {
     }
 
     dataList->emplace_back(userId, socket);
+
+    auto& clientData = dataList->back();
+    chrono::milliseconds coalesceWindow{0};
+    auto deflate = applyOptions(clientData, coalesceWindow);
+
+    Json::Value notice{Json::objectValue};
+    notice["cmd"] = "resync";
+    auto appQueue = this->appQueue;
+    auto queryType = clientData.lazyUserlists ? EventQueryType::ChatsWithoutUsers : EventQueryType::Chats;
+    clientData.outbound = make_shared<WebsocketOutboundQueue>(socket,
+                                                              queueSettings,
+                                                              move(deflate),
+                                                              clientData.encoding != WebsocketEncoding::Json,
+                                                              encodeValue(notice, clientData.encoding),
+                                                              [appQueue, userId, socket, queryType] {
+        // deltas were dropped, the client needs the complete state again
+        appQueue->sendEvent(make_shared<EventQuery>(userId, socket, queryType));
+    }, coalesceWindow, MetricsRegistry::getInstance().getGauge("harpoon_websocket_queue_bytes",
+                                                             "Bytes queued for the websocket clients of a user",
+                                                             {{"user", to_string(userId)}}));
     clients.emplace(socket, (++dataList->rbegin()).base()); // iterator to last element
+    getClientGauge().set(clients.size());
 
-    appQueue->sendEvent(make_shared<EventQuery>(userId, socket, EventQueryType::Chats));
+    journals.emplace(piecewise_construct,
+                     forward_as_tuple(userId),
+                     forward_as_tuple(journalSize));
+}
+
+void WebsocketServer::synchronizeClient(seasocks::WebSocket* socket) {
+    auto clientIt = clients.find(socket);
+    if (clientIt == clients.end()) return;
+    auto& clientData = *clientIt->second;
+    auto& journal = journals.at(clientData.userId);
+
+    bool requested = false;
+    string resume;
+    auto optionsIt = pendingOptions.find(socket);
+    if (optionsIt != pendingOptions.end()) {
+        auto resumeIt = optionsIt->second.find("resume");
+        if (resumeIt != optionsIt->second.end()) {
+            requested = true;
+            resume = resumeIt->second;
+        }
+        pendingOptions.erase(optionsIt);
+    }
+
+    // "RESUME <epoch> <sequence>", without arguments the client only asks for sequence numbers
+    vector<WebsocketJournal::Entry> replay;
+    bool resumed = false;
+    if (requested) {
+        uint64_t epoch, sequence;
+        istringstream is(resume);
+        if (is >> epoch >> sequence && epoch == journalEpoch)
+            resumed = journal.since(sequence, replay);
+
+        Json::Value root{Json::objectValue};
+        root["cmd"] = "resume";
+        root["success"] = resumed;
+        root["epoch"] = toId(journalEpoch, clientData.encoding);
+        root["seq"] = toId(journal.getLastSequence(), clientData.encoding);
+        sendToClient(clientData, encodeValue(root, clientData.encoding));
+    }
+
+    if (resumed) {
+        for (auto& entry : replay) {
+            string message = encodeEvent(entry.second, clientData.encoding, entry.first);
+            if (message.size() > 0)
+                sendToClient(clientData, message);
+        }
+    } else {
+        auto queryType = clientData.lazyUserlists ? EventQueryType::ChatsWithoutUsers : EventQueryType::Chats;
+        appQueue->sendEvent(make_shared<EventQuery>(clientData.userId, socket, queryType));
+    }
+}
+
+void WebsocketServer::issueSessionToken(seasocks::WebSocket* socket) {
+    auto clientIt = clients.find(socket);
+    if (clientIt == clients.end() || !sessionTokens->isEnabled()) return;
+    auto& clientData = *clientIt->second;
+
+    // every login renews the token, the previous one stays valid until it expires
+    uint64_t expires;
+    Json::Value root{Json::objectValue};
+    root["cmd"] = "session";
+    root["token"] = sessionTokens->issue(clientData.userId, expires);
+    root["expires"] = toId(expires, clientData.encoding);
+    sendToClient(clientData, encodeValue(root, clientData.encoding));
+}
+
+void WebsocketServer::handleTokenLogin(void* loginData, const std::string& token) {
+    // the signature is verified here within microseconds, the login database checks that the user still exists
+    size_t userId = 0;
+    if (sessionTokens->verify(token, userId))
+        appQueue->sendEvent(make_shared<EventLoginToken>(loginData, userId));
+    else
+        appQueue->sendEvent(make_shared<EventLoginResult>(false, userId, loginData));
+}
+
+void WebsocketServer::handleSessionOption(seasocks::WebSocket* socket, const std::string& name, const std::string& value) {
+    auto clientIt = clients.find(socket);
+    if (clientIt == clients.end()) return;
+    auto& clientData = *clientIt->second;
+    bool revoked = true;
+    if (name == "revoke")
+        revoked = sessionTokens->revoke(value, clientData.userId);
+    else
+        sessionTokens->revokeUser(clientData.userId);
+
+    Json::Value root{Json::objectValue};
+    root["cmd"] = "revoked";
+    root["success"] = revoked;
+    sendToClient(clientData, encodeValue(root, clientData.encoding));
+}
+
+std::unique_ptr<WebsocketDeflate> WebsocketServer::applyOptions(WebsocketClientData& clientData,
+                                                                std::chrono::milliseconds& coalesceWindow) {
+    auto socket = clientData.socket;
+    std::unique_ptr<WebsocketDeflate> deflate;
+    auto it = pendingOptions.find(socket);
+    if (it == pendingOptions.end()) return deflate;
+    auto& options = it->second;
+
+    // replies are always uncompressed json, the options apply to all later messages
+    vector<string> replies;
+    auto encodingIt = options.find("encoding");
+    if (encodingIt != options.end()) {
+        if (encodingIt->second == "msgpack")
+            clientData.encoding = WebsocketEncoding::MessagePack;
+        Json::Value root{Json::objectValue};
+        root["cmd"] = "encoding";
+        root["encoding"] = clientData.encoding == WebsocketEncoding::MessagePack ? "msgpack" : "json";
+        replies.push_back(Json::FastWriter{}.write(root));
+    }
+
+    auto userlistIt = options.find("userlist");
+    if (userlistIt != options.end()) {
+        clientData.lazyUserlists = userlistIt->second == "lazy";
+        Json::Value root{Json::objectValue};
+        root["cmd"] = "userlistmode";
+        root["lazy"] = clientData.lazyUserlists;
+        replies.push_back(Json::FastWriter{}.write(root));
+    }
+
+    auto coalesceIt = options.find("coalesce");
+    if (coalesceIt != options.end()) {
+        // latency sensitive clients don't ask for it, the window is limited by the server
+        int milliseconds = 0;
+        istringstream(coalesceIt->second) >> milliseconds;
+        coalesceWindow = min(chrono::milliseconds(max(0, milliseconds)), queueSettings.maxCoalesceWindow);
+        Json::Value root{Json::objectValue};
+        root["cmd"] = "coalesce";
+        root["window"] = static_cast<Json::Int>(coalesceWindow.count());
+        replies.push_back(Json::FastWriter{}.write(root));
+    }
+
+    auto extensionsIt = options.find("extensions");
+    if (extensionsIt != options.end()) {
+        string response;
+        int windowBits;
+        bool contextTakeover;
+        if (WebsocketDeflate::negotiate(extensionsIt->second, deflateSettings, response, windowBits, contextTakeover)) {
+            // binary encodings can't tell uncompressed from compressed frames
+            bool compressAll = clientData.encoding != WebsocketEncoding::Json;
+            deflate = cpp11::make_unique<WebsocketDeflate>(deflateSettings,
+                                                           windowBits,
+                                                           contextTakeover,
+                                                           &deflateStatistics,
+                                                           compressAll);
+        }
+        // an empty list declines the offer
+        Json::Value root{Json::objectValue};
+        root["cmd"] = "extensions";
+        root["extensions"] = response;
+        replies.push_back(Json::FastWriter{}.write(root));
+    }
+    // the remaining options are handled after the login result was sent
+    options.erase("encoding");
+    options.erase("userlist");
+    options.erase("coalesce");
+    options.erase("extensions");
+
+    for (auto& reply : replies) {
+        server.execute([socket, reply] {
+                socket->send(reply.c_str());
+            });
+    }
+    return deflate;
 }
 
 void WebsocketServer::removeClient(seasocks::WebSocket* socket) {
@@ -153,6 +559,12 @@ void WebsocketServer::removeClient(seasocks::WebSocket* socket) {
     if (it != clients.end()) {
         auto data = it->second;
         size_t userId = data->userId;
+        auto outbound = data->outbound;
+        if (outbound) {
+            server.execute([outbound] {
+                    outbound->close();
+                });
+        }
         auto clientListIt = userToClients.find(userId);
         if (clientListIt != userToClients.end()) {
             clientListIt->second.erase(data);
@@ -160,10 +572,19 @@ void WebsocketServer::removeClient(seasocks::WebSocket* socket) {
                 userToClients.erase(userId);
         }
         clients.erase(it);
+        getClientGauge().set(clients.size());
     }
 }
 
-std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
+std::string WebsocketServer::encodeEvent(std::shared_ptr<IEvent> event, WebsocketEncoding encoding, uint64_t sequence) {
+    Json::Value root = eventToValue(event, encoding);
+    if (root.isNull()) return "";
+    if (sequence != 0)
+        root["seq"] = toId(sequence, encoding);
+    return encodeValue(root, encoding);
+}
+
+Json::Value WebsocketServer::eventToValue(std::shared_ptr<IEvent> event, WebsocketEncoding encoding) {
     Json::Value root{Json::objectValue};
 
     auto loggable = event->as<IrcLoggable>();
@@ -175,9 +596,8 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
         auto message = event->as<EventIrcMessage>();
         root["cmd"] = "chat";
         root["protocol"] = "irc";
-        root["id"] = to_string(id);
-        // jsonpp has no clue of size_t and clients only need to store it
-        root["server"] = to_string(message->getServerId());
+        root["id"] = toId(id, encoding);
+        root["server"] = toId(message->getServerId(), encoding);
         root["channel"] = message->getChannel();
         root["nick"] = message->getFrom();
         root["msg"] = message->getMessage();
@@ -194,33 +614,50 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
         auto userlist = event->as<EventIrcUserlistReceived>();
         root["cmd"] = "userlist";
         root["protocol"] = "irc";
-        root["server"] = to_string(userlist->getServerId());
+        root["server"] = toId(userlist->getServerId(), encoding);
         root["channel"] = userlist->getChannel();
         auto& users = root["users"] = Json::objectValue;
         for (auto& user : userlist->getUsers())
             users[user.nick] = user.mode;
         break;
     }
+    case EventIrcUserlistPage::uuid: {
+        auto page = event->as<EventIrcUserlistPage>();
+        root["cmd"] = "userlistpage";
+        root["protocol"] = "irc";
+        root["server"] = toId(page->getServerId(), encoding);
+        root["channel"] = page->getChannel();
+        root["userCount"] = static_cast<Json::UInt64>(page->getUserCount());
+        root["complete"] = page->getComplete();
+        auto& users = root["users"] = Json::arrayValue;
+        for (auto& user : page->getUsers()) {
+            // an array keeps the order for the next request
+            Json::Value& entry = users.append(Json::objectValue);
+            entry["nick"] = user.getNick();
+            entry["mode"] = user.getMode();
+        }
+        break;
+    }
     case EventIrcServerAdded::uuid: {
         auto added = event->as<EventIrcServerAdded>();
         root["cmd"] = "serveradded";
         root["protocol"] = "irc";
         root["name"] = added->getServerName();
-        root["server"] = to_string(added->getServerId());
+        root["server"] = toId(added->getServerId(), encoding);
         break;
     }
     case EventIrcServerDeleted::uuid: {
         auto added = event->as<EventIrcServerDeleted>();
         root["cmd"] = "serverremoved";
         root["protocol"] = "irc";
-        root["server"] = to_string(added->getServerId());
+        root["server"] = toId(added->getServerId(), encoding);
         break;
     }
     case EventIrcHostAdded::uuid: {
         auto added = event->as<EventIrcHostAdded>();
         root["cmd"] = "hostadded";
         root["protocol"] = "irc";
-        root["server"] = to_string(added->getServerId());
+        root["server"] = toId(added->getServerId(), encoding);
         root["host"] = added->getHost();
         root["hasPassword"] = added->getPassword().size() > 0;
         root["port"] = added->getPort();
@@ -232,7 +669,7 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
         auto deleted = event->as<EventIrcHostDeleted>();
         root["cmd"] = "hostdeleted";
         root["protocol"] = "irc";
-        root["server"] = to_string(deleted->getServerId());
+        root["server"] = toId(deleted->getServerId(), encoding);
         root["host"] = deleted->getHost();
         root["port"] = deleted->getPort();
         break;
@@ -241,7 +678,7 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
         auto modified = event->as<EventIrcNickModified>();
         root["cmd"] = "nickmodified";
         root["protocol"] = "irc";
-        root["server"] = to_string(modified->getServerId());
+        root["server"] = toId(modified->getServerId(), encoding);
         root["oldnick"] = modified->getOldNick();
         root["newnick"] = modified->getNewNick();
         break;
@@ -280,7 +717,7 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
         auto listing = event->as<EventIrcChatListing>();
         root["cmd"] = "chatlist";
         root["protocol"] = "irc";
-        root["firstId"] = to_string(listing->getFirstId());
+        root["firstId"] = toId(listing->getFirstId(), encoding);
         Json::Value& serverList = root["servers"] = Json::objectValue;
         for (auto& serverData : listing->getServerList()) {
             Json::Value& server = serverList[to_string(serverData.getServerId())];
@@ -292,6 +729,7 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
                 if (channelData.getDisabled())
                     channel["disabled"] = true;
                 channel["topic"] = channelData.getChannelTopic();
+                channel["userCount"] = static_cast<Json::UInt64>(channelData.getUserCount());
                 Json::Value& users = channel["users"] = Json::objectValue;
                 for (auto& user : channelData.getUsers()) {
                     users[user.getNick()] = user.getMode();
@@ -314,15 +752,20 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
             root["target"] = statusChanged->getTarget();
             root["msg"] = statusChanged->getReason();
             break;
-        case EventIrcUserStatusChanged::Status::Quit:
-            root["cmd"] = "kick";
-            root["target"] = statusChanged->getTarget();
-            root["reason"] = statusChanged->getReason(); // TODO: verify it is "reason"
+        case EventIrcUserStatusChanged::Status::Quit: {
+            root["cmd"] = "quit";
+            root["reason"] = statusChanged->getReason();
+            Json::Value& channels = root["channels"] = Json::Value(Json::arrayValue);
+            for (auto& channel : statusChanged->getChannels())
+                channels.append(channel);
+            break;
+        }
+        default:
             break;
         }
         root["protocol"] = "irc";
-        root["id"] = to_string(id);
-        root["server"] = to_string(statusChanged->getServerId());
+        root["id"] = toId(id, encoding);
+        root["server"] = toId(statusChanged->getServerId(), encoding);
         root["nick"] = statusChanged->getUsername();
         root["channel"] = statusChanged->getChannel();
         break;
@@ -331,8 +774,8 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
         auto topic = event->as<EventIrcTopic>();
         root["cmd"] = "topic";
         root["protocol"] = "irc";
-        root["id"] = to_string(id);
-        root["server"] = to_string(topic->getServerId());
+        root["id"] = toId(id, encoding);
+        root["server"] = toId(topic->getServerId(), encoding);
         root["nick"] = topic->getUsername();
         root["topic"] = topic->getTopic();
         root["channel"] = topic->getChannel();
@@ -342,8 +785,8 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
         auto nick = event->as<EventIrcNickChanged>();
         root["cmd"] = "nickchange";
         root["protocol"] = "irc";
-        root["id"] = to_string(id);
-        root["server"] = to_string(nick->getServerId());
+        root["id"] = toId(id, encoding);
+        root["server"] = toId(nick->getServerId(), encoding);
         root["nick"] = nick->getUsername();
         root["newNick"] = nick->getNewNick();
         break;
@@ -352,8 +795,8 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
         auto action = event->as<EventIrcAction>();
         root["cmd"] = "action";
         root["protocol"] = "irc";
-        root["id"] = to_string(id);
-        root["server"] = to_string(action->getServerId());
+        root["id"] = toId(id, encoding);
+        root["server"] = toId(action->getServerId(), encoding);
         root["nick"] = action->getUsername();
         root["msg"] = action->getMessage();
         root["channel"] = action->getChannel();
@@ -363,8 +806,8 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
         auto mode = event->as<EventIrcModeChanged>();
         root["cmd"] = "mode";
         root["protocol"] = "irc";
-        root["id"] = to_string(id);
-        root["server"] = to_string(mode->getServerId());
+        root["id"] = toId(id, encoding);
+        root["server"] = toId(mode->getServerId(), encoding);
         root["channel"] = mode->getChannel();
         root["nick"] = mode->getUsername();
         root["mode"] = mode->getMode();
@@ -378,7 +821,7 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
 
         root["cmd"] = "backlogresponse";
         root["protocol"] = "irc";
-        root["server"] = to_string(response->getServerId());
+        root["server"] = toId(response->getServerId(), encoding);
         root["channel"] = response->getChannel();
 
         auto& data = response->getData();
@@ -387,7 +830,7 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
         int i = 0;
         for (auto& entry : data) {
             auto& line = lines[i] = Json::objectValue;
-            line["id"] = to_string(entry.messageId);
+            line["id"] = toId(entry.messageId, encoding);
             line["time"] = static_cast<double>(entry.time);
             line["msg"] = entry.message;
             line["sender"] = entry.sender;
@@ -405,8 +848,8 @@ std::string WebsocketServer::eventToJson(std::shared_ptr<IEvent> event) {
         break;
     }
     default:
-        return "";
+        return Json::Value{};
     } // switch(eventType)
     root["time"] = (Json::UInt64)chrono::duration_cast<chrono::milliseconds>(event->getTimestamp().time_since_epoch()).count();
-    return Json::FastWriter{}.write(root);
+    return root;
 }
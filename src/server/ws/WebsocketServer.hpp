@@ -5,26 +5,85 @@
 #include <memory>
 #include <unordered_map>
 #include <thread>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <map>
+#include <json/json.h>
 #include <seasocks/WebSocket.h>
 #include <seasocks/Server.h>
 #include "queue/EventLoop.hpp"
 #include "WebsocketHandler.hpp"
+#include "WebsocketJournal.hpp"
+#include "WebsocketSessionTokens.hpp"
 
 
 /// A websocket server listening for client connections.
-/// Translates internal events to json messages for clients.
+/// Translates internal events to json or MessagePack messages for clients.
 class WebsocketServer : public EventLoop {
     EventQueue* appQueue;
 
     std::shared_ptr<WebsocketHandler> websocketHandler;
     std::unordered_map<size_t, std::list<WebsocketClientData>> userToClients;
     std::unordered_map<seasocks::WebSocket*, std::list<WebsocketClientData>::iterator> clients;
+    /// Options (extensions, encoding) of connections which are not logged in yet
+    std::unordered_map<seasocks::WebSocket*, std::map<std::string, std::string>> pendingOptions;
+    WebsocketDeflate::Settings deflateSettings;
+    WebsocketDeflate::Statistics deflateStatistics;
+    /// Publishes deflateStatistics on /metrics
+    size_t deflateCollector;
+    WebsocketOutboundQueue::Settings queueSettings;
+    /// Identifies the journals of this server run, sequence numbers restart with it
+    uint64_t journalEpoch;
+    /// Maximum amount of events stored per user
+    size_t journalSize;
+    std::unordered_map<size_t, WebsocketJournal> journals;
+    /// Issues and verifies the tokens of "TOKEN <token>" logins
+    std::unique_ptr<WebsocketSessionTokens> sessionTokens;
+    /// Queues with pending messages, only used by the seasocks thread
+    std::set<std::shared_ptr<WebsocketOutboundQueue>> backloggedQueues;
+    std::atomic<bool> hasBacklog;
     seasocks::Server server;
     std::thread serverThread;
 
-    /// Converts events to json messages
-    std::string eventToJson(std::shared_ptr<IEvent> event);
+    /// Periodically retries to send messages of stalled clients
+    size_t retryTimer;
+    std::mutex drainMutex;
+    /// Sends coalesced batches, guarded by drainMutex
+    size_t flushTimer;
+    /// Earliest end of a coalescing window, guarded by drainMutex
+    std::chrono::steady_clock::time_point nextFlush;
+
+    /// Reads the compression, queue, journal and session settings from config/websocket.ini
+    void loadSettings();
+    /// Adds the metrics collector of the compression statistics
+    size_t addDeflateCollector();
+    /// Applies the options a client requested before the login
+    ///
+    /// \param coalesceWindow Receives the negotiated coalescing window
+    /// \returns The compression state if compression was negotiated
+    std::unique_ptr<WebsocketDeflate> applyOptions(WebsocketClientData& clientData,
+                                                   std::chrono::milliseconds& coalesceWindow);
+    /// Resumes a logged in client from the journal or requests a full chat listing
+    void synchronizeClient(seasocks::WebSocket* socket);
+    /// Sends a new session token to a client which just logged in
+    void issueSessionToken(seasocks::WebSocket* socket);
+    /// Logs a client in by the option "token", the login database answers valid tokens
+    ///
+    /// \param loginData Identifies the connection like the data of an EventLogin
+    void handleTokenLogin(void* loginData, const std::string& token);
+    /// Handles the options "revoke" and "revoke_all" of logged in clients
+    void handleSessionOption(seasocks::WebSocket* socket, const std::string& name, const std::string& value);
+    /// Sends queued messages of stalled clients, called from the seasocks thread
+    void drainBackloggedQueues();
+    /// Schedules a drain at the given time to send coalesced batches
+    void scheduleFlush(std::chrono::steady_clock::time_point deadline);
+    /// Sends a message to a client, compressed if negotiated
+    ///
+    /// \param event Traced up to the socket write if latency tracing is enabled
+    void sendToClient(WebsocketClientData& clientData, const std::string& message, const IEvent* event = nullptr);
 public:
     /// Constructor
     ///
@@ -38,6 +97,14 @@ public:
     /// Removes a client on disconnect
     void removeClient(seasocks::WebSocket* socket);
 
+    /// Converts events to the document tree which is shared by all encodings
+    static Json::Value eventToValue(std::shared_ptr<IEvent> event, WebsocketEncoding encoding);
+    /// Serializes events for clients, returns an empty string for internal events
+    ///
+    /// \param sequence Journal sequence number of the event, 0 if it is not journaled
+    static std::string encodeEvent(std::shared_ptr<IEvent> event, WebsocketEncoding encoding, uint64_t sequence = 0);
+
+
     virtual bool onEvent(std::shared_ptr<IEvent> event) override;
 };
 
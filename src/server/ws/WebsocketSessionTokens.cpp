@@ -0,0 +1,142 @@
+#include "WebsocketSessionTokens.hpp"
+#include "utils/Ini.hpp"
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+
+static string toHex(const std::string& data) {
+    static const char digits[] = "0123456789abcdef";
+    string hex;
+    hex.reserve(data.size() * 2);
+    for (unsigned char c : data) {
+        hex += digits[c >> 4];
+        hex += digits[c & 0x0f];
+    }
+    return hex;
+}
+
+/// Reads a number which has to span the whole string
+template<typename T>
+static bool readNumber(const std::string& data, T& value) {
+    if (data.empty() || data.find_first_not_of("0123456789") != string::npos)
+        return false;
+    istringstream is(data);
+    return static_cast<bool>(is >> value);
+}
+
+WebsocketSessionTokens::Settings::Settings()
+    : enabled{true}
+    , lifetime{7 * 24 * 3600}
+{
+}
+
+WebsocketSessionTokens::WebsocketSessionTokens(const Settings& settings, const std::string& revocationFile)
+    : settings{settings}
+    , revocationFile{revocationFile}
+{
+    Ini ini(revocationFile);
+    auto& users = ini.expectCategory("users");
+    for (auto& entry : users) {
+        size_t userId;
+        uint64_t until;
+        if (readNumber(entry.first, userId) && readNumber(entry.second, until))
+            revokedUsers[userId] = until;
+    }
+    auto& tokens = ini.expectCategory("tokens");
+    for (auto& entry : tokens) {
+        uint64_t expires;
+        if (readNumber(entry.second, expires))
+            revokedTokens[entry.first] = expires;
+    }
+}
+
+uint64_t WebsocketSessionTokens::now() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool WebsocketSessionTokens::isEnabled() const {
+    return settings.enabled && !settings.secret.empty();
+}
+
+std::string WebsocketSessionTokens::issue(size_t userId, uint64_t& expires) {
+    uint64_t issued = now();
+    expires = issued + chrono::duration_cast<chrono::milliseconds>(settings.lifetime).count();
+    ostringstream payload;
+    payload << userId << '.' << issued << '.' << expires << '.' << toHex(crypto.genSalt(16));
+    string data = payload.str();
+    return data + '.' + toHex(crypto.sign(settings.secret, data));
+}
+
+bool WebsocketSessionTokens::parse(const std::string& token, size_t& userId, uint64_t& issued, uint64_t& expires, std::string& id) {
+    if (!isEnabled()) return false;
+
+    size_t signatureStart = token.rfind('.');
+    if (signatureStart == string::npos) return false;
+    string data = token.substr(0, signatureStart);
+    if (!Crypto::equals(toHex(crypto.sign(settings.secret, data)), token.substr(signatureStart + 1)))
+        return false;
+
+    vector<string> fields;
+    istringstream is(data);
+    string field;
+    while (getline(is, field, '.'))
+        fields.push_back(field);
+    if (fields.size() != 4
+        || !readNumber(fields[0], userId)
+        || !readNumber(fields[1], issued)
+        || !readNumber(fields[2], expires))
+        return false;
+    id = fields[3];
+    return expires > now();
+}
+
+bool WebsocketSessionTokens::verify(const std::string& token, size_t& userId) {
+    uint64_t issued, expires;
+    string id;
+    if (!parse(token, userId, issued, expires, id))
+        return false;
+
+    auto user = revokedUsers.find(userId);
+    if (user != revokedUsers.end() && issued <= user->second)
+        return false;
+    return revokedTokens.find(id) == revokedTokens.end();
+}
+
+bool WebsocketSessionTokens::revoke(const std::string& token, size_t userId) {
+    size_t tokenUserId;
+    uint64_t issued, expires;
+    string id;
+    if (!parse(token, tokenUserId, issued, expires, id) || tokenUserId != userId)
+        return false;
+    revokedTokens[id] = expires;
+    saveRevocations();
+    return true;
+}
+
+void WebsocketSessionTokens::revokeUser(size_t userId) {
+    revokedUsers[userId] = now();
+    saveRevocations();
+}
+
+void WebsocketSessionTokens::saveRevocations() {
+    // tokens issued before the lifetime are expired anyway
+    uint64_t current = now();
+    uint64_t oldest = current - chrono::duration_cast<chrono::milliseconds>(settings.lifetime).count();
+    for (auto it = revokedUsers.begin(); it != revokedUsers.end();)
+        it = it->second < oldest ? revokedUsers.erase(it) : ++it;
+    for (auto it = revokedTokens.begin(); it != revokedTokens.end();)
+        it = it->second < current ? revokedTokens.erase(it) : ++it;
+
+    Ini ini(revocationFile);
+    ini.deleteCategory("users");
+    ini.deleteCategory("tokens");
+    auto& users = ini.expectCategory("users");
+    for (auto& user : revokedUsers)
+        ini.setEntry(users, to_string(user.first), to_string(user.second));
+    auto& tokens = ini.expectCategory("tokens");
+    for (auto& token : revokedTokens)
+        ini.setEntry(tokens, token.first, to_string(token.second));
+    ini.write(true);
+}
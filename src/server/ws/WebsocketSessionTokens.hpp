@@ -0,0 +1,58 @@
+#ifndef WEBSOCKETSESSIONTOKENS_H
+#define WEBSOCKETSESSIONTOKENS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "utils/Crypto.hpp"
+
+
+/// Signed tokens which log a client in again without hashing its password.
+/// A token holds the user id, the issue and expiry time and a random id,
+/// signed with HMAC-SHA256: "<user>.<issued ms>.<expires ms>.<id>.<signature>".
+/// Revocations are stored in a separate ini file until the tokens expired.
+class WebsocketSessionTokens {
+public:
+    /// Read from the category "session" of config/websocket.ini
+    struct Settings {
+        Settings();
+        bool enabled;
+        /// Signing key, generated on the first start
+        std::string secret;
+        std::chrono::seconds lifetime;
+    };
+private:
+    Settings settings;
+    std::string revocationFile;
+    /// Keeps OpenSSL initialized while tokens are verified
+    Crypto crypto;
+    /// Tokens issued up to the time are invalid, by user id
+    std::unordered_map<size_t, uint64_t> revokedUsers;
+    /// Expiry of single revoked tokens by token id
+    std::unordered_map<std::string, uint64_t> revokedTokens;
+
+    static uint64_t now();
+    /// Splits and checks the signature and expiry, ignores revocations
+    bool parse(const std::string& token, size_t& userId, uint64_t& issued, uint64_t& expires, std::string& id);
+    /// Drops expired revocations and writes the others
+    void saveRevocations();
+public:
+    WebsocketSessionTokens(const Settings& settings, const std::string& revocationFile);
+
+    bool isEnabled() const;
+    /// Returns a new token of the user
+    ///
+    /// \param expires Receives the expiry in milliseconds since the epoch
+    std::string issue(size_t userId, uint64_t& expires);
+    /// True if the token is signed, not expired and not revoked
+    bool verify(const std::string& token, size_t& userId);
+    /// Revokes a single token of the user
+    ///
+    /// \returns false if the token is invalid or belongs to another user
+    bool revoke(const std::string& token, size_t userId);
+    /// Revokes all tokens of the user issued until now
+    void revokeUser(size_t userId);
+};
+
+#endif
@@ -11,9 +11,9 @@
 // ...
 #include "utils/IdProvider.hpp"
 #include "utils/ModuleProvider.hpp"
+#include "utils/Logger.hpp"
 
 #include <limits>
-#include <iostream>
 #include <iomanip>
 #include <ctime>
 #include <string>
@@ -24,6 +24,9 @@ PROVIDE_EVENTLOOP_MODULE("hack_backlog", "default", HackBacklogService)
 using namespace Query;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("hack_backlog");
+
+
 HackBacklogService::HackBacklogService(EventQueue* appQueue)
     : EventLoop({
                     EventDatabaseQuery::uuid
@@ -98,7 +101,7 @@ bool HackBacklogService::setupTable_processResult(std::shared_ptr<IEvent> event)
 
             databaseInitialized = true;
         } else {
-            std::cout << "Error setting up hack backlog service. Could not setup table. Service will be disabled" << std::endl;
+            LOG_ERROR(logModule) << "could not set up the table, the service is disabled";
             getEventQueue()->setEnabled(false);
             heldBackEvents.clear();
             appQueue->sendEvent(std::make_shared<EventHackServiceInit>());
@@ -120,13 +123,13 @@ bool HackBacklogService::setupTable_processId(std::shared_ptr<IEvent> event) {
             if (results.size() > 0)
                 std::istringstream(results.front()) >> lastId;
             IdProvider::getInstance().setLowestId("hack_log", lastId);
-            std::cout << "Database Last ID: " << lastId << std::endl;
+            LOG_INFO(logModule) << "fetched the last id" << logField("id", lastId);
 
             appQueue->sendEvent(std::make_shared<EventHackServiceInit>());
 
             lastIdFetched = true;
         } else {
-            std::cout << "Error setting up hack backlog service. Could not fetch last id. Service will be disabled" << std::endl;
+            LOG_ERROR(logModule) << "could not fetch the last id, the service is disabled";
             getEventQueue()->setEnabled(false);
             heldBackEvents.clear();
             appQueue->sendEvent(std::make_shared<EventHackServiceInit>());
@@ -271,7 +274,7 @@ bool HackBacklogService::processEvent(std::shared_ptr<IEvent> event) {
                                     std::istringstream ss(*it++); // read in time
                                     ss >> std::get_time(&t, "%Y-%m-%d %H:%M:%S");
                                     if (ss.fail()) {
-                                        std::cout << "Could not parse date from backlog response" << std::endl;
+                                        LOG_WARNING(logModule) << "could not parse the date of a backlog response";
                                     }
                                     std::time_t time = std::mktime(&t);
 
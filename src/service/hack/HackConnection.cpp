@@ -1,4 +1,3 @@
-#include <iostream>
 #include <thread>
 #include <json/json.h>
 #include "HackConnection.hpp"
@@ -17,11 +16,15 @@
 #include "event/hack/EventHackNickModified.hpp"
 #include "event/hack/EventHackUserlistReceived.hpp"
 #include "utils/Cpp11Utils.hpp"
+#include "utils/Logger.hpp"
 
 using namespace std;
 namespace ws = websocketpp;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("hack");
+
+
 HackConnection::HackConnection(EventQueue* appQueue,
                                size_t userId,
                                const HackServerConfiguration& configuration)
@@ -107,7 +110,7 @@ void HackConnection::connect() {
     WebsocketClient::connection_ptr con = _endpoint->get_connection(urlOs.str(), ec);
 
     if (ec) {
-        std::cerr << "> Connect initialization error: " << ec.message() << std::endl;
+        LOG_ERROR(logModule) << "connect initialization failed" << logField("error", ec.message());
         return;
     }
 
@@ -121,19 +124,19 @@ void HackConnection::connect() {
         ws::lib::error_code ec;
         _endpoint->send(hdl, Json::FastWriter{}.write(root), ws::frame::opcode::text, ec);
         if (ec) {
-            std::cerr << "Failed to send ws message: " << ec.message() << std::endl;
+            LOG_ERROR(logModule) << "could not send a message" << logField("error", ec.message());
             _endpoint->close(hdl, ws::close::status::normal, "", ec);
             if (ec) {
-                std::cerr << "Error during close operation: " << ec.message() << std::endl;
+                LOG_ERROR(logModule) << "could not close the connection" << logField("error", ec.message());
             }
         }
     });
     con->set_fail_handler([this](ws::connection_hdl hdl){
-        std::cout << "Connection failed" << std::endl;
+        LOG_WARNING(logModule) << "connection failed";
     });
     con->set_message_handler([this](ws::connection_hdl hdl,
                                     WebsocketClient::message_ptr message){
-        std::cout << "Message: " << message << std::endl;
+        LOG_TRACE(logModule) << "received message" << logField("payload", message->get_payload());
     });
 
     _endpoint->connect(con);
@@ -143,7 +146,7 @@ bool HackConnection::onEvent(std::shared_ptr<IEvent> event) {
     UUID type = event->getEventUuid();
     if (type == EventQuit::uuid) {
         running = false;
-        std::cout << "[HC] received QUIT" << std::endl;
+        LOG_DEBUG(logModule) << "received quit";
         return false;
     }
     return true;
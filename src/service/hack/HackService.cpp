@@ -18,12 +18,15 @@
 #include "event/hack/EventHackReconnectServer.hpp"
 #include "service/hack/HackChannelStore.hpp"
 #include "utils/IdProvider.hpp"
-#include <iostream>
+#include "utils/Logger.hpp"
 #include <mutex>
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("hack");
+
+
 HackService::HackService(size_t userId, EventQueue* appQueue)
     : EventLoop({
           EventQuit::uuid,
@@ -49,11 +52,11 @@ bool HackService::onEvent(std::shared_ptr<IEvent> event) {
 
     auto activateUser = event->as<EventHackActivateService>();
     if (activateUser) {
-        cout << "[US] Received ActivateUser" << endl;
+        LOG_DEBUG(logModule) << "activating user" << logField("user", userId);
         auto& loginConfiguration = activateUser->getLoginConfiguration();
         for (auto entry : loginConfiguration) {
             auto& hackConfiguration = entry.second;
-            cout << "[US] CONFIG: " << hackConfiguration.getServerId() << endl;
+            LOG_DEBUG(logModule) << "adding server" << logField("user", userId) << logField("server", hackConfiguration.getServerId());
             hackConnections.emplace(piecewise_construct,
                                     forward_as_tuple(hackConfiguration.getServerId()),
                                     forward_as_tuple(appQueue, userId, hackConfiguration));
@@ -61,7 +64,7 @@ bool HackService::onEvent(std::shared_ptr<IEvent> event) {
     }
 
     if (type == EventQuit::uuid) {
-        cout << "[US] received QUIT" << endl;
+        LOG_DEBUG(logModule) << "received quit" << logField("user", userId);
         hackConnections.clear();
         return false;
     } else if (type == EventHackReconnectServer::uuid) {
@@ -114,7 +117,9 @@ bool HackService::onEvent(std::shared_ptr<IEvent> event) {
         }
     } else if (type == EventQuery::uuid) {
         auto query = event->as<EventQuery>();
-        if (query->getType() == EventQueryType::Chats) {
+        // hack listings always contain the users
+        if (query->getType() == EventQueryType::Chats
+            || query->getType() == EventQueryType::ChatsWithoutUsers) {
             size_t firstId = IdProvider::getInstance().getLastId("hack_log"); // for backlog requests
             auto listing = make_shared<EventHackChatListing>(firstId, userId, query->getData());
 
@@ -142,7 +147,7 @@ bool HackService::onEvent(std::shared_ptr<IEvent> event) {
                 }
             }
 
-            cout << "[US] Sending chat listing" << endl;
+            LOG_DEBUG(logModule) << "sending chat listing" << logField("user", userId);
             appQueue->sendEvent(listing);
         }
         else if (query->getType() == EventQueryType::Settings) {
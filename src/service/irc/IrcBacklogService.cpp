@@ -14,9 +14,9 @@
 #include "event/irc/EventIrcBacklogResponse.hpp"
 #include "utils/IdProvider.hpp"
 #include "utils/ModuleProvider.hpp"
+#include "utils/Logger.hpp"
 
 #include <limits>
-#include <iostream>
 #include <iomanip>
 #include <ctime>
 #include <string>
@@ -27,6 +27,9 @@ PROVIDE_EVENTLOOP_MODULE("irc_backlog", "default", IrcBacklogService)
 using namespace Query;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("irc_backlog");
+
+
 IrcBacklogService::IrcBacklogService(EventQueue* appQueue)
     : EventLoop({
                     EventDatabaseQuery::uuid
@@ -40,6 +43,7 @@ IrcBacklogService::IrcBacklogService(EventQueue* appQueue)
     , appQueue{appQueue}
     , databaseInitialized{false}
     , lastIdFetched{false}
+    , droppedEvents{0}
 {
 }
 
@@ -100,7 +104,7 @@ bool IrcBacklogService::setupTable_processResult(std::shared_ptr<IEvent> event)
 
             databaseInitialized = true;
         } else {
-            std::cout << "Error setting up irc backlog service. Could not setup table. Service will be disabled" << std::endl;
+            LOG_ERROR(logModule) << "could not set up the table, the service is disabled";
             getEventQueue()->setEnabled(false);
             heldBackEvents.clear();
             appQueue->sendEvent(std::make_shared<EventIrcServiceInit>());
@@ -122,13 +126,13 @@ bool IrcBacklogService::setupTable_processId(std::shared_ptr<IEvent> event) {
             if (results.size() > 0)
                 std::istringstream(results.front()) >> lastId;
             IdProvider::getInstance().setLowestId("irc_log", lastId);
-            std::cout << "Database Last ID: " << lastId << std::endl;
+            LOG_INFO(logModule) << "fetched the last id" << logField("id", lastId);
 
             appQueue->sendEvent(std::make_shared<EventIrcServiceInit>());
 
             lastIdFetched = true;
         } else {
-            std::cout << "Error setting up irc backlog service. Could not fetch last id. Service will be disabled" << std::endl;
+            LOG_ERROR(logModule) << "could not fetch the last id, the service is disabled";
             getEventQueue()->setEnabled(false);
             heldBackEvents.clear();
             appQueue->sendEvent(std::make_shared<EventIrcServiceInit>());
@@ -139,14 +143,14 @@ bool IrcBacklogService::setupTable_processId(std::shared_ptr<IEvent> event) {
 }
 
 void IrcBacklogService::writeBacklog(std::shared_ptr<IUserEvent> event,
-                                     IrcLoggable* loggable,
+                                     size_t messageId,
                                      const std::string& message,
                                      IrcDatabaseMessageType type,
                                      const std::string& flags,
                                      const std::string& from,
                                      const std::string& channel) {
     std::vector<std::string> data {
-        std::to_string(loggable->getLogEntryId()),
+        std::to_string(messageId),
         std::to_string(event->getUserId()),
         convertTimestamp(event->getTimestamp()),
         message,
@@ -170,6 +174,15 @@ void IrcBacklogService::writeBacklog(std::shared_ptr<IUserEvent> event,
     appQueue->sendEvent(std::make_shared<EventDatabaseQuery>(getEventQueue(), event, std::move(stmt)));
 }
 
+void IrcBacklogService::holdBack(std::shared_ptr<IEvent> event) {
+    if (heldBackEvents.size() >= maxHeldBackEvents) {
+        if (droppedEvents++ == 0)
+            LOG_WARNING(logModule) << "database is not ready yet, dropping the oldest held back events";
+        heldBackEvents.pop_front();
+    }
+    heldBackEvents.push_back(event);
+}
+
 bool IrcBacklogService::processEvent(std::shared_ptr<IEvent> event) {
     UUID eventType = event->getEventUuid();
 
@@ -183,7 +196,7 @@ bool IrcBacklogService::processEvent(std::shared_ptr<IEvent> event) {
             if (!setupTable_processResult(event))
                 return false;
         } else {
-            heldBackEvents.push_back(event);
+            holdBack(event);
         }
     } else if (!lastIdFetched) {
         if(eventType == EventDatabaseResult::uuid) {
@@ -193,8 +206,10 @@ bool IrcBacklogService::processEvent(std::shared_ptr<IEvent> event) {
             for (auto e : heldBackEvents)
                 processEvent(e);
             heldBackEvents.clear();
+            if (droppedEvents > 0)
+                LOG_WARNING(logModule) << "dropped events while waiting for the database" << logField("dropped", droppedEvents);
         } else {
-            heldBackEvents.push_back(event);
+            holdBack(event);
         }
     } else {
         auto loggable = event->as<IrcLoggable>();
@@ -272,7 +287,7 @@ bool IrcBacklogService::processEvent(std::shared_ptr<IEvent> event) {
                                     std::istringstream ss(*it++); // read in time
                                     ss >> std::get_time(&t, "%Y-%m-%d %H:%M:%S");
                                     if (ss.fail()) {
-                                        std::cout << "Could not parse date from backlog response" << std::endl;
+                                        LOG_WARNING(logModule) << "could not parse the date of a backlog response";
                                     }
                                     std::time_t time = std::mktime(&t);
 
@@ -309,7 +324,7 @@ bool IrcBacklogService::processEvent(std::shared_ptr<IEvent> event) {
                 {
                     auto message = event->as<EventIrcMessage>();
                     writeBacklog(std::static_pointer_cast<IUserEvent>(event),
-                                 loggable,
+                                 loggable->getLogEntryId(),
                                  message->getMessage(),
                                  message->getType() == IrcMessageType::Message
                                  ? IrcDatabaseMessageType::Message
@@ -323,7 +338,7 @@ bool IrcBacklogService::processEvent(std::shared_ptr<IEvent> event) {
                 {
                     auto action = event->as<EventIrcAction>();
                     writeBacklog(std::static_pointer_cast<IUserEvent>(event),
-                                 loggable,
+                                 loggable->getLogEntryId(),
                                  action->getMessage(),
                                  IrcDatabaseMessageType::Action,
                                  "0",
@@ -346,13 +361,29 @@ bool IrcBacklogService::processEvent(std::shared_ptr<IEvent> event) {
                     case EventIrcUserStatusChanged::Status::Quit:
                         messageType = IrcDatabaseMessageType::Quit; break;
                     }
-                    writeBacklog(std::static_pointer_cast<IUserEvent>(event),
-                                 loggable,
-                                 statusChange->getReason(),
-                                 messageType,
-                                 "0",
-                                 statusChange->getUsername(),
-                                 statusChange->getChannel());
+                    auto& channels = statusChange->getChannels();
+                    if (channels.empty()) {
+                        writeBacklog(std::static_pointer_cast<IUserEvent>(event),
+                                     loggable->getLogEntryId(),
+                                     statusChange->getReason(),
+                                     messageType,
+                                     "0",
+                                     statusChange->getUsername(),
+                                     statusChange->getChannel());
+                    } else {
+                        // one entry per channel of a quit, each needs its own id
+                        size_t messageId = loggable->getLogEntryId();
+                        for (auto& channel : channels) {
+                            writeBacklog(std::static_pointer_cast<IUserEvent>(event),
+                                         messageId,
+                                         statusChange->getReason(),
+                                         messageType,
+                                         "0",
+                                         statusChange->getUsername(),
+                                         channel);
+                            messageId = IdProvider::getInstance().generateNewId("irc_log");
+                        }
+                    }
                     break;
                 }
             }
@@ -8,7 +8,6 @@
 
 
 class IUserEvent;
-class IrcLoggable;
 enum class IrcDatabaseMessageType : int;
 /// Initializes the database layout on startup,
 /// buffers all messages until the last id is received from the database
@@ -23,6 +22,12 @@ class IrcBacklogService : public EventLoop {
     bool lastIdFetched;
     /// If database is not ready yet keep all requests and process later
     std::list<std::shared_ptr<IEvent>> heldBackEvents;
+    /// Upper bound of heldBackEvents, older events are dropped beyond it
+    static const size_t maxHeldBackEvents = 10000;
+    /// Events dropped because the database didn't get ready in time
+    size_t droppedEvents;
+    /// Keeps an event until the database is ready
+    void holdBack(std::shared_ptr<IEvent> event);
     /// Process some event. Called from onEvent callback
     /// If the database is not ready yet all non-relevant events will
     /// be held back and processed after the initialization
@@ -54,8 +59,10 @@ private:
     /// When the last message id from the backlog was received, set it as the last id for the IdProvider instance
     bool setupTable_processId(std::shared_ptr<IEvent> event);
     /// Adds a single message into the backlog table
+    ///
+    /// \param messageId Unique id of the backlog entry
     void writeBacklog(std::shared_ptr<IUserEvent> event,
-                      IrcLoggable* loggable,
+                      size_t messageId,
                       const std::string& message,
                       IrcDatabaseMessageType type,
                       const std::string& flags,
@@ -1,6 +1,6 @@
 #include "IrcChannelStore.hpp"
 #include <algorithm>
-#include <iterator>
+#include <limits>
 
 using namespace std;
 
@@ -11,13 +11,6 @@ IrcUserStore::IrcUserStore(const std::string& nick, const std::string& mode)
 {
 }
 
-void IrcUserStore::setNick(const std::string& lnick) {
-    nick = lnick;
-}
-void IrcUserStore::setMode(const std::string& lmode) {
-    mode = lmode;
-}
-
 std::string IrcUserStore::getNick() const {
     return nick;
 }
@@ -26,83 +19,194 @@ std::string IrcUserStore::getMode() const {
     return mode;
 }
 
-void IrcUserStore::addMode(char modeChar) {
-    if (mode.find(modeChar) == string::npos)
-        mode.push_back(modeChar);
-}
-
-void IrcUserStore::removeMode(char modeChar) {
-    mode.erase(std::remove(mode.begin(), mode.end(), modeChar), mode.end());
-}
+namespace {
+    const IrcNickTable::Id erasedId = std::numeric_limits<IrcNickTable::Id>::max();
+    const size_t minimumSlots = 8;
 
-std::string IrcChannelStore::nickToLower(const std::string& nick) {
-    string nickLower;
-    transform(nickLower.begin(), nickLower.end(), std::back_inserter(nickLower), ::tolower);
-    return nickLower;
+    size_t slotOf(IrcNickTable::Id id, size_t mask) {
+        // multiplicative hashing spreads the sequential ids over the table
+        return (static_cast<uint32_t>(id) * 2654435761u) & mask;
+    }
 }
 
-IrcChannelStore::IrcChannelStore(const std::string& channelPassword,
+IrcChannelStore::IrcChannelStore(IrcNickTable* nicks,
+                                 const std::string& channelPassword,
                                  bool disabled)
-    : channelPassword{channelPassword}
+    : nicks{nicks}
+    , channelPassword{channelPassword}
+    , memberCount{0}
+    , erasedCount{0}
     , disabled{disabled}
+    , modified{true}
 {
 }
 
-void IrcChannelStore::clear() {
-    users.clear();
+IrcChannelStore::~IrcChannelStore() {
+    clear();
 }
 
-void IrcChannelStore::addUser(const std::string& nick, const std::string& mode) {
-    string nickLower = nickToLower(nick);
-    users.emplace(piecewise_construct,
-                  forward_as_tuple(nickLower),
-                  forward_as_tuple(nick, mode));
+IrcChannelStore::Member* IrcChannelStore::findMember(IrcNickTable::Id id) {
+    const IrcChannelStore* constThis = this;
+    return const_cast<Member*>(constThis->findMember(id));
 }
 
-void IrcChannelStore::removeUser(const std::string& nick) {
-    string nickLower = nickToLower(nick);
-    auto it = users.find(nickLower);
-    if (it != users.end())
-        users.erase(it);
+const IrcChannelStore::Member* IrcChannelStore::findMember(IrcNickTable::Id id) const {
+    if (id == 0 || members.empty()) return nullptr;
+    size_t mask = members.size() - 1;
+    for (size_t slot = slotOf(id, mask); ; slot = (slot + 1) & mask) {
+        const Member& member = members[slot];
+        if (member.id == id) return &member;
+        if (member.id == 0) return nullptr;
+    }
 }
 
-void IrcChannelStore::renameUser(const std::string& nick, const std::string& newNick) {
-    string nickLower = nickToLower(nick);
-
-    auto it = users.find(nickLower);
-    if (it == users.end()) return;
+bool IrcChannelStore::insertMember(IrcNickTable::Id id, uint8_t modeBits) {
+    // keep at least a quarter of the slots empty so probing terminates fast
+    if ((memberCount + erasedCount + 1) * 4 > members.size() * 3) {
+        // grow only if the members need the space, otherwise drop the erased slots
+        size_t size = max(minimumSlots, members.size());
+        if ((memberCount + 1) * 2 > size)
+            size *= 2;
+        rehash(size);
+    }
+    if (findMember(id)) return false;
+
+    size_t mask = members.size() - 1;
+    size_t slot = slotOf(id, mask);
+    while (members[slot].id != 0 && members[slot].id != erasedId)
+        slot = (slot + 1) & mask;
+    if (members[slot].id == erasedId)
+        erasedCount -= 1;
+    members[slot] = Member{id, modeBits};
+    memberCount += 1;
+    return true;
+}
+
+void IrcChannelStore::rehash(size_t size) {
+    vector<Member> previous(size, Member{0, 0});
+    previous.swap(members);
+    erasedCount = 0;
+    size_t mask = members.size() - 1;
+    for (const Member& member : previous) {
+        if (member.id == 0 || member.id == erasedId) continue;
+        size_t slot = slotOf(member.id, mask);
+        while (members[slot].id != 0)
+            slot = (slot + 1) & mask;
+        members[slot] = member;
+    }
+}
 
-    string newNickLower = nickToLower(newNick);
+void IrcChannelStore::clear() {
+    modified = true;
+    for (const Member& member : members) {
+        if (member.id != 0 && member.id != erasedId)
+            nicks->release(member.id);
+    }
+    members.clear();
+    members.shrink_to_fit();
+    memberCount = 0;
+    erasedCount = 0;
+}
 
-    IrcUserStore& userStore = it->second;
-    userStore.setNick(newNick);
+void IrcChannelStore::addUser(const std::string& nick, const std::string& mode) {
+    IrcNickTable::Id id = nicks->intern(nick);
+    if (id == 0) return;
+    // every channel holds one reference of its users
+    if (!insertMember(id, nicks->toModeBits(mode)))
+        nicks->release(id);
+    else
+        modified = true;
+}
 
-    if (nickLower != newNickLower) {
-        users.emplace(piecewise_construct,
-                      forward_as_tuple(newNickLower),
-                      forward_as_tuple(userStore));
-        users.erase(it);
-    }
+void IrcChannelStore::removeUser(const std::string& nick) {
+    Member* member = findMember(nicks->find(nick));
+    if (member == nullptr) return;
+    IrcNickTable::Id id = member->id;
+    member->id = erasedId;
+    member->modeBits = 0;
+    memberCount -= 1;
+    erasedCount += 1;
+    modified = true;
+    nicks->release(id);
+}
+
+bool IrcChannelStore::hasUser(const std::string& nick) const {
+    return findMember(nicks->find(nick)) != nullptr;
+}
+
+void IrcChannelStore::mergeUser(IrcNickTable::Id from, IrcNickTable::Id into) {
+    Member* member = findMember(from);
+    if (member == nullptr) return;
+    uint8_t modeBits = member->modeBits;
+    member->id = erasedId;
+    member->modeBits = 0;
+    memberCount -= 1;
+    erasedCount += 1;
+    modified = true;
+    // the reference of from belongs to into already, a second membership drops it
+    if (!insertMember(into, modeBits))
+        nicks->release(into);
 }
 
 void IrcChannelStore::changeUserMode(const std::string& nick, char mode, bool add) {
-    string nickLower = nickToLower(nick);
-    auto userIt = users.find(nickLower);
-    if (userIt != users.end()) {
-        auto& user = userIt->second;
-
-        if (add) {
-            user.addMode(mode);
-        } else {
-            user.removeMode(mode);
-        }
+    uint8_t modeBit = nicks->getModeBit(mode);
+    if (modeBit == 0) return; // no channel user mode
+    Member* member = findMember(nicks->find(nick));
+    if (member == nullptr) return;
+    if (add)
+        member->modeBits |= modeBit;
+    else
+        member->modeBits &= ~modeBit;
+    modified = true;
+}
+
+size_t IrcChannelStore::getUserCount() const {
+    return memberCount;
+}
+
+std::vector<IrcNickTable::Id> IrcChannelStore::getUserIds() const {
+    std::vector<IrcNickTable::Id> ids;
+    ids.reserve(memberCount);
+    for (const Member& member : members) {
+        if (member.id != 0 && member.id != erasedId)
+            ids.push_back(member.id);
     }
+    return ids;
 }
 
-const std::map<std::string, IrcUserStore>& IrcChannelStore::getUsers() const {
+std::vector<IrcChannelStore::Member> IrcChannelStore::getMembers() const {
+    std::vector<Member> users;
+    users.reserve(memberCount);
+    for (const Member& member : members) {
+        if (member.id != 0 && member.id != erasedId)
+            users.push_back(member);
+    }
     return users;
 }
 
+std::vector<IrcUserStore> IrcChannelStore::getUsersAfter(const std::string& nick, size_t count, bool& complete) const {
+    string after = nicks->fold(nick);
+    vector<const Member*> candidates;
+    for (const Member& member : members) {
+        if (member.id == 0 || member.id == erasedId) continue;
+        if (nick.empty() || nicks->getFolded(member.id) > after)
+            candidates.push_back(&member);
+    }
+
+    size_t pageSize = min(count, candidates.size());
+    auto byNick = [this](const Member* a, const Member* b) {
+        return nicks->getFolded(a->id) < nicks->getFolded(b->id);
+    };
+    partial_sort(candidates.begin(), candidates.begin() + pageSize, candidates.end(), byNick);
+
+    std::vector<IrcUserStore> page;
+    page.reserve(pageSize);
+    for (size_t i = 0; i < pageSize; ++i)
+        page.emplace_back(nicks->getNick(candidates[i]->id), nicks->toModeString(candidates[i]->modeBits));
+    complete = pageSize == candidates.size();
+    return page;
+}
+
 std::string IrcChannelStore::getChannelPassword() const {
     return channelPassword;
 }
@@ -113,6 +217,7 @@ bool IrcChannelStore::getDisabled() const {
 
 void IrcChannelStore::setDisabled(bool ldisabled) {
     disabled = ldisabled;
+    modified = true;
 }
 
 std::string IrcChannelStore::getTopic() const {
@@ -121,4 +226,13 @@ std::string IrcChannelStore::getTopic() const {
 
 void IrcChannelStore::setTopic(const std::string& topic) {
     channelTopic = topic;
+    modified = true;
+}
+
+bool IrcChannelStore::getModified() const {
+    return modified;
+}
+
+void IrcChannelStore::setModified(bool lmodified) {
+    modified = lmodified;
 }
@@ -1,35 +1,60 @@
 #ifndef IRCCHANNELSTORE_H
 #define IRCCHANNELSTORE_H
 
-#include <map>
+#include <cstdint>
 #include <string>
+#include <vector>
+#include "IrcNickTable.hpp"
 
-/// User specific settings for a channel
+/// User specific settings for a channel, copied out of the channel's nick ids
 class IrcUserStore {
     std::string nick;
     std::string mode;
 public:
     IrcUserStore(const std::string& nick, const std::string& mode);
-    void setNick(const std::string& nick);
-    void setMode(const std::string& mode);
     std::string getNick() const;
     std::string getMode() const;
-    void addMode(char mode);
-    void removeMode(char mode);
 };
 
 /// Channel settings used inside the IrcConnection
 class IrcChannelStore {
+public:
+    /// Slot of the open addressing member table
+    struct Member {
+        IrcNickTable::Id id;
+        uint8_t modeBits;
+    };
+private:
+    IrcNickTable* nicks;
     std::string channelPassword;
     std::string channelTopic;
-    std::map<std::string, IrcUserStore> users;
+    /// Flat hash of nick ids with linear probing, the size is a power of two
+    std::vector<Member> members;
+    size_t memberCount;
+    /// Amount of erased slots, probing continues over them
+    size_t erasedCount;
     bool disabled;
+    /// Set on every change, used to publish snapshots of changed channels only
+    bool modified;
 
-    /// convert a nick to lowercase
-    std::string nickToLower(const std::string& nick);
+    /// Returns the slot of the id or nullptr if it isn't a member
+    Member* findMember(IrcNickTable::Id id);
+    const Member* findMember(IrcNickTable::Id id) const;
+    /// Inserts an id, returns false if it was already a member
+    bool insertMember(IrcNickTable::Id id, uint8_t modeBits);
+    /// Rebuilds the slots with the given size
+    void rehash(size_t size);
 public:
-    IrcChannelStore(const std::string& channelPassword,
+    /// Constructor
+    ///
+    /// \param nicks Nick table of the connection, has to outlive the channel
+    IrcChannelStore(IrcNickTable* nicks,
+                    const std::string& channelPassword,
                     bool disabled);
+    /// Releases the nicks of all users
+    ~IrcChannelStore();
+    IrcChannelStore(const IrcChannelStore&) = delete;
+    IrcChannelStore& operator=(const IrcChannelStore&) = delete;
 
     /// remove all users from the channel
     void clear();
@@ -37,19 +62,28 @@ public:
     void addUser(const std::string& nick, const std::string& mode);
     /// remove a single user from the channel
     void removeUser(const std::string& nick);
-    /// rename a user
-    ///
-    /// \param nick Old nickname
-    /// \param newNick New nickname
-    void renameUser(const std::string& nick, const std::string& newNick);
+    /// True if the nick is in the channel
+    bool hasUser(const std::string& nick) const;
+    /// Replaces a nick id which was merged by the nick table, see IrcNickTable::Merge
+    void mergeUser(IrcNickTable::Id from, IrcNickTable::Id into);
     /// Change the irc user mode of a user
     ///
     /// \param nick Current nickname
     /// \param mode New mode char
     /// \param add True to add or false to remove a mode
     void changeUserMode(const std::string& nick, char mode, bool add);
-    /// Returns the map of users to stored data
-    const std::map<std::string, IrcUserStore>& getUsers() const;
+    /// Returns the amount of users in the channel
+    size_t getUserCount() const;
+    /// Returns the interned nicks of all users, unsorted
+    std::vector<IrcNickTable::Id> getUserIds() const;
+    /// Returns the interned users with their mode bits, unsorted
+    std::vector<Member> getMembers() const;
+    /// Returns up to count users which are sorted after the given nick by their folded nick
+    ///
+    /// \param nick Last nick of the previous page, empty to start with the first user
+    /// \param count Maximum amount of returned users
+    /// \param complete Set to true if no further users follow
+    std::vector<IrcUserStore> getUsersAfter(const std::string& nick, size_t count, bool& complete) const;
     /// Returns the channel's password that is currently used
     std::string getChannelPassword() const;
     /// True if the channel is disabled
@@ -60,6 +94,10 @@ public:
     std::string getTopic() const;
     /// Sets the topic string
     void setTopic(const std::string& topic);
+    /// True if the channel changed since the last snapshot
+    bool getModified() const;
+    /// Marks the channel as changed or as published
+    void setModified(bool modified);
 };
 
 #endif
@@ -17,18 +17,43 @@
 #include "event/irc/EventIrcChangeNick.hpp"
 #include "event/irc/EventIrcUserlistReceived.hpp"
 #include "event/irc/EventIrcModeChanged.hpp"
+#include "event/irc/EventIrcRequestUserlist.hpp"
+#include "event/irc/EventIrcUserlistPage.hpp"
+#include "utils/Logger.hpp"
 #include <algorithm>
-#include <iostream>
 #include <sstream>
 #include <map>
 #include <thread>
 #include <chrono>
 #include <libirc_rfcnumeric.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <unistd.h>
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("irc");
+
 static map<irc_session_t*, IrcConnection*> activeIrcConnections;
+/// 005 is named RPL_BOUNCE by libircclient, servers use it for ISUPPORT
+static const unsigned int RPL_ISUPPORT = 5;
+
+IrcConnection::Metrics::Metrics()
+    : waiting(MetricsRegistry::getInstance().getGauge("harpoon_irc_connections", "IRC connections per state", {{"state", "waiting"}}))
+    , connecting(MetricsRegistry::getInstance().getGauge("harpoon_irc_connections", "IRC connections per state", {{"state", "connecting"}}))
+    , registered(MetricsRegistry::getInstance().getGauge("harpoon_irc_connections", "IRC connections per state", {{"state", "registered"}}))
+    , messagesIn(MetricsRegistry::getInstance().getCounter("harpoon_irc_messages_total", "IRC messages and actions", {{"direction", "in"}}))
+    , messagesOut(MetricsRegistry::getInstance().getCounter("harpoon_irc_messages_total", "IRC messages and actions", {{"direction", "out"}}))
+    , linesSent(MetricsRegistry::getInstance().getCounter("harpoon_irc_lines_sent_total", "Lines sent through the send queues"))
+{
+}
+
+IrcConnection::Metrics& IrcConnection::getMetrics() {
+    static Metrics metrics;
+    return metrics;
+}
 
 template <void (IrcConnection::*F)(irc_session_t*, const char*, const char*, const vector<string>&, std::shared_ptr<IEvent>&)>
 void IrcConnection::onIrcEvent(irc_session_t* session,
@@ -45,8 +70,10 @@ void IrcConnection::onIrcEvent(irc_session_t* session,
     shared_ptr<IEvent> resultEvent;
     (cxn->*F)(session, event, origin, parameters, resultEvent);
     if (resultEvent) {
-        cxn->getEventQueue()->sendEvent(resultEvent);
-        cxn->appQueue->sendEvent(resultEvent);
+        UUID resultType = resultEvent->getEventUuid();
+        if (resultType == EventIrcMessage::uuid || resultType == EventIrcAction::uuid)
+            getMetrics().messagesIn.increment();
+        cxn->dispatchResult(resultEvent);
     }
 }
 template <void (IrcConnection::*F)(irc_session_t*, unsigned int, const char*, const vector<string>&, std::shared_ptr<IEvent>&)>
@@ -63,10 +90,32 @@ void IrcConnection::onIrcNumeric(irc_session_t* session,
     IrcConnection* cxn = activeIrcConnections.at(session);
     shared_ptr<IEvent> resultEvent;
     (cxn->*F)(session, eventCode, origin, parameters, resultEvent);
-    if (resultEvent) {
-        cxn->getEventQueue()->sendEvent(resultEvent);
-        cxn->appQueue->sendEvent(resultEvent);
+    if (resultEvent)
+        cxn->dispatchResult(resultEvent);
+}
+
+void IrcConnection::dispatchResult(std::shared_ptr<IEvent> event) {
+    bool deferred;
+    {
+        lock_guard<mutex> lock(forwardMutex);
+        auto statusChanged = event->as<EventIrcUserStatusChanged>();
+        deferred = !pendingForwards.empty()
+            || (statusChanged && statusChanged->getStatus() == EventIrcUserStatusChanged::Status::Quit);
+        if (deferred)
+            pendingForwards.insert(event.get());
     }
+    getEventQueue()->sendEvent(event);
+    if (!deferred)
+        appQueue->sendEvent(event);
+}
+
+void IrcConnection::forwardResult(const std::shared_ptr<IEvent>& event) {
+    // sent with the lock held, the irc thread mustn't send directly before the last deferred event
+    lock_guard<mutex> lock(forwardMutex);
+    auto it = pendingForwards.find(event.get());
+    if (it == pendingForwards.end()) return;
+    pendingForwards.erase(it);
+    appQueue->sendEvent(event);
 }
 
 bool IrcConnection::findUnusedNick(std::string& nick) {
@@ -92,7 +141,26 @@ IrcConnection::IrcConnection(EventQueue* appQueue,
     , configuration{configuration}
     , running{true}
     , ircSession{0}
+    , reconnectScheduler(IrcReconnectScheduler::getInstance())
+    , connectGranted{false}
+    , holdsConnectSlot{false}
+    , sendQueue{IrcSendQueue::loadSettings(configuration.getServerName())}
+    , registered{false}
+    , connectionState{nullptr}
+    , configurationModified{true}
+    , eventsSinceSnapshot{0}
 {
+    setName("irc_connection");
+    if (pipe(wakeupPipe) == 0) {
+        fcntl(wakeupPipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakeupPipe[1], F_SETFL, O_NONBLOCK);
+    } else {
+        wakeupPipe[0] = wakeupPipe[1] = -1;
+    }
+    {
+        lock_guard<mutex> lock(channelLoginDataMutex);
+        publishSnapshot();
+    }
     ircLoop = thread([this]{
         irc_callbacks_t callbacks = {0};
         callbacks.event_connect = &onIrcEvent<&IrcConnection::onConnect>;
@@ -124,18 +192,23 @@ IrcConnection::IrcConnection(EventQueue* appQueue,
         activeIrcConnections.emplace(ircSession, this);
 
         size_t hostIndex = 0; // on error choose next server
+        size_t failures = 0; // attempts since the last registration
+        bool initial = true;
         while (ircSession != 0 && running) {
             IrcServerHostConfiguration hostConfiguration;
             {
                 lock_guard<mutex> lock(channelLoginDataMutex);
                 // copy channels to login
                 channelStores.clear();
+                nickChannels.clear();
+                pendingNames.clear();
+                nickTable.clear();
                 for (auto& channel : this->configuration.getChannelLoginData()) {
                     string channelLower = channel.getChannelName();
                     transform(channelLower.begin(), channelLower.end(), channelLower.begin(), ::tolower);
                     channelStores.emplace(piecewise_construct,
                                           forward_as_tuple(channelLower),
-                                          forward_as_tuple(channel.getChannelPassword(), channel.getDisabled()));
+                                          forward_as_tuple(&nickTable, channel.getChannelPassword(), channel.getDisabled()));
                 }
 
                 auto& hostConfigurations = this->configuration.getHostConfigurations();
@@ -144,7 +217,19 @@ IrcConnection::IrcConnection(EventQueue* appQueue,
                 hostConfiguration = *(next(hostConfigurations.begin(), hostIndex));
 
                 if (!findUnusedNick(nick)) break; // give up
+                publishSnapshot();
             }
+            // restarts and reconnect storms are spread by the scheduler
+            string network = hostConfiguration.getHostName();
+            transform(network.begin(), network.end(), network.begin(), ::tolower);
+            if (!waitForConnect(network, failures, initial)) break;
+            initial = false;
+
+            // lines of the previous session are outdated
+            size_t dropped = sendQueue.clear();
+            if (dropped)
+                LOG_WARNING(logModule) << "dropped unsent messages" << logField("server", this->configuration.getServerId()) << logField("count", dropped);
+            registered = false;
 
             stringstream host;
             if (hostConfiguration.getSsl())
@@ -164,41 +249,158 @@ IrcConnection::IrcConnection(EventQueue* appQueue,
                                 0 /* realname */)) {
                 hostIndex += 1;
             }
-            cout << "[IC] Connection initiated: " << host.str() << ":" << hostConfiguration.getPort() << endl;
+            LOG_INFO(logModule) << "connection initiated" << logField("server", this->configuration.getServerId())
+                                << logField("host", host.str()) << logField("port", hostConfiguration.getPort());
 
             // run irc event loop
-            if (irc_run(ircSession))
+            if (runSession())
                 hostIndex += 1;
-            cout << "[IC] Loop finished" << endl;
+            LOG_INFO(logModule) << "session finished" << logField("server", this->configuration.getServerId()) << logField("registered", registered ? "y" : "n");
 
             irc_disconnect(ircSession);
 
-            if (running) {
-                // reconnect
-                this_thread::sleep_for(chrono::seconds(1));
-            }
+            // attempts which failed before the registration end here
+            finishConnect();
+            failures = registered ? 0 : failures + 1;
         }
+        setConnectionState(nullptr);
 #pragma message "IrcConnection: send disconnected event to appqueue"
     });
 }
 
 IrcConnection::~IrcConnection() {
     running = false;
+    {
+        lock_guard<mutex> lock(connectMutex);
+        connectCondition.notify_all();
+    }
     if (ircSession != 0)
         irc_cmd_quit(ircSession, 0);
+    wakeup();
     if (ircLoop.joinable()) ircLoop.join();
     activeIrcConnections.erase(ircSession);
     if (ircSession != 0)
         irc_destroy_session(ircSession);
+    if (wakeupPipe[0] >= 0) {
+        close(wakeupPipe[0]);
+        close(wakeupPipe[1]);
+    }
+}
+
+bool IrcConnection::waitForConnect(const std::string& network, size_t failures, bool initial) {
+    setConnectionState(&getMetrics().waiting);
+    {
+        lock_guard<mutex> lock(connectMutex);
+        connectGranted = false;
+    }
+    // may grant immediately, connectMutex must not be held
+    size_t requestId = reconnectScheduler.schedule(network, failures, initial, [this] {
+        lock_guard<mutex> lock(connectMutex);
+        connectGranted = true;
+        connectCondition.notify_all();
+    });
+
+    unique_lock<mutex> lock(connectMutex);
+    connectCondition.wait(lock, [this] { return connectGranted || !running; });
+    bool granted = connectGranted;
+    lock.unlock();
+
+    if (granted && running) {
+        connectNetwork = network;
+        holdsConnectSlot = true;
+        setConnectionState(&getMetrics().connecting);
+        return true;
+    }
+    // shut down while waiting
+    if (granted || !reconnectScheduler.cancel(requestId))
+        reconnectScheduler.finish(network);
+    return false;
 }
 
-const std::map<char, char> IrcConnection::prefixToMode {
-    {'~', 'q'}, // Owner
-    {'&', 'a'}, // Admin
-    {'@', 'o'}, // Operator
-    {'%', 'h'}, // HalfOperator
-    {'+', 'v'} // Voiced
-};
+void IrcConnection::finishConnect() {
+    if (!holdsConnectSlot) return;
+    holdsConnectSlot = false;
+    reconnectScheduler.finish(connectNetwork);
+}
+
+int IrcConnection::runSession() {
+    if (!irc_is_connected(ircSession)) return 1;
+
+    while (irc_is_connected(ircSession)) {
+        fd_set inSet, outSet;
+        int maxFd = 0;
+        FD_ZERO(&inSet);
+        FD_ZERO(&outSet);
+        if (wakeupPipe[0] >= 0) {
+            FD_SET(wakeupPipe[0], &inSet);
+            maxFd = wakeupPipe[0];
+        }
+        irc_add_select_descriptors(ircSession, &inSet, &outSet, &maxFd);
+
+        // wake up once the rate limit allows the next line, libircclient expects 250ms at most
+        auto delay = chrono::milliseconds(250);
+        if (registered)
+            delay = min(delay, sendQueue.getDelay());
+        timeval timeout;
+        timeout.tv_sec = delay.count() / 1000;
+        timeout.tv_usec = (delay.count() % 1000) * 1000;
+
+        if (select(maxFd + 1, &inSet, &outSet, 0, &timeout) < 0) {
+            if (errno == EINTR) continue;
+            return 1;
+        }
+        if (wakeupPipe[0] >= 0 && FD_ISSET(wakeupPipe[0], &inSet)) {
+            char buffer[64];
+            while (read(wakeupPipe[0], buffer, sizeof(buffer)) > 0);
+        }
+        if (irc_process_select_descriptors(ircSession, &inSet, &outSet))
+            return 1;
+        if (registered)
+            flushSendQueue();
+    }
+    return 0;
+}
+
+void IrcConnection::flushSendQueue() {
+    string line;
+    shared_ptr<IEvent> sent;
+    while (sendQueue.pop(line, sent)) {
+        if (irc_send_raw(ircSession, "%s", line.c_str()))
+            continue;
+        getMetrics().linesSent.increment();
+        // messages are echoed once they have left, not when they were queued
+        if (sent) {
+            getMetrics().messagesOut.increment();
+            appQueue->sendEvent(sent);
+        }
+    }
+}
+
+void IrcConnection::setConnectionState(MetricsGauge* state) {
+    if (connectionState == state) return;
+    if (connectionState)
+        connectionState->add(-1);
+    if (state)
+        state->add(1);
+    connectionState = state;
+}
+
+void IrcConnection::send(IrcSendQueue::Priority priority, const std::string& line, std::shared_ptr<IEvent> sent) {
+    sendQueue.push(priority, line, move(sent));
+    wakeup();
+}
+
+void IrcConnection::sendJoin(const std::string& channel, const std::string& key) {
+    sendQueue.pushJoin(channel, key);
+    wakeup();
+}
+
+void IrcConnection::wakeup() {
+    char signal = 0;
+    if (wakeupPipe[1] >= 0 && write(wakeupPipe[1], &signal, 1) < 0) {
+        // the pipe is full, the loop wakes up anyway
+    }
+}
 
 std::string IrcConnection::getPureNick(const std::string& nick) {
     size_t exclamationPosition = nick.find('!');
@@ -207,16 +409,74 @@ std::string IrcConnection::getPureNick(const std::string& nick) {
     return nick.substr(0, exclamationPosition);
 }
 
+void IrcConnection::addChannelUser(const std::string& channelName,
+                                   IrcChannelStore& channelStore,
+                                   const std::string& nick,
+                                   const std::string& mode) {
+    channelStore.addUser(nick, mode);
+    IrcNickTable::Id id = nickTable.find(nick);
+    if (id != 0)
+        nickChannels[id].insert(channelName);
+}
+
+void IrcConnection::removeChannelUser(const std::string& channelName,
+                                      IrcChannelStore& channelStore,
+                                      const std::string& nick) {
+    // update the index before the channel releases the nick id
+    auto it = nickChannels.find(nickTable.find(nick));
+    if (it != nickChannels.end()) {
+        it->second.erase(channelName);
+        if (it->second.empty())
+            nickChannels.erase(it);
+    }
+    channelStore.removeUser(nick);
+}
+
+void IrcConnection::clearChannelUsers(const std::string& channelName, IrcChannelStore& channelStore) {
+    for (IrcNickTable::Id id : channelStore.getUserIds()) {
+        auto it = nickChannels.find(id);
+        if (it == nickChannels.end()) continue;
+        it->second.erase(channelName);
+        if (it->second.empty())
+            nickChannels.erase(it);
+    }
+    channelStore.clear();
+}
+
+std::vector<std::string> IrcConnection::getNickChannels(const std::string& nick) const {
+    auto it = nickChannels.find(nickTable.find(nick));
+    if (it == nickChannels.end())
+        return {};
+    return std::vector<std::string>(it->second.begin(), it->second.end());
+}
+
+void IrcConnection::applyNickMerges(const std::vector<IrcNickTable::Merge>& merges) {
+    for (auto& merge : merges) {
+        for (auto& channel : channelStores)
+            channel.second.mergeUser(merge.from, merge.into);
+        auto it = nickChannels.find(merge.from);
+        if (it == nickChannels.end()) continue;
+        set<string> channels = move(it->second);
+        nickChannels.erase(it);
+        nickChannels[merge.into].insert(channels.begin(), channels.end());
+    }
+}
+
 bool IrcConnection::onEvent(std::shared_ptr<IEvent> event) {
     UUID type = event->getEventUuid();
+    // quits are forwarded once their channels are known
+    bool quit = type == EventIrcUserStatusChanged::uuid
+        && event->as<EventIrcUserStatusChanged>()->getStatus() == EventIrcUserStatusChanged::Status::Quit;
+    if (!quit)
+        forwardResult(event);
     if (type == EventQuit::uuid) {
         running = false;
-        cout << "[IC] received QUIT" << endl;
+        LOG_DEBUG(logModule) << "received quit" << logField("server", configuration.getServerId());
         return false;
     } else if (type == EventIrcChangeNick::uuid) {
         lock_guard<mutex> lock(channelLoginDataMutex);
         auto nick = event->as<EventIrcChangeNick>();
-        irc_cmd_nick(ircSession, nick->getNick().c_str());
+        send(IrcSendQueue::Priority::Normal, "NICK " + nick->getNick());
     } else if (type == EventIrcUserStatusRequest::uuid) {
         lock_guard<mutex> lock(channelLoginDataMutex);
         auto statusRequest = event->as<EventIrcUserStatusRequest>();
@@ -232,19 +492,15 @@ bool IrcConnection::onEvent(std::shared_ptr<IEvent> event) {
                 if (it != channelStores.end()) {
                     if (it->second.getDisabled()) {
                         // TODO: check if password specified
-                        irc_cmd_join(ircSession,
-                                     channelLower.c_str(),
-                                     it->second.getChannelPassword().c_str());
+                        sendJoin(channelLower, it->second.getChannelPassword());
                         it->second.setDisabled(false);
                     }
                 } else {
                     string channelPassword = statusRequest->getPassword();
-                    irc_cmd_join(ircSession,
-                                 channelLower.c_str(),
-                                 channelPassword.c_str());
+                    sendJoin(channelLower, channelPassword);
                     channelStores.emplace(piecewise_construct,
                                           forward_as_tuple(channelLower),
-                                          forward_as_tuple(channelPassword, false));
+                                          forward_as_tuple(&nickTable, channelPassword, false));
                     appQueue->sendEvent(make_shared<EventIrcUserStatusChanged>(statusRequest->getUserId(),
                                                                                statusRequest->getServerId(),
                                                                                EventIrcUserStatusChanged::Status::Joined,
@@ -259,7 +515,7 @@ bool IrcConnection::onEvent(std::shared_ptr<IEvent> event) {
             transform(channelName.begin(), channelName.end(), std::back_inserter(channelLower), ::tolower);
             auto it = channelStores.find(channelLower);
             if (it != channelStores.end()) {
-                irc_cmd_part(ircSession, channelLower.c_str());
+                send(IrcSendQueue::Priority::Normal, "PART " + channelLower);
                 it->second.setDisabled(true);
             }
             break;
@@ -269,22 +525,36 @@ bool IrcConnection::onEvent(std::shared_ptr<IEvent> event) {
         auto statusChanged = event->as<EventIrcUserStatusChanged>();
         string userName = statusChanged->getUsername();
         if (userName.size() > 0)  {
-            string channelName = statusChanged->getChannel();
-
             lock_guard<mutex> lock(channelLoginDataMutex);
-            auto it = channelStores.find(channelName);
-            if (it != channelStores.end()) {
-                IrcChannelStore& channelStore = it->second;
-                switch(statusChanged->getStatus()) {
-                case EventIrcUserStatusChanged::Status::Joined:
-                    channelStore.addUser(getPureNick(userName), ""); break;
-                case EventIrcUserStatusChanged::Status::Parted:
-                case EventIrcUserStatusChanged::Status::Kicked:
-                case EventIrcUserStatusChanged::Status::Quit:
-                    channelStore.removeUser(getPureNick(userName)); break;
+            if (statusChanged->getStatus() == EventIrcUserStatusChanged::Status::Quit) {
+                // quits are not bound to a channel, the backlog gets the channels of the current state
+                string pureNick = getPureNick(userName);
+                for (auto& channelName : getNickChannels(pureNick)) {
+                    statusChanged->addChannel(channelName);
+                    auto it = channelStores.find(channelName);
+                    if (it != channelStores.end())
+                        removeChannelUser(channelName, it->second, pureNick);
+                }
+            } else {
+                string channelName = statusChanged->getChannel();
+                auto it = channelStores.find(channelName);
+                if (it != channelStores.end()) {
+                    IrcChannelStore& channelStore = it->second;
+                    switch(statusChanged->getStatus()) {
+                    case EventIrcUserStatusChanged::Status::Joined:
+                        addChannelUser(channelName, channelStore, getPureNick(userName), ""); break;
+                    case EventIrcUserStatusChanged::Status::Parted:
+                        removeChannelUser(channelName, channelStore, getPureNick(userName)); break;
+                    case EventIrcUserStatusChanged::Status::Kicked:
+                        removeChannelUser(channelName, channelStore, getPureNick(statusChanged->getTarget())); break;
+                    default:
+                        break;
+                    }
                 }
             }
         }
+        if (quit)
+            forwardResult(event);
     } else if (type == EventIrcTopic::uuid) {
         auto topic = event->as<EventIrcTopic>();
         string topicText = topic->getTopic();
@@ -300,15 +570,17 @@ bool IrcConnection::onEvent(std::shared_ptr<IEvent> event) {
         lock_guard<mutex> lock(channelLoginDataMutex);
         auto modify = event->as<EventIrcModifyNick>();
         configuration.modifyNick(modify->getOldNick(), modify->getNewNick());
+        configurationModified = true;
         appQueue->sendEvent(make_shared<EventIrcNickModified>(modify->getUserId(), modify->getServerId(), modify->getOldNick(), modify->getNewNick()));
     } else if (type == EventIrcNickChanged::uuid) {
         auto nickChange = event->as<EventIrcNickChanged>();
 
         lock_guard<mutex> lock(channelLoginDataMutex);
-        for (auto& channelStorePair : channelStores) {
-            IrcChannelStore& channelStore = channelStorePair.second;
-            channelStore.renameUser(getPureNick(nickChange->getUsername()), nickChange->getNewNick());
-        }
+        // channels refer to the interned nick, listings see the new nick through the nick table
+        string oldNick = getPureNick(nickChange->getUsername());
+        vector<IrcNickTable::Merge> merges;
+        nickTable.rename(oldNick, nickChange->getNewNick(), merges);
+        applyNickMerges(merges);
         if (nick == getPureNick(nickChange->getUsername()))
             nick = nickChange->getNewNick();
     } else if (type == EventIrcNumeric::uuid) {
@@ -316,10 +588,28 @@ bool IrcConnection::onEvent(std::shared_ptr<IEvent> event) {
         unsigned int code = num->getEventCode();
         if (code == LIBIRC_RFC_ERR_NICKNAMEINUSE) {
             lock_guard<mutex> lock(channelLoginDataMutex);
-            cout << "Nick in use: " << nick << endl;
+            LOG_INFO(logModule) << "nick in use" << logField("server", configuration.getServerId()) << logField("nick", nick);
             inUseNicks.emplace(nick);
+            // sent directly, lines are held back until the registration succeeded
             if (findUnusedNick(nick))
                 irc_cmd_nick(ircSession, nick.c_str());
+        } else if (code == RPL_ISUPPORT) {
+            lock_guard<mutex> lock(channelLoginDataMutex);
+            auto& parameters = num->getParameters();
+            // first parameter is the own nick, the last one a description
+            for (size_t i = 1; i + 1 < parameters.size(); ++i) {
+                const string& token = parameters.at(i);
+                if (token.compare(0, 12, "CASEMAPPING=") == 0) {
+                    IrcCaseMapping caseMapping;
+                    if (IrcNickTable::parseCaseMapping(token.substr(12), caseMapping)) {
+                        vector<IrcNickTable::Merge> merges;
+                        nickTable.setCaseMapping(caseMapping, merges);
+                        applyNickMerges(merges);
+                    }
+                } else if (token.compare(0, 7, "PREFIX=") == 0) {
+                    nickTable.setPrefix(token.substr(7));
+                }
+            }
         } else if (code == LIBIRC_RFC_RPL_TOPIC) {
             lock_guard<mutex> lock(channelLoginDataMutex);
             auto num = event->as<EventIrcNumeric>();
@@ -330,7 +620,6 @@ bool IrcConnection::onEvent(std::shared_ptr<IEvent> event) {
                 it->second.setTopic(parameters.at(2));
         } else if (code == LIBIRC_RFC_RPL_NAMREPLY) {
             lock_guard<mutex> lock(channelLoginDataMutex);
-            auto num = event->as<EventIrcNumeric>();
             auto& parameters = num->getParameters();
 
             string channelName = parameters.at(2);
@@ -343,42 +632,68 @@ bool IrcConnection::onEvent(std::shared_ptr<IEvent> event) {
 #pragma message "channel mode stub"
                 }
 
+                // the list is sent in parts, keep the channel intact until all parts arrived
+                string& names = pendingNames[channelName];
+                names.append(parameters.at(3));
+                names.push_back(' ');
+            }
+        } else if (code == LIBIRC_RFC_RPL_ENDOFNAMES) {
+            lock_guard<mutex> lock(channelLoginDataMutex);
+            auto& parameters = num->getParameters();
+            auto namesIt = parameters.size() < 2
+                ? pendingNames.end()
+                : pendingNames.find(parameters.at(1));
+            if (namesIt != pendingNames.end()) {
+                string channelName = namesIt->first;
+                const string& names = namesIt->second;
+
                 auto it = channelStores.find(channelName);
                 IrcChannelStore* channelStore;
                 // find userdata
                 if (it == channelStores.end()) {
                     auto insertResult = channelStores.emplace(piecewise_construct,
                                                               forward_as_tuple(channelName),
-                                                              forward_as_tuple("", false));
+                                                              forward_as_tuple(&nickTable, "", false));
                     channelStore = &insertResult.first->second;
                 } else {
                     channelStore = &it->second;
                 }
-                // assign users from parameter
-                channelStore->clear();
+
+                // replace the users at once, the list is complete
+                clearChannelUsers(channelName, *channelStore);
                 auto userlist = make_shared<EventIrcUserlistReceived>(num->getUserId(), num->getServerId(), channelName);
-                istringstream users(parameters.at(3));
+                userlist->reserveUsers(count(names.begin(), names.end(), ' '));
+                // buffers are reused for every nick
                 string username;
-                while (getline(users, username, ' ')) {
-                    if (username.size() == 0) continue;
-
-                    std::string mode; // optional, first letter of username
-                    auto modeIt = prefixToMode.find(username.at(0));
-                    if (modeIt != prefixToMode.end()) {
-                        mode = modeIt->second;
-                        username = username.substr(1);
+                string mode; // optional, first letter of username
+                size_t position = 0;
+                while (position < names.size()) {
+                    size_t end = names.find(' ', position);
+                    if (end == string::npos) end = names.size();
+                    size_t begin = position;
+                    position = end + 1;
+                    if (begin == end) continue;
+
+                    // multi-prefix servers send every mode of the user
+                    mode.clear();
+                    char prefixMode;
+                    while (begin < end && (prefixMode = nickTable.getPrefixMode(names[begin])) != 0) {
+                        mode.push_back(prefixMode);
+                        begin += 1;
                     }
-                    channelStore->addUser(username, mode);
+                    username.assign(names, begin, end - begin);
+                    if (username.empty()) continue;
+                    addChannelUser(channelName, *channelStore, username, mode);
                     userlist->addUser(username, mode);
                 }
+                pendingNames.erase(namesIt);
                 appQueue->sendEvent(userlist);
             }
-        } else if (code == LIBIRC_RFC_RPL_ENDOFNAMES) {
-            // userlist is sent in parts
         }
     } else if (type == EventIrcModeChanged::uuid) {
         auto mode = event->as<EventIrcModeChanged>();
 
+        lock_guard<mutex> lock(channelLoginDataMutex);
         auto channelIt = channelStores.find(mode->getChannel());
         if (channelIt != channelStores.end()) {
             auto& channel = channelIt->second;
@@ -407,19 +722,44 @@ bool IrcConnection::onEvent(std::shared_ptr<IEvent> event) {
         transform(channelLower.begin(), channelLower.end(), channelLower.begin(), ::tolower);
         auto it = channelStores.find(channelLower);
         if (it != channelStores.end()) { // channel was found
-            irc_cmd_part(ircSession, channelLower.c_str());
+            send(IrcSendQueue::Priority::Normal, "PART " + channelLower);
+            clearChannelUsers(channelLower, it->second);
             channelStores.erase(it);
         }
+    } else if (type == EventIrcRequestUserlist::uuid) {
+        auto request = event->as<EventIrcRequestUserlist>();
+
+        lock_guard<mutex> lock(channelLoginDataMutex);
+        auto it = channelStores.find(request->getChannel());
+        if (it != channelStores.end()) {
+            const IrcChannelStore& channelStore = it->second;
+            bool complete;
+            auto users = channelStore.getUsersAfter(request->getAfter(), request->getCount(), complete);
+            auto page = make_shared<EventIrcUserlistPage>(request->getUserId(),
+                                                          request->getServerId(),
+                                                          request->getChannel(),
+                                                          channelStore.getUserCount(),
+                                                          complete,
+                                                          request->getData());
+            for (auto& user : users)
+                page->addUser(user.getNick(), user.getMode());
+            appQueue->sendEvent(page);
+        }
     } else if (type == EventIrcSendMessage::uuid) {
         auto message = event->as<EventIrcSendMessage>();
-        if (!irc_cmd_msg(ircSession, message->getChannel().c_str(), message->getMessage().c_str())) {
-            appQueue->sendEvent(make_shared<EventIrcMessage>(message->getUserId(), message->getServerId(), nick, message->getChannel(), message->getMessage(), message->getType()));
-        }
+        send(IrcSendQueue::Priority::High, "PRIVMSG " + message->getChannel() + " :" + message->getMessage(),
+             make_shared<EventIrcMessage>(message->getUserId(), message->getServerId(), nick, message->getChannel(), message->getMessage(), message->getType()));
     } else if (type == EventIrcSendAction::uuid) {
         auto aaction = event->as<EventIrcSendAction>();
-        if (!irc_cmd_me(ircSession, aaction->getChannel().c_str(), aaction->getMessage().c_str())) {
-            appQueue->sendEvent(make_shared<EventIrcAction>(aaction->getUserId(), aaction->getServerId(), nick, aaction->getChannel(), aaction->getMessage()));
-        }
+        send(IrcSendQueue::Priority::High, "PRIVMSG " + aaction->getChannel() + " :\x01" "ACTION " + aaction->getMessage() + "\x01",
+             make_shared<EventIrcAction>(aaction->getUserId(), aaction->getServerId(), nick, aaction->getChannel(), aaction->getMessage()));
+    }
+
+    // publish once a burst of events is processed, listings read the snapshot
+    if (getEventQueue()->isEmpty() || ++eventsSinceSnapshot >= 256) {
+        eventsSinceSnapshot = 0;
+        lock_guard<mutex> lock(channelLoginDataMutex);
+        publishSnapshot();
     }
     return true;
 }
@@ -428,6 +768,53 @@ std::string IrcConnection::getActiveNick() const {
     return nick;
 }
 
+std::shared_ptr<const IrcConnectionSnapshot> IrcConnection::getSnapshot() const {
+    return atomic_load(&snapshot);
+}
+
+void IrcConnection::publishSnapshot() {
+    auto previous = atomic_load(&snapshot);
+    bool changed = !previous
+        || configurationModified
+        || previous->nickGeneration != nickTable.getGeneration()
+        || previous->activeNick != nick
+        || previous->channels.size() != channelStores.size();
+    for (auto it = channelStores.begin(); !changed && it != channelStores.end(); ++it)
+        changed = it->second.getModified() || previous->channels.count(it->first) == 0;
+    if (!changed) return;
+
+    auto next = make_shared<IrcConnectionSnapshot>();
+    next->version = previous ? previous->version + 1 : 1;
+    next->nickGeneration = nickTable.getGeneration();
+    // member ids of unchanged channels are still interned, the names of the current table resolve them
+    next->names = previous && previous->nickGeneration == next->nickGeneration
+        ? previous->names
+        : make_shared<const IrcNickTable::Names>(nickTable.getNames());
+    next->activeNick = nick;
+    next->configuration = configurationModified || !previous
+        ? make_shared<const IrcServerConfiguration>(configuration)
+        : previous->configuration;
+    for (auto& channelPair : channelStores) {
+        IrcChannelStore& channelStore = channelPair.second;
+        // unchanged channels are shared with the previous snapshot
+        if (previous && !channelStore.getModified()) {
+            auto it = previous->channels.find(channelPair.first);
+            if (it != previous->channels.end()) {
+                next->channels.emplace_hint(next->channels.end(), channelPair.first, it->second);
+                continue;
+            }
+        }
+        auto channel = make_shared<IrcChannelSnapshot>();
+        channel->topic = channelStore.getTopic();
+        channel->disabled = channelStore.getDisabled();
+        channel->members = channelStore.getMembers();
+        next->channels.emplace_hint(next->channels.end(), channelPair.first, channel);
+        channelStore.setModified(false);
+    }
+    configurationModified = false;
+    atomic_store(&snapshot, shared_ptr<const IrcConnectionSnapshot>(next));
+}
+
 size_t IrcConnection::getServerId() const {
     return configuration.getServerId();
 }
@@ -442,10 +829,14 @@ void IrcConnection::addHost(const std::string& hostName,
                                        password,
                                        ipV6,
                                        ssl);
+    configurationModified = true;
+    publishSnapshot();
 }
 
 void IrcConnection::removeHost(const std::string& host, int port) {
     configuration.removeHost(host, port);
+    configurationModified = true;
+    publishSnapshot();
 }
 
 
@@ -460,12 +851,3 @@ std::string IrcConnection::getServerName() const {
 std::mutex& IrcConnection::getChannelLoginDataMutex() {
     return channelLoginDataMutex;
 }
-
-const std::map<std::string, IrcChannelStore>& IrcConnection::getChannelStore() const {
-    return channelStores;
-}
-
-const IrcChannelStore* IrcConnection::getChannelStore(const std::string& channelName) const {
-    auto it = channelStores.find(channelName);
-    return it == channelStores.end() ? 0 : &it->second;
-}
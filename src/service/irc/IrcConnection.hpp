@@ -4,16 +4,25 @@
 #include "event/irc/EventIrcActivateService.hpp"
 #include "IrcConnection.hpp"
 #include "IrcChannelStore.hpp"
+#include "IrcNickTable.hpp"
+#include "IrcConnectionSnapshot.hpp"
+#include "IrcSendQueue.hpp"
+#include "IrcReconnectScheduler.hpp"
 #include "IrcServerConfiguration.hpp"
 #include "IrcServerHostConfiguration.hpp"
 #include "queue/EventLoop.hpp"
+#include "utils/Metrics.hpp"
 #include <libircclient.h>
+#include <atomic>
 #include <list>
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <mutex>
+#include <condition_variable>
 #include <memory>
 #include <thread>
 
@@ -24,20 +33,69 @@
 class IrcConnection : public EventLoop {
     EventQueue* appQueue;
 
-    static const std::map<char, char> prefixToMode;
-
     size_t userId;
     IrcServerConfiguration configuration;
     bool running;
     irc_session_t* ircSession;
 
     std::thread ircLoop;
+    /// Decides when to connect, initialized before anything else reads config/irc.ini
+    IrcReconnectScheduler& reconnectScheduler;
+    std::mutex connectMutex;
+    std::condition_variable connectCondition;
+    /// Set by the scheduler, guarded by connectMutex
+    bool connectGranted;
+    /// Network of the running attempt, only used by the irc loop
+    std::string connectNetwork;
+    /// True until the attempt was reported to the scheduler, only used by the irc loop
+    bool holdsConnectSlot;
+    /// Lines to the server, sent by the irc loop
+    IrcSendQueue sendQueue;
+    /// Interrupts the irc loop's select when lines were queued
+    int wakeupPipe[2];
+    /// Set once the server accepted the registration, lines are held back before
+    std::atomic<bool> registered;
+
+    /// Metrics shared by all connections
+    struct Metrics {
+        Metrics();
+        /// Connections per state
+        MetricsGauge& waiting;
+        MetricsGauge& connecting;
+        MetricsGauge& registered;
+        MetricsCounter& messagesIn;
+        MetricsCounter& messagesOut;
+        MetricsCounter& linesSent;
+    };
+    static Metrics& getMetrics();
+    /// Gauge counting this connection, only used by the irc loop
+    MetricsGauge* connectionState;
+    /// Moves the connection to the gauge of another state, nullptr once stopped
+    void setConnectionState(MetricsGauge* state);
 
     std::mutex channelLoginDataMutex;
 
     std::string nick;
     std::set<std::string> inUseNicks;
+    /// Nicks of all channels, declared before the channels which refer to it
+    IrcNickTable nickTable;
     std::map<std::string, IrcChannelStore> channelStores;
+    /// Channels of every nick for QUIT handling, keyed by the interned nick
+    std::unordered_map<IrcNickTable::Id, std::set<std::string>> nickChannels;
+    /// Nick lists of NAMES replies, collected per channel until RPL_ENDOFNAMES
+    std::map<std::string, std::string> pendingNames;
+
+    std::mutex forwardMutex;
+    /// Events of the irc thread which reach the app queue through onEvent. Quits need the
+    /// channels of the loop's state, later events wait behind them to keep their order.
+    std::unordered_set<const IEvent*> pendingForwards;
+
+    /// Latest published state, only accessed with std::atomic_load/atomic_store
+    std::shared_ptr<const IrcConnectionSnapshot> snapshot;
+    /// Set when nicks or hosts of the configuration changed since the last snapshot
+    bool configurationModified;
+    /// Events processed since the last snapshot, bounds its age under load
+    size_t eventsSinceSnapshot;
 
 public:
     IrcConnection(EventQueue* appQueue, size_t userId, const IrcServerConfiguration& configuration);
@@ -46,6 +104,8 @@ public:
     bool findUnusedNick(std::string& nick);
 
     std::string getActiveNick() const;
+    /// Returns the latest state of the connection, doesn't require a lock
+    std::shared_ptr<const IrcConnectionSnapshot> getSnapshot() const;
     size_t getServerId() const;
     std::string getServerName() const;
     std::mutex& getChannelLoginDataMutex();
@@ -56,12 +116,51 @@ public:
                  bool ssl);
     void removeHost(const std::string& host, int port);
     const IrcServerConfiguration& getServerConfiguration() const;
-    const std::map<std::string, IrcChannelStore>& getChannelStore() const;
-    const IrcChannelStore* getChannelStore(const std::string& channelName) const;
 
 private:
     static std::string getPureNick(const std::string& nick);
 
+    /// Adds a user to a channel and to the channels of the nick
+    void addChannelUser(const std::string& channelName,
+                        IrcChannelStore& channelStore,
+                        const std::string& nick,
+                        const std::string& mode);
+    /// Removes a user from a channel and from the channels of the nick
+    void removeChannelUser(const std::string& channelName,
+                           IrcChannelStore& channelStore,
+                           const std::string& nick);
+    /// Removes all users from a channel and from the channels of their nicks
+    void clearChannelUsers(const std::string& channelName, IrcChannelStore& channelStore);
+    /// Returns the channels a nick is in, requires a lock of the channel data
+    std::vector<std::string> getNickChannels(const std::string& nick) const;
+    /// Moves the channels of merged nick ids to the remaining id, requires a lock of the channel data
+    void applyNickMerges(const std::vector<IrcNickTable::Merge>& merges);
+    /// Publishes a new snapshot if anything changed, requires a lock of the channel data
+    void publishSnapshot();
+
+    /// Waits until the reconnect scheduler allows to connect
+    ///
+    /// \returns False if the connection is shut down meanwhile
+    bool waitForConnect(const std::string& network, size_t failures, bool initial);
+    /// Reports the end of a connection attempt to the scheduler, once per attempt
+    void finishConnect();
+    /// Runs the irc session until it disconnects, replaces irc_run to send queued lines in between
+    ///
+    /// \returns Non zero on errors
+    int runSession();
+    /// Sends queued lines as far as the rate limit allows
+    void flushSendQueue();
+    /// Queues a line and wakes up the irc loop, sent is passed to the application once the line is written
+    void send(IrcSendQueue::Priority priority, const std::string& line, std::shared_ptr<IEvent> sent = nullptr);
+    /// Queues a channel for the next JOIN line and wakes up the irc loop
+    void sendJoin(const std::string& channel, const std::string& key);
+    /// Wakes up the irc loop
+    void wakeup();
+    /// Passes an event of the irc thread to the connection loop and the app queue
+    void dispatchResult(std::shared_ptr<IEvent> event);
+    /// Sends an event deferred by dispatchResult to the app queue, called from onEvent
+    void forwardResult(const std::shared_ptr<IEvent>& event);
+
     template <void (IrcConnection::*F)(irc_session_t*, const char*, const char*, const std::vector<std::string>&, std::shared_ptr<IEvent>&)>
     static void onIrcEvent(irc_session_t* session,
                            const char* event,
@@ -0,0 +1,37 @@
+#ifndef IRCCONNECTIONSNAPSHOT_H
+#define IRCCONNECTIONSNAPSHOT_H
+
+#include "IrcChannelStore.hpp"
+#include "IrcNickTable.hpp"
+#include "IrcServerConfiguration.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/// Immutable copy of a channel, shared by snapshots until the channel changes
+struct IrcChannelSnapshot {
+    std::string topic;
+    bool disabled;
+    /// Resolved with the names of the connection snapshot
+    std::vector<IrcChannelStore::Member> members;
+};
+
+/// Immutable state of an irc connection.
+/// The connection publishes a new snapshot after changes, listings read it without locking.
+struct IrcConnectionSnapshot {
+    /// Increased with every published snapshot
+    uint64_t version;
+    /// Generation of the nick table the member ids belong to
+    uint64_t nickGeneration;
+    /// Nicks and modes of the member ids, shared until the generation changes
+    std::shared_ptr<const IrcNickTable::Names> names;
+    std::string activeNick;
+    std::shared_ptr<const IrcServerConfiguration> configuration;
+    /// Channels by the name used by the connection
+    std::map<std::string, std::shared_ptr<const IrcChannelSnapshot>> channels;
+};
+
+#endif
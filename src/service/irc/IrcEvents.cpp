@@ -9,11 +9,23 @@
 #include "event/irc/EventIrcMessage.hpp"
 #include "event/irc/EventIrcInvited.hpp"
 #include "event/irc/EventIrcNumeric.hpp"
-#include <iostream>
+#include "utils/Logger.hpp"
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("irc");
+
+static std::string joinParameters(std::vector<std::string>::const_iterator begin,
+                                  std::vector<std::string>::const_iterator end) {
+    string joined;
+    for (auto it = begin; it != end; ++it) {
+        if (!joined.empty()) joined += ' ';
+        joined += *it;
+    }
+    return joined;
+}
+
 void IrcConnection::onConnect(irc_session_t* session,
                                    const char* event,
                                    const char* origin,
@@ -24,14 +36,14 @@ void IrcConnection::onConnect(irc_session_t* session,
     for (auto& joinDataPair : channelStores) {
         string channelName = joinDataPair.first;
         string channelPassword = joinDataPair.second.getChannelPassword();
-        if (!joinDataPair.second.getDisabled()) {
-            irc_cmd_join(ircSession,
-                         channelName.c_str(),
-                         channelPassword.empty()
-                         ? 0
-                         : channelPassword.c_str());
-        }
+        // packed into few JOIN lines by the send queue
+        if (!joinDataPair.second.getDisabled())
+            sendQueue.pushJoin(channelName, channelPassword);
     }
+    registered = true;
+    setConnectionState(&getMetrics().registered);
+    // the next connection to this network may start
+    finishConnect();
     resultEvent = make_shared<EventIrcConnected>(userId, configuration.getServerId());
 }
 
@@ -44,7 +56,7 @@ void IrcConnection::onNick(irc_session_t* session,
     if (params.size() < 1) return;
     string who(origin);
     string newNick(params.at(0));
-    cout << "Nickchange<" << who << ">: " << newNick << endl;
+    LOG_DEBUG(logModule) << "nick" << logField("server", configuration.getServerId()) << logField("who", who) << logField("nick", newNick);
     resultEvent = make_shared<EventIrcNickChanged>(userId, configuration.getServerId(), who, newNick);
 }
 
@@ -56,7 +68,8 @@ void IrcConnection::onQuit(irc_session_t* session,
 {
     string who(origin);
     string reason = params.size() < 1 ? "" : params.at(0);
-    cout << "Q<" << origin << ">: " << reason << endl;
+    LOG_DEBUG(logModule) << "quit" << logField("server", configuration.getServerId()) << logField("who", who) << logField("reason", reason);
+    // the channels are added in onEvent, once earlier joins and nick changes were applied
     resultEvent = make_shared<EventIrcUserStatusChanged>(userId,
                                                          configuration.getServerId(),
                                                          EventIrcUserStatusChanged::Status::Quit,
@@ -80,7 +93,7 @@ void IrcConnection::onJoin(irc_session_t* session,
                                                          EventIrcUserStatusChanged::Status::Joined,
                                                          who,
                                                          channel);
-    cout << "JOIN<" << who << ">: " << channel << endl;
+    LOG_DEBUG(logModule) << "join" << logField("server", configuration.getServerId()) << logField("who", who) << logField("channel", channel);
 }
 
 void IrcConnection::onPart(irc_session_t* session,
@@ -95,10 +108,10 @@ void IrcConnection::onPart(irc_session_t* session,
     string reason = params.size() < 2 ? "" : params.at(1);
     resultEvent = make_shared<EventIrcUserStatusChanged>(userId,
                                                          configuration.getServerId(),
-                                                         EventIrcUserStatusChanged::Status::Joined,
+                                                         EventIrcUserStatusChanged::Status::Parted,
                                                          who,
                                                          channel);
-    cout << "PART<" << who << ">: " << channel << ": " << reason << endl;
+    LOG_DEBUG(logModule) << "part" << logField("server", configuration.getServerId()) << logField("who", who) << logField("channel", channel) << logField("reason", reason);
 }
 
 void IrcConnection::onMode(irc_session_t* session,
@@ -113,10 +126,8 @@ void IrcConnection::onMode(irc_session_t* session,
     string mode(params.at(1));
     auto argIt = params.begin()+2;
     resultEvent = make_shared<EventIrcModeChanged>(userId, configuration.getServerId(), who, channel, mode, argIt, params.end());
-    cout << "MODE<" << who << ">: " << userId << " " << channel << " " << mode << ":";
-    for (auto it = argIt; it != params.end(); ++it)
-        cout << " " << *it;
-    cout << endl;
+    LOG_DEBUG(logModule) << "mode" << logField("server", configuration.getServerId()) << logField("who", who) << logField("channel", channel)
+                         << logField("mode", mode) << logField("arguments", joinParameters(argIt, params.end()));
 }
 
 void IrcConnection::onUmode(irc_session_t* session,
@@ -132,7 +143,7 @@ void IrcConnection::onUmode(irc_session_t* session,
     resultEvent = make_shared<EventIrcUserStatusChanged>(userId, configuration.getServerId(),
                                                          EventIrcUserStatusChanged::Status::Mode,
                                                          who, channel, mode);
-    cout << "UMODE<" << who << ">: " << channel << " " << mode << endl;
+    LOG_DEBUG(logModule) << "umode" << logField("server", configuration.getServerId()) << logField("who", who) << logField("target", channel) << logField("mode", mode);
 }
 
 void IrcConnection::onTopic(irc_session_t* session,
@@ -145,7 +156,7 @@ void IrcConnection::onTopic(irc_session_t* session,
     string who(origin);
     string channel(params.at(0));
     string topic = params.size() < 2 ? "" : (params.at(1));
-    cout << "TOPIC<" << who << ">: " << channel << ": " << topic << endl;
+    LOG_DEBUG(logModule) << "topic" << logField("server", configuration.getServerId()) << logField("who", who) << logField("channel", channel) << logField("topic", topic);
     resultEvent = make_shared<EventIrcTopic>(userId, configuration.getServerId(), who, channel, topic);
 }
 
@@ -179,7 +190,7 @@ void IrcConnection::onChannel(irc_session_t* session,
     string who(origin);
     string channel(params.at(0));
     string message(params.at(1));
-    cout << "<" << channel << ":" << who << ">: " << message << endl;
+    LOG_TRACE(logModule) << "channel message" << logField("server", configuration.getServerId()) << logField("who", who) << logField("channel", channel) << logField("message", message);
     resultEvent = make_shared<EventIrcMessage>(userId, configuration.getServerId(), who, channel, message, IrcMessageType::Message);
 }
 
@@ -193,7 +204,7 @@ void IrcConnection::onPrivmsg(irc_session_t* session,
     string who(origin);
     string self(params.at(0));
     string message(params.at(1));
-    cout << "<" << who << "|" << self << ">: " << message << endl;
+    LOG_TRACE(logModule) << "private message" << logField("server", configuration.getServerId()) << logField("who", who) << logField("target", self) << logField("message", message);
     resultEvent = make_shared<EventIrcMessage>(userId, configuration.getServerId(), who, who, message, IrcMessageType::Message);
 }
 
@@ -208,7 +219,7 @@ void IrcConnection::onNotice(irc_session_t* session,
     string target(params.at(0));
     string message = params.size() < 2 ? "" : params.at(1);
     resultEvent = make_shared<EventIrcMessage>(userId, configuration.getServerId(), who, target, message, IrcMessageType::Notice);
-    cout << "N<" << who << "|" << target << ">: " << message << endl;
+    LOG_TRACE(logModule) << "notice" << logField("server", configuration.getServerId()) << logField("who", who) << logField("target", target) << logField("message", message);
 }
 
 void IrcConnection::onChannelNotice(irc_session_t* session,
@@ -222,7 +233,7 @@ void IrcConnection::onChannelNotice(irc_session_t* session,
     string channel(params.at(0));
     string message = params.size() < 2 ? "" : params.at(1);
     resultEvent = make_shared<EventIrcMessage>(userId, configuration.getServerId(), who, channel, message, IrcMessageType::Notice);
-    cout << "CN<" << who << "|" << channel << ">: " << message << endl;
+    LOG_TRACE(logModule) << "channel notice" << logField("server", configuration.getServerId()) << logField("who", who) << logField("channel", channel) << logField("message", message);
 }
 
 void IrcConnection::onInvite(irc_session_t* session,
@@ -236,7 +247,7 @@ void IrcConnection::onInvite(irc_session_t* session,
     string target(params.at(0));
     string channel = params.size() < 2 ? "" : params.at(1);
     resultEvent = make_shared<EventIrcInvited>(userId, configuration.getServerId(), who, target, channel);
-    cout << "Invite<" << who << ">: " << channel << ": " << target << endl;
+    LOG_DEBUG(logModule) << "invite" << logField("server", configuration.getServerId()) << logField("who", who) << logField("channel", channel) << logField("target", target);
 }
 
 void IrcConnection::onCtcpReq(irc_session_t* session,
@@ -268,7 +279,7 @@ void IrcConnection::onCtcpAction(irc_session_t* session,
     string target(params.at(0));
     string message = params.size() < 2 ? "" : params.at(1);
     resultEvent = make_shared<EventIrcAction>(userId, configuration.getServerId(), who, target, message);
-    cout << "Action<" << who << ">: " << target << ": " << message << endl;
+    LOG_TRACE(logModule) << "action" << logField("server", configuration.getServerId()) << logField("who", who) << logField("target", target) << logField("message", message);
 }
 
 void IrcConnection::onNumeric(irc_session_t* session,
@@ -279,10 +290,8 @@ void IrcConnection::onNumeric(irc_session_t* session,
 {
     string who = origin == 0 ? "" : origin;
     resultEvent = make_shared<EventIrcNumeric>(userId, configuration.getServerId(), event, who, parameters);
-    cout << "Numeric<" << who << ">: " << event;
-    for (string s : parameters)
-        cout << " | " << s;
-    cout << endl;
+    LOG_TRACE(logModule) << "numeric" << logField("server", configuration.getServerId()) << logField("who", who) << logField("numeric", event)
+                         << logField("parameters", joinParameters(parameters.begin(), parameters.end()));
 }
 
 void IrcConnection::onUnknown(irc_session_t* session,
@@ -291,6 +300,6 @@ void IrcConnection::onUnknown(irc_session_t* session,
                                    const std::vector<std::string>& params,
                                    std::shared_ptr<IEvent>& resultEvent)
 {
-    cout << "UnknownEvent" << endl;
+    LOG_DEBUG(logModule) << "unknown event" << logField("server", configuration.getServerId()) << logField("event", event == 0 ? "" : event);
 }
 
@@ -0,0 +1,249 @@
+#include "IrcNickTable.hpp"
+#include <limits>
+
+using namespace std;
+
+
+IrcNickTable::IrcNickTable()
+    : caseMapping{IrcCaseMapping::Rfc1459}
+    , modes{"qaohv"}
+    , prefixes{"~&@%+"}
+    , generation{0}
+{
+}
+
+void IrcNickTable::setCaseMapping(IrcCaseMapping lcaseMapping, std::vector<Merge>& merges) {
+    if (caseMapping == lcaseMapping) return;
+    caseMapping = lcaseMapping;
+    ++generation;
+
+    index.clear();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        Entry& entry = entries[i];
+        if (entry.references == 0) continue;
+        entry.folded = fold(entry.nick);
+        Id id = static_cast<Id>(i + 1);
+        auto inserted = index.emplace(entry.folded, id);
+        if (!inserted.second) {
+            // both spellings are the same nick now, the first one stays
+            merge(id, inserted.first->second);
+            merges.push_back(Merge{id, inserted.first->second});
+        }
+    }
+}
+
+bool IrcNickTable::parseCaseMapping(const std::string& name, IrcCaseMapping& lcaseMapping) {
+    if (name == "ascii")
+        lcaseMapping = IrcCaseMapping::Ascii;
+    else if (name == "rfc1459")
+        lcaseMapping = IrcCaseMapping::Rfc1459;
+    else if (name == "strict-rfc1459")
+        lcaseMapping = IrcCaseMapping::StrictRfc1459;
+    else
+        return false;
+    return true;
+}
+
+bool IrcNickTable::setPrefix(const std::string& prefix) {
+    if (prefix.size() < 2 || prefix.at(0) != '(') return false;
+    size_t closing = prefix.find(')');
+    if (closing == string::npos) return false;
+
+    string newModes = prefix.substr(1, closing - 1);
+    string newPrefixes = prefix.substr(closing + 1);
+    // the bitmask holds up to 8 modes
+    if (newModes.size() != newPrefixes.size() || newModes.size() > 8) return false;
+
+    // mode bits of channel users are not remapped,
+    // PREFIX is announced before any channel is joined
+    modes = newModes;
+    prefixes = newPrefixes;
+    ++generation;
+    return true;
+}
+
+void IrcNickTable::foldInto(const std::string& nick, std::string& folded) const {
+    folded.assign(nick);
+    for (char& c : folded) {
+        if (c >= 'A' && c <= 'Z') {
+            c = c - 'A' + 'a';
+        } else if (caseMapping != IrcCaseMapping::Ascii) {
+            switch (c) {
+            case '[': c = '{'; break;
+            case ']': c = '}'; break;
+            case '\\': c = '|'; break;
+            case '~':
+                if (caseMapping == IrcCaseMapping::Rfc1459)
+                    c = '^';
+                break;
+            }
+        }
+    }
+}
+
+std::string IrcNickTable::fold(const std::string& nick) const {
+    string folded;
+    foldInto(nick, folded);
+    return folded;
+}
+
+void IrcNickTable::merge(Id from, Id into) {
+    Entry& entry = entries[from - 1];
+    entries[into - 1].references += entry.references;
+    entry.references = 0;
+    entry.nick.clear();
+    entry.nick.shrink_to_fit();
+    entry.folded.clear();
+    entry.folded.shrink_to_fit();
+    freeIds.push_back(from);
+}
+
+IrcNickTable::Id IrcNickTable::intern(const std::string& nick) {
+    // known nicks are found without allocating
+    foldInto(nick, foldBuffer);
+    auto it = index.find(foldBuffer);
+    if (it != index.end()) {
+        entries[it->second - 1].references += 1;
+        return it->second;
+    }
+    string folded{foldBuffer};
+    ++generation;
+
+    Id id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+        Entry& entry = entries[id - 1];
+        entry.nick = nick;
+        entry.folded = folded;
+        entry.references = 1;
+    } else {
+        if (entries.size() >= numeric_limits<Id>::max() - 1) return 0;
+        entries.push_back(Entry{nick, folded, 1});
+        id = static_cast<Id>(entries.size());
+    }
+    index.emplace(move(folded), id);
+    return id;
+}
+
+IrcNickTable::Id IrcNickTable::find(const std::string& nick) const {
+    foldInto(nick, foldBuffer);
+    auto it = index.find(foldBuffer);
+    return it == index.end() ? 0 : it->second;
+}
+
+void IrcNickTable::release(Id id) {
+    if (id == 0 || id > entries.size()) return;
+    Entry& entry = entries[id - 1];
+    if (entry.references == 0) return;
+    if (--entry.references > 0) return;
+
+    auto it = index.find(entry.folded);
+    if (it != index.end() && it->second == id)
+        index.erase(it);
+    entry.nick.clear();
+    entry.nick.shrink_to_fit();
+    entry.folded.clear();
+    entry.folded.shrink_to_fit();
+    freeIds.push_back(id);
+    ++generation;
+}
+
+bool IrcNickTable::rename(const std::string& nick, const std::string& newNick, std::vector<Merge>& merges) {
+    foldInto(nick, foldBuffer);
+    auto it = index.find(foldBuffer);
+    if (it == index.end()) return false;
+
+    Id id = it->second;
+    Entry& entry = entries[id - 1];
+    entry.nick = newNick;
+    ++generation;
+    string folded = fold(newNick);
+    if (folded == entry.folded) return true; // only the case changed
+
+    index.erase(it);
+    auto inserted = index.emplace(folded, id);
+    if (!inserted.second) {
+        // a stale entry of the new nick, e.g. a missed quit, is the same user now
+        Id stale = inserted.first->second;
+        inserted.first->second = id;
+        merge(stale, id);
+        merges.push_back(Merge{stale, id});
+    }
+    entry.folded = move(folded);
+    return true;
+}
+
+const std::string& IrcNickTable::getNick(Id id) const {
+    return entries.at(id - 1).nick;
+}
+
+const std::string& IrcNickTable::getFolded(Id id) const {
+    return entries.at(id - 1).folded;
+}
+
+size_t IrcNickTable::size() const {
+    return index.size();
+}
+
+IrcNickTable::Names IrcNickTable::getNames() const {
+    Names names;
+    names.nicks.reserve(entries.size());
+    for (auto& entry : entries)
+        names.nicks.push_back(entry.nick);
+    names.modes = modes;
+    return names;
+}
+
+uint64_t IrcNickTable::getGeneration() const {
+    return generation;
+}
+
+void IrcNickTable::clear() {
+    entries.clear();
+    freeIds.clear();
+    index.clear();
+    ++generation;
+    caseMapping = IrcCaseMapping::Rfc1459;
+    modes = "qaohv";
+    prefixes = "~&@%+";
+}
+
+uint8_t IrcNickTable::getModeBit(char mode) const {
+    size_t position = modes.find(mode);
+    return position == string::npos ? 0 : static_cast<uint8_t>(1 << position);
+}
+
+char IrcNickTable::getPrefixMode(char prefix) const {
+    size_t position = prefixes.find(prefix);
+    return position == string::npos ? 0 : modes.at(position);
+}
+
+uint8_t IrcNickTable::toModeBits(const std::string& mode) const {
+    uint8_t modeBits = 0;
+    for (char c : mode)
+        modeBits |= getModeBit(c);
+    return modeBits;
+}
+
+/// Picks the modes of the set bits, modes are ordered by rank
+static std::string toModeString(const std::string& modes, uint8_t modeBits) {
+    string mode;
+    for (size_t i = 0; i < modes.size(); ++i) {
+        if (modeBits & (1 << i))
+            mode.push_back(modes[i]);
+    }
+    return mode;
+}
+
+std::string IrcNickTable::toModeString(uint8_t modeBits) const {
+    return ::toModeString(modes, modeBits);
+}
+
+const std::string& IrcNickTable::Names::getNick(Id id) const {
+    return nicks.at(id - 1);
+}
+
+std::string IrcNickTable::Names::toModeString(uint8_t modeBits) const {
+    return ::toModeString(modes, modeBits);
+}
@@ -0,0 +1,123 @@
+#ifndef IRCNICKTABLE_H
+#define IRCNICKTABLE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+
+/// Case folding rules announced by the CASEMAPPING ISUPPORT token
+enum class IrcCaseMapping {
+    /// Only A-Z are folded
+    Ascii,
+    /// Like ascii, additionally []\~ are folded to {}|^ (the default)
+    Rfc1459,
+    /// Like rfc1459 but without folding ~ to ^
+    StrictRfc1459
+};
+
+/// Stores each nick of an irc connection once, channels only refer to the ids.
+/// Nicks are case folded once on insertion, lookups fold the searched nick only.
+/// Channel user modes are stored as a bitmask in the order of the PREFIX ISUPPORT token.
+class IrcNickTable {
+public:
+    /// Interned nick, 0 is never used for a valid nick
+    using Id = uint32_t;
+    /// Two ids which fold to the same nick, the references of from moved to into
+    /// and channels have to replace from with into
+    struct Merge {
+        Id from;
+        Id into;
+    };
+    /// Immutable copy of the nicks and modes, resolves ids and mode bits without the table
+    struct Names {
+        /// Nicks indexed by id - 1, empty for free ids
+        std::vector<std::string> nicks;
+        /// Channel user modes ordered by rank
+        std::string modes;
+
+        /// Returns the nick of an id which was interned when the copy was made
+        const std::string& getNick(Id id) const;
+        /// Converts a bitmask to a mode string ordered by rank
+        std::string toModeString(uint8_t modeBits) const;
+    };
+private:
+    struct Entry {
+        std::string nick;
+        std::string folded;
+        /// Amount of channels referring to the nick
+        size_t references;
+    };
+
+    IrcCaseMapping caseMapping;
+    /// Channel user modes ordered by rank, e.g. "qaohv"
+    std::string modes;
+    /// Nick prefixes in NAMES replies, same order as modes, e.g. "~&@%+"
+    std::string prefixes;
+    /// Entries indexed by id - 1
+    std::vector<Entry> entries;
+    std::vector<Id> freeIds;
+    std::unordered_map<std::string, Id> index;
+    /// Changes whenever an id gets another nick or mode bits get other modes
+    uint64_t generation;
+    /// Reused for folding looked up nicks, guarded like the table itself
+    mutable std::string foldBuffer;
+
+    /// Folds a nick into the given string, reusing its capacity
+    void foldInto(const std::string& nick, std::string& folded) const;
+    /// Moves the references of from to into and frees from, the index isn't touched
+    void merge(Id from, Id into);
+public:
+    IrcNickTable();
+
+    /// Changes the case folding rules, already interned nicks are folded again
+    ///
+    /// \param merges Receives the ids which fold to the same nick now
+    void setCaseMapping(IrcCaseMapping caseMapping, std::vector<Merge>& merges);
+    /// Parses the value of the CASEMAPPING ISUPPORT token
+    ///
+    /// \returns False if the mapping is unknown
+    static bool parseCaseMapping(const std::string& name, IrcCaseMapping& caseMapping);
+    /// Sets the channel user modes of the PREFIX ISUPPORT token, e.g. "(qaohv)~&@%+"
+    ///
+    /// \returns False if the token is malformed, the previous modes stay active
+    bool setPrefix(const std::string& prefix);
+
+    /// Folds a nick using the active case mapping
+    std::string fold(const std::string& nick) const;
+    /// Returns the id of a nick and adds a reference, interns unknown nicks
+    Id intern(const std::string& nick);
+    /// Returns the id of a nick without adding a reference or 0 if unknown
+    Id find(const std::string& nick) const;
+    /// Drops a reference, the nick is removed after the last one
+    void release(Id id);
+    /// Renames a nick for all channels at once
+    ///
+    /// \param merges Receives a stale id which was already interned with the new nick
+    /// \returns False if the nick is unknown
+    bool rename(const std::string& nick, const std::string& newNick, std::vector<Merge>& merges);
+    /// Returns the nick as it was sent by the server
+    const std::string& getNick(Id id) const;
+    /// Returns the case folded nick
+    const std::string& getFolded(Id id) const;
+    /// Amount of interned nicks
+    size_t size() const;
+    /// Ids and mode bits of an older generation may resolve to other nicks and modes
+    uint64_t getGeneration() const;
+    /// Copies the nicks and modes of the current generation
+    Names getNames() const;
+    /// Removes all nicks and restores the default case mapping and modes
+    void clear();
+
+    /// Returns the bit of a channel user mode or 0 if the mode is no prefix mode
+    uint8_t getModeBit(char mode) const;
+    /// Returns the mode of a NAMES prefix or 0 if the char is no prefix
+    char getPrefixMode(char prefix) const;
+    /// Converts a mode string to a bitmask, unknown modes are ignored
+    uint8_t toModeBits(const std::string& mode) const;
+    /// Converts a bitmask to a mode string ordered by rank
+    std::string toModeString(uint8_t modeBits) const;
+};
+
+#endif
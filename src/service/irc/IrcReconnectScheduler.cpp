@@ -0,0 +1,170 @@
+#include "IrcReconnectScheduler.hpp"
+#include "utils/Ini.hpp"
+#include "event/EventTimer.hpp"
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+
+
+IrcReconnectScheduler::Settings::Settings()
+    : startupWindow{60000}
+    , initialDelay{2000}
+    , maxDelay{300000}
+    , jitter{0.2}
+    , maxConnectsPerNetwork{3}
+{
+}
+
+IrcReconnectScheduler::IrcReconnectScheduler()
+    : startTime{chrono::steady_clock::now()}
+    , lastRequestId{0}
+    , random{random_device{}()}
+{
+    setName("irc_reconnect");
+    loadSettings();
+}
+
+IrcReconnectScheduler::~IrcReconnectScheduler() {
+    lock_guard<mutex> lock(schedulerMutex);
+    for (auto& timerRequest : timerRequests)
+        cancelTimer(timerRequest.first);
+    timerRequests.clear();
+}
+
+IrcReconnectScheduler& IrcReconnectScheduler::getInstance() {
+    static IrcReconnectScheduler scheduler;
+    return scheduler;
+}
+
+void IrcReconnectScheduler::loadSettings() {
+    Ini ircIni("config/irc.ini");
+    auto& reconnect = ircIni.expectCategory("reconnect");
+
+    // missing entries are written with their defaults
+    auto entry = [&](const string& name, const string& defaultValue) {
+        string value;
+        if (!ircIni.getEntry(reconnect, name, value)) {
+            value = defaultValue;
+            ircIni.setEntry(reconnect, name, value);
+        }
+        return value;
+    };
+    auto milliseconds = [&](const string& name, chrono::milliseconds& value) {
+        auto count = value.count();
+        istringstream(entry(name, to_string(count))) >> count;
+        value = chrono::milliseconds(max<decltype(count)>(0, count));
+    };
+
+    milliseconds("startup_window", settings.startupWindow);
+    milliseconds("initial_delay", settings.initialDelay);
+    milliseconds("max_delay", settings.maxDelay);
+    istringstream(entry("jitter", to_string(settings.jitter))) >> settings.jitter;
+    istringstream(entry("max_connects_per_network", to_string(settings.maxConnectsPerNetwork))) >> settings.maxConnectsPerNetwork;
+
+    settings.maxDelay = max(settings.maxDelay, settings.initialDelay);
+    settings.jitter = max(0.0, min(1.0, settings.jitter));
+    settings.maxConnectsPerNetwork = max<size_t>(1, settings.maxConnectsPerNetwork);
+}
+
+bool IrcReconnectScheduler::onEvent(std::shared_ptr<IEvent> event) {
+    if (event->getEventUuid() != EventTimer::uuid) return true;
+
+    lock_guard<mutex> lock(schedulerMutex);
+    auto it = timerRequests.find(event->as<EventTimer>()->getTimerId());
+    if (it == timerRequests.end()) return true; // cancelled
+    size_t requestId = it->second;
+    timerRequests.erase(it);
+
+    auto requestIt = requests.find(requestId);
+    if (requestIt != requests.end()) {
+        requestIt->second.timerId = 0;
+        tryGrant(requestId);
+    }
+    return true;
+}
+
+void IrcReconnectScheduler::tryGrant(size_t requestId) {
+    auto it = requests.find(requestId);
+    if (it == requests.end()) return; // cancelled
+
+    size_t& active = activeConnects[it->second.network];
+    if (active >= settings.maxConnectsPerNetwork) {
+        waiting[it->second.network].push_back(requestId);
+        return;
+    }
+    active += 1;
+    Grant grant = move(it->second.grant);
+    requests.erase(it);
+    // called with the lock held, cancel can't race with it
+    grant();
+}
+
+std::chrono::milliseconds IrcReconnectScheduler::getDelay(size_t failures, bool initial) {
+    if (initial) {
+        auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime);
+        if (elapsed >= settings.startupWindow)
+            return chrono::milliseconds(0);
+        // spread the connects of a restart over the rest of the window
+        uniform_int_distribution<long long> distribution(0, (settings.startupWindow - elapsed).count());
+        return chrono::milliseconds(distribution(random));
+    }
+
+    auto delay = settings.initialDelay;
+    for (size_t i = 0; i < failures && delay < settings.maxDelay; ++i)
+        delay *= 2;
+    delay = min(delay, settings.maxDelay);
+
+    uniform_real_distribution<double> distribution(1 - settings.jitter, 1 + settings.jitter);
+    return chrono::milliseconds(static_cast<long long>(delay.count() * distribution(random)));
+}
+
+size_t IrcReconnectScheduler::schedule(const std::string& network, size_t failures, bool initial, Grant grant) {
+    lock_guard<mutex> lock(schedulerMutex);
+    size_t requestId = ++lastRequestId;
+    auto& request = requests[requestId];
+    request.network = network;
+    request.grant = move(grant);
+    request.timerId = 0;
+
+    auto delay = getDelay(failures, initial);
+    if (delay.count() == 0) {
+        tryGrant(requestId);
+    } else {
+        request.timerId = scheduleAfter(delay);
+        timerRequests[request.timerId] = requestId;
+    }
+    return requestId;
+}
+
+bool IrcReconnectScheduler::cancel(size_t requestId) {
+    lock_guard<mutex> lock(schedulerMutex);
+    auto it = requests.find(requestId);
+    if (it == requests.end()) return false;
+    if (it->second.timerId != 0) {
+        cancelTimer(it->second.timerId);
+        timerRequests.erase(it->second.timerId);
+    }
+    // waiting entries of removed requests are skipped
+    requests.erase(it);
+    return true;
+}
+
+void IrcReconnectScheduler::finish(const std::string& network) {
+    lock_guard<mutex> lock(schedulerMutex);
+    auto activeIt = activeConnects.find(network);
+    if (activeIt == activeConnects.end() || activeIt->second == 0) return;
+    activeIt->second -= 1;
+
+    auto waitingIt = waiting.find(network);
+    while (waitingIt != waiting.end() && !waitingIt->second.empty()
+           && activeIt->second < settings.maxConnectsPerNetwork) {
+        size_t requestId = waitingIt->second.front();
+        waitingIt->second.pop_front();
+        tryGrant(requestId);
+    }
+    if (waitingIt != waiting.end() && waitingIt->second.empty())
+        waiting.erase(waitingIt);
+    if (activeIt->second == 0 && waiting.count(network) == 0)
+        activeConnects.erase(activeIt);
+}
@@ -0,0 +1,92 @@
+#ifndef IRCRECONNECTSCHEDULER_H
+#define IRCRECONNECTSCHEDULER_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include "queue/EventLoop.hpp"
+
+
+/// Decides when irc connections may connect, shared by all connections of the process.
+/// Reconnects are delayed with exponential backoff and jitter, connects of the first minutes
+/// are spread over a startup window and every network only sees a limited amount of
+/// concurrent connection attempts. Delays are timers of the scheduler's event loop.
+class IrcReconnectScheduler : public EventLoop {
+public:
+    /// Read from the category "reconnect" of config/irc.ini
+    struct Settings {
+        Settings();
+        /// First connects after the start are spread over this window
+        std::chrono::milliseconds startupWindow;
+        /// Delay after the first failed attempt
+        std::chrono::milliseconds initialDelay;
+        /// Upper bound of the backoff
+        std::chrono::milliseconds maxDelay;
+        /// Random part of a delay, 0.2 varies it by +-20%
+        double jitter;
+        /// Connection attempts per network until the registration succeeded or failed
+        size_t maxConnectsPerNetwork;
+    };
+
+    /// Called once the connection may connect, from an arbitrary thread
+    using Grant = std::function<void()>;
+
+private:
+    struct Request {
+        std::string network;
+        Grant grant;
+        /// Pending delay, 0 if the request waits for its network
+        size_t timerId;
+    };
+
+    Settings settings;
+    std::chrono::steady_clock::time_point startTime;
+
+    std::mutex schedulerMutex;
+    size_t lastRequestId;
+    /// Scheduled or waiting requests, cancelled ones are removed
+    std::unordered_map<size_t, Request> requests;
+    /// Requests of the pending timers
+    std::unordered_map<size_t, size_t> timerRequests;
+    /// Requests waiting for a free slot of their network
+    std::map<std::string, std::deque<size_t>> waiting;
+    /// Running attempts per network
+    std::map<std::string, size_t> activeConnects;
+    std::mt19937 random;
+
+    IrcReconnectScheduler();
+    void loadSettings();
+    /// Grants the request or lets it wait for its network, requires the lock
+    void tryGrant(size_t requestId);
+    /// Computes the delay of a connect, requires the lock
+    std::chrono::milliseconds getDelay(size_t failures, bool initial);
+public:
+    ~IrcReconnectScheduler();
+
+    /// Returns the scheduler shared by all connections
+    static IrcReconnectScheduler& getInstance();
+
+    /// Schedules a connect
+    ///
+    /// \param network Network to connect to, attempts are limited per network
+    /// \param failures Failed attempts since the last successful registration
+    /// \param initial True for the first connect of a connection, spread over the startup window
+    /// \param grant Called once the connection may connect, the slot has to be released with finish
+    /// \returns Id to cancel the request
+    size_t schedule(const std::string& network, size_t failures, bool initial, Grant grant);
+    /// Cancels a request which wasn't granted yet
+    ///
+    /// \returns False if the request was already granted, finish has to be called then
+    bool cancel(size_t requestId);
+    /// Ends a connection attempt once the registration succeeded or failed
+    void finish(const std::string& network);
+
+    virtual bool onEvent(std::shared_ptr<IEvent> event) override;
+};
+
+#endif
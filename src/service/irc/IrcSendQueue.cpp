@@ -0,0 +1,159 @@
+#include "IrcSendQueue.hpp"
+#include "utils/Ini.hpp"
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+
+
+const size_t IrcSendQueue::maxLineLength;
+
+IrcSendQueue::Settings::Settings()
+    : burst{5}
+    , rate{1}
+{
+}
+
+IrcSendQueue::IrcSendQueue(const Settings& settings)
+    : settings{settings}
+    , tokens{settings.burst}
+    , lastRefill{chrono::steady_clock::now()}
+{
+}
+
+IrcSendQueue::Settings IrcSendQueue::loadSettings(const std::string& serverName) {
+    // connections are created by several threads
+    static mutex iniMutex;
+    lock_guard<mutex> lock(iniMutex);
+
+    Settings settings;
+    Ini ircIni("config/irc.ini");
+    auto& defaults = ircIni.expectCategory("flood_control");
+
+    // missing defaults are written, overrides are optional
+    auto entry = [&](Ini::Entries& category, const string& name, double& value) {
+        string data;
+        if (ircIni.getEntry(category, name, data))
+            istringstream(data) >> value;
+        else if (&category == &defaults)
+            ircIni.setEntry(category, name, to_string(value));
+    };
+    entry(defaults, "burst", settings.burst);
+    entry(defaults, "rate", settings.rate);
+
+    string overrideName = "flood_control." + serverName;
+    if (ircIni.hasCategory(overrideName)) {
+        auto& overrides = ircIni.expectCategory(overrideName);
+        entry(overrides, "burst", settings.burst);
+        entry(overrides, "rate", settings.rate);
+    }
+
+    settings.burst = max(1.0, settings.burst);
+    settings.rate = max(0.01, settings.rate);
+    return settings;
+}
+
+void IrcSendQueue::setSettings(const Settings& lsettings) {
+    lock_guard<mutex> lock(queueMutex);
+    settings = lsettings;
+    tokens = min(tokens, settings.burst);
+}
+
+void IrcSendQueue::refill(std::chrono::steady_clock::time_point now) {
+    chrono::duration<double> elapsed = now - lastRefill;
+    if (elapsed.count() <= 0) return;
+    tokens = min(settings.burst, tokens + elapsed.count() * settings.rate);
+    lastRefill = now;
+}
+
+void IrcSendQueue::push(Priority priority, const std::string& line, std::shared_ptr<IEvent> sent) {
+    lock_guard<mutex> lock(queueMutex);
+    // line breaks would inject further commands
+    lines[static_cast<size_t>(priority)].push_back(Line{line.substr(0, min(line.find_first_of("\r\n"), maxLineLength)), move(sent)});
+}
+
+void IrcSendQueue::pushJoin(const std::string& channel, const std::string& key) {
+    lock_guard<mutex> lock(queueMutex);
+    if (key.empty())
+        joins.push_back(channel);
+    else
+        keyedJoins.emplace_back(channel, key);
+}
+
+std::string IrcSendQueue::packJoins() {
+    string channels;
+    string keys;
+    // "JOIN " plus the separating space of the keys
+    auto fits = [&](const string& channel, const string& key) {
+        size_t length = 5 + channels.size() + (channels.empty() ? 0 : 1) + channel.size();
+        if (!keys.empty() || !key.empty())
+            length += 1 + keys.size() + (keys.empty() ? 0 : 1) + key.size();
+        return length <= maxLineLength;
+    };
+    auto append = [](string& list, const string& item) {
+        if (!list.empty()) list.push_back(',');
+        list.append(item);
+    };
+
+    // keys belong to the first channels of the line
+    while (!keyedJoins.empty() && (channels.empty() || fits(keyedJoins.front().first, keyedJoins.front().second))) {
+        append(channels, keyedJoins.front().first);
+        append(keys, keyedJoins.front().second);
+        keyedJoins.pop_front();
+    }
+    while (!joins.empty() && (channels.empty() || fits(joins.front(), ""))) {
+        append(channels, joins.front());
+        joins.pop_front();
+    }
+
+    string line = "JOIN " + channels;
+    if (!keys.empty())
+        line += " " + keys;
+    return line.substr(0, maxLineLength);
+}
+
+bool IrcSendQueue::pop(std::string& line, std::shared_ptr<IEvent>& sent, std::chrono::steady_clock::time_point now) {
+    lock_guard<mutex> lock(queueMutex);
+    refill(now);
+    if (tokens < 1) return false;
+
+    sent.reset();
+    auto& high = lines[static_cast<size_t>(Priority::High)];
+    auto& normal = lines[static_cast<size_t>(Priority::Normal)];
+    if (!high.empty() || !normal.empty()) {
+        auto& lane = high.empty() ? normal : high;
+        line = move(lane.front().text);
+        sent = move(lane.front().sent);
+        lane.pop_front();
+    } else if (!keyedJoins.empty() || !joins.empty()) {
+        line = packJoins();
+    } else {
+        return false;
+    }
+    tokens -= 1;
+    return true;
+}
+
+std::chrono::milliseconds IrcSendQueue::getDelay(std::chrono::steady_clock::time_point now) {
+    lock_guard<mutex> lock(queueMutex);
+    if (lines[0].empty() && lines[1].empty() && keyedJoins.empty() && joins.empty())
+        return chrono::milliseconds::max();
+    refill(now);
+    if (tokens >= 1)
+        return chrono::milliseconds(0);
+    return chrono::milliseconds(static_cast<long long>((1 - tokens) / settings.rate * 1000) + 1);
+}
+
+size_t IrcSendQueue::clear() {
+    lock_guard<mutex> lock(queueMutex);
+    size_t dropped = 0;
+    for (auto& lane : lines) {
+        dropped += count_if(lane.begin(), lane.end(), [](const Line& line) { return line.sent != nullptr; });
+        lane.clear();
+    }
+    keyedJoins.clear();
+    joins.clear();
+    tokens = settings.burst;
+    lastRefill = chrono::steady_clock::now();
+    return dropped;
+}
@@ -0,0 +1,85 @@
+#ifndef IRCSENDQUEUE_H
+#define IRCSENDQUEUE_H
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+class IEvent;
+
+
+/// Outgoing lines of an irc connection, limited by a token bucket to avoid excess flood kills.
+/// User messages are sent before other commands, JOINs are packed into as few lines as possible.
+/// Filled by any thread, drained by the thread running the irc session.
+class IrcSendQueue {
+public:
+    /// Order in which queued lines are sent
+    enum class Priority {
+        /// Messages and actions of the user
+        High,
+        /// Other commands like NICK or PART
+        Normal
+    };
+
+    /// Flood control of a server, read from config/irc.ini
+    struct Settings {
+        Settings();
+        /// Lines which may be sent at once after being idle
+        double burst;
+        /// Lines per second after the burst was used
+        double rate;
+    };
+
+    /// Maximum line length without the trailing CRLF
+    static const size_t maxLineLength = 510;
+private:
+    struct Line {
+        std::string text;
+        /// Passed on once the line is sent, e.g. the echo of a message
+        std::shared_ptr<IEvent> sent;
+    };
+
+    Settings settings;
+    std::mutex queueMutex;
+    double tokens;
+    std::chrono::steady_clock::time_point lastRefill;
+    std::deque<Line> lines[2];
+    /// Channels with a key are listed first inside a JOIN line
+    std::deque<std::pair<std::string, std::string>> keyedJoins;
+    std::deque<std::string> joins;
+
+    void refill(std::chrono::steady_clock::time_point now);
+    /// Packs as many pending joins into one line as possible
+    std::string packJoins();
+public:
+    explicit IrcSendQueue(const Settings& settings = Settings());
+
+    /// Reads the flood control of a server, the category "flood_control.<server name>" overrides the defaults
+    static Settings loadSettings(const std::string& serverName);
+
+    /// Replaces the flood control settings
+    void setSettings(const Settings& settings);
+    /// Queues a raw line, it is cut at the first line break
+    ///
+    /// \param sent Returned by pop together with the line, dropped if the line is never sent
+    void push(Priority priority, const std::string& line, std::shared_ptr<IEvent> sent = nullptr);
+    /// Queues a channel to be joined with the next JOIN line
+    void pushJoin(const std::string& channel, const std::string& key = "");
+    /// Returns the next line if the rate limit allows sending it
+    ///
+    /// \param sent Receives the event queued with the line or nullptr
+    bool pop(std::string& line,
+             std::shared_ptr<IEvent>& sent,
+             std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+    /// Time until the next line may be sent, max() if the queue is empty
+    std::chrono::milliseconds getDelay(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+    /// Drops all lines and refills the bucket, used on reconnects
+    ///
+    /// \returns Amount of dropped lines which had an event
+    size_t clear();
+};
+
+#endif
@@ -18,12 +18,15 @@
 #include "event/irc/EventIrcReconnectServer.hpp"
 #include "service/irc/IrcChannelStore.hpp"
 #include "utils/IdProvider.hpp"
-#include <iostream>
+#include "utils/Logger.hpp"
 #include <mutex>
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("irc");
+
+
 IrcService::IrcService(size_t userId, EventQueue* appQueue)
     : EventLoop({
           EventQuit::uuid,
@@ -39,6 +42,7 @@ IrcService::IrcService(size_t userId, EventQueue* appQueue)
     , userId{userId}
     , appQueue{appQueue}
 {
+    setName("irc_service");
 }
 
 IrcService::~IrcService() {
@@ -49,11 +53,11 @@ bool IrcService::onEvent(std::shared_ptr<IEvent> event) {
 
     auto activateUser = event->as<EventIrcActivateService>();
     if (activateUser) {
-        cout << "[US] Received ActivateUser" << endl;
+        LOG_DEBUG(logModule) << "activating user" << logField("user", userId);
         auto& loginConfiguration = activateUser->getLoginConfiguration();
         for (auto entry : loginConfiguration) {
             auto& ircConfiguration = entry.second;
-            cout << "[US] CONFIG: " << ircConfiguration.getServerId() << endl;
+            LOG_DEBUG(logModule) << "adding server" << logField("user", userId) << logField("server", ircConfiguration.getServerId());
             ircConnections.emplace(piecewise_construct,
                                    forward_as_tuple(ircConfiguration.getServerId()),
                                    forward_as_tuple(appQueue, userId, ircConfiguration));
@@ -61,7 +65,7 @@ bool IrcService::onEvent(std::shared_ptr<IEvent> event) {
     }
 
     if (type == EventQuit::uuid) {
-        cout << "[US] received QUIT" << endl;
+        LOG_DEBUG(logModule) << "received quit" << logField("user", userId);
         ircConnections.clear();
         return false;
     } else if (type == EventIrcReconnectServer::uuid) {
@@ -113,53 +117,47 @@ bool IrcService::onEvent(std::shared_ptr<IEvent> event) {
         }
     } else if (type == EventQuery::uuid) {
         auto query = event->as<EventQuery>();
-        if (query->getType() == EventQueryType::Chats) {
+        if (query->getType() == EventQueryType::Chats
+            || query->getType() == EventQueryType::ChatsWithoutUsers) {
+            bool withUsers = query->getType() == EventQueryType::Chats;
             size_t firstId = IdProvider::getInstance().getLastId("irc_log"); // for backlog requests
             auto listing = make_shared<EventIrcChatListing>(firstId, userId, query->getData());
 
-            std::list<lock_guard<mutex>> locks;
-            // lock all to assure correct results
-            for (auto& cxnPair : ircConnections) {
-                auto& connection = cxnPair.second;
-                locks.emplace_back(connection.getChannelLoginDataMutex());
-            }
-
+            // snapshots are read without blocking the connections
             for (auto& cxnPair : ircConnections) {
                 auto& connection = cxnPair.second;
-                IrcServerListing& server = listing->addServer(connection.getActiveNick(),
+                auto snapshot = connection.getSnapshot();
+                IrcServerListing& server = listing->addServer(snapshot->activeNick,
                                                               connection.getServerId(),
                                                               connection.getServerName());
-                for (auto& channelPair : connection.getChannelStore()) {
-                    string channelName = channelPair.first;
-                    const IrcChannelStore& channelStore = channelPair.second;
-                    IrcChannelListing& channel = server.addChannel(channelName,
-                                                                   channelStore.getTopic(),
-                                                                   channelStore.getDisabled());
-                    for (auto& userPair : channelStore.getUsers()) {
-                        auto& userData = userPair.second;
-                        channel.addUser(userData.getNick(), userData.getMode());
+                for (auto& channelPair : snapshot->channels) {
+                    const IrcChannelSnapshot& channelSnapshot = *channelPair.second;
+                    IrcChannelListing& channel = server.addChannel(channelPair.first,
+                                                                   channelSnapshot.topic,
+                                                                   channelSnapshot.disabled);
+                    if (withUsers) {
+                        auto& names = *snapshot->names;
+                        for (auto& member : channelSnapshot.members)
+                            channel.addUser(names.getNick(member.id), names.toModeString(member.modeBits));
+                    } else {
+                        // clients request the users with EventIrcRequestUserlist
+                        channel.setUserCount(channelSnapshot.members.size());
                     }
                 }
             }
 
-            cout << "[US] Sending chat listing" << endl;
+            LOG_DEBUG(logModule) << "sending chat listing" << logField("user", userId);
             appQueue->sendEvent(listing);
         }
         else if (query->getType() == EventQueryType::Settings) {
             auto listing = make_shared<EventIrcSettingsListing>(userId, query->getData());
 
-            std::list<lock_guard<mutex>> locks;
-            // lock all to assure correct results
-            for (auto& cxnPair : ircConnections) {
-                auto& connection = cxnPair.second;
-                locks.emplace_back(connection.getChannelLoginDataMutex());
-            }
-
             for (auto& cxnPair : ircConnections) {
                 auto& connection = cxnPair.second;
+                auto snapshot = connection.getSnapshot();
                 auto& serverConfiguration = listing->addServer(connection.getServerId(),
                                                             connection.getServerName());
-                auto& connectionServerConfiguration = connection.getServerConfiguration();
+                auto& connectionServerConfiguration = *snapshot->configuration;
                 for (auto& nick : connectionServerConfiguration.getNicks())
                     serverConfiguration.addNick(nick);
                 for (auto& hostConfiguration : connectionServerConfiguration.getHostConfigurations()) {
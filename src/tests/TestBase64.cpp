@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "utils/Base64.hpp"
+
+
+static const vector<Base64::Kernel> kernels{Base64::Kernel::Sse41, Base64::Kernel::Avx2};
+
+static string makeRandom(mt19937& random, size_t length) {
+    uniform_int_distribution<int> byte(0, 255);
+    string data(length, '\0');
+    for (auto& c : data)
+        c = static_cast<char>(byte(random));
+    return data;
+}
+
+
+TEST(Base64, Alphabet) {
+    EXPECT_EQ("", Base64::encode(""));
+    EXPECT_EQ("QQ==", Base64::encode("A"));
+    EXPECT_EQ("QUI=", Base64::encode("AB"));
+    EXPECT_EQ("QUJD", Base64::encode("ABC"));
+    EXPECT_EQ("****", Base64::encode("\xfb\xef\xbe"));
+    EXPECT_EQ("////", Base64::encode("\xff\xff\xff"));
+
+    EXPECT_EQ("A", Base64::decode("QQ=="));
+    EXPECT_EQ("AB", Base64::decode("QUI="));
+    EXPECT_EQ("ABC", Base64::decode("QUJD"));
+    EXPECT_EQ("\xfb\xef\xbe", Base64::decode("****"));
+    EXPECT_EQ("", Base64::decode("++++"));
+    EXPECT_EQ("", Base64::decode("QUJ"));
+    EXPECT_EQ("", Base64::decode("Q==="));
+}
+
+TEST(Base64, RoundTrip) {
+    mt19937 random(1);
+    for (size_t length = 0; length < 200; ++length) {
+        string data = makeRandom(random, length);
+        string encoded = Base64::encode(data);
+        ASSERT_EQ(Base64::encodedLength(length), encoded.size());
+        if (length > 0) {
+            ASSERT_EQ(length, Base64::decodedLength(encoded));
+        }
+        ASSERT_EQ(data, Base64::decode(encoded)) << "length " << length;
+    }
+}
+
+TEST(Base64, FuzzEncodeKernels) {
+    mt19937 random(2);
+    uniform_int_distribution<size_t> length(0, 1000);
+    for (auto kernel : kernels) {
+        if (!Base64::isSupported(kernel)) continue;
+        for (int i = 0; i < 2000; ++i) {
+            string data = makeRandom(random, i < 100 ? i : length(random));
+            ASSERT_EQ(Base64::encode(data, Base64::Kernel::Scalar), Base64::encode(data, kernel))
+                << "kernel " << static_cast<int>(kernel) << ", length " << data.size();
+        }
+    }
+}
+
+TEST(Base64, FuzzDecodeKernels) {
+    mt19937 random(3);
+    uniform_int_distribution<size_t> length(0, 1000);
+    uniform_int_distribution<int> byte(0, 255);
+    for (auto kernel : kernels) {
+        if (!Base64::isSupported(kernel)) continue;
+        for (int i = 0; i < 2000; ++i) {
+            string encoded = Base64::encode(makeRandom(random, length(random)));
+            // every other input gets broken, including padding in between
+            if (i % 2 && !encoded.empty()) {
+                uniform_int_distribution<size_t> position(0, encoded.size() - 1);
+                encoded[position(random)] = i % 4 == 1 ? '=' : static_cast<char>(byte(random));
+            }
+            ASSERT_EQ(Base64::decode(encoded, Base64::Kernel::Scalar), Base64::decode(encoded, kernel))
+                << "kernel " << static_cast<int>(kernel) << ", input " << encoded;
+        }
+    }
+}
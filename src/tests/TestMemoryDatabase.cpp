@@ -0,0 +1,297 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+#include "queue/EventLoop.hpp"
+#include "queue/EventQueue.hpp"
+#include "event/EventInit.hpp"
+#include "event/EventDatabaseQuery.hpp"
+#include "event/EventDatabaseResult.hpp"
+#include "db/handler/Memory.hpp"
+#include "db/query/Database_Query.hpp"
+
+
+struct MemoryHandlerChecker : public EventLoop {
+    Database::Memory handler;
+    std::mutex resultMutex;
+    std::condition_variable resultCondition;
+    std::list<std::shared_ptr<IEvent>> results;
+
+    MemoryHandlerChecker()
+        : handler{getEventQueue()}
+    {
+    }
+
+    /// Sends the statements as one query and waits for its result
+    template<class... T>
+    std::shared_ptr<EventDatabaseResult> query(T&&... stmts) {
+        auto event = make_shared<EventDatabaseQuery>(getEventQueue(), make_shared<EventInit>(), std::forward<T>(stmts)...);
+        handler.getEventQueue()->sendEvent(event);
+
+        std::unique_lock<mutex> lock(resultMutex);
+        if (!resultCondition.wait_for(lock, std::chrono::seconds(3), [this]{ return !results.empty(); }))
+            return nullptr;
+        auto result = static_pointer_cast<EventDatabaseResult>(results.front());
+        results.pop_front();
+        return result;
+    }
+
+    void setupTable() {
+        using namespace Query;
+
+        Create stmt = create("test_memory")
+            .field("id", FieldType::Id)
+            .field("key", FieldType::Text)
+            .field("number", FieldType::Integer);
+        auto result = query(std::move(stmt));
+        ASSERT_TRUE(result && result->getSuccess());
+
+        Insert stmtInsert = insert()
+            .into("test_memory")
+            .format("key", "number")
+            .data(vector<string>{"test0", "10", "test1", "9", "test2", "100"});
+        result = query(std::move(stmtInsert));
+        ASSERT_TRUE(result && result->getSuccess());
+    }
+
+    virtual bool onEvent(std::shared_ptr<IEvent> event) override {
+        if (event->getEventUuid() == EventDatabaseResult::uuid) {
+            std::lock_guard<mutex> lock(resultMutex);
+            results.push_back(event);
+            resultCondition.notify_one();
+        }
+        return true;
+    }
+};
+
+TEST(MemoryDatabase, SelectFilter) {
+    using namespace Query;
+    MemoryHandlerChecker checker;
+    checker.setupTable();
+
+    // serial ids are assigned in insertion order
+    Select stmt = select("id", "key")
+        .from("test_memory")
+        .where(make_var("id") == make_constant("2"));
+    auto result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"2", "test1"}), result->getResults());
+
+    // integers compare as numbers, not as text
+    stmt = select("key")
+        .from("test_memory")
+        .where(make_var("number") > make_constant("9") && make_var("number") < make_constant("100"));
+    result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"test0"}), result->getResults());
+
+    stmt = select("key")
+        .from("test_memory")
+        .where(make_var("key") == make_constant("test0") || make_var("id") > make_constant("2"));
+    result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"test0", "test2"}), result->getResults());
+
+    // table and column names are case insensitive
+    stmt = select("KEY")
+        .from("Test_Memory")
+        .where(make_var("key") != make_constant("test1"));
+    result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"test0", "test2"}), result->getResults());
+}
+
+TEST(MemoryDatabase, SelectOrderLimit) {
+    using namespace Query;
+    MemoryHandlerChecker checker;
+    checker.setupTable();
+
+    Select stmt = select("id")
+        .from("test_memory")
+        .limit(2);
+    auto result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"1", "2"}), result->getResults());
+
+    stmt = select("id")
+        .from("test_memory")
+        .order_by("id", "DESC")
+        .limit(1);
+    result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"3"}), result->getResults());
+
+    // ordered index walk starting below a bound
+    stmt = select("id")
+        .from("test_memory")
+        .where(make_var("id") < make_constant("3"))
+        .order_by("number", "DESC")
+        .limit(1);
+    result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"1"}), result->getResults());
+
+    stmt = select("key")
+        .from("test_memory")
+        .order_by("number", "ASC");
+    result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"test1", "test0", "test2"}), result->getResults());
+}
+
+TEST(MemoryDatabase, UpdateDelete) {
+    using namespace Query;
+    MemoryHandlerChecker checker;
+    checker.setupTable();
+
+    // index the column before changing it
+    Select stmt = select("id")
+        .from("test_memory")
+        .where(make_var("key") == make_constant("test0"));
+    auto result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"1"}), result->getResults());
+
+    Update stmtUpdate = update("test_memory")
+        .format("key")
+        .data(std::vector<std::string>{"replaced"})
+        .where(make_var("id") == make_constant("1"));
+    result = checker.query(std::move(stmtUpdate));
+    ASSERT_TRUE(result && result->getSuccess());
+
+    stmt = select("id")
+        .from("test_memory")
+        .where(make_var("key") == make_constant("replaced"));
+    result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"1"}), result->getResults());
+
+    stmt = select("id")
+        .from("test_memory")
+        .where(make_var("key") == make_constant("test0"));
+    result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_TRUE(result->getResults().empty());
+
+    Delete stmtDelete = erase()
+        .from("test_memory")
+        .where(make_var("number") > make_constant("9"));
+    result = checker.query(std::move(stmtDelete));
+    ASSERT_TRUE(result && result->getSuccess());
+
+    stmt = select("id", "key")
+        .from("test_memory");
+    result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"2", "test1"}), result->getResults());
+
+    // serial ids continue after deleted rows
+    Insert stmtInsert = insert()
+        .into("test_memory")
+        .format("key")
+        .data(vector<string>{"test3"});
+    result = checker.query(std::move(stmtInsert));
+    ASSERT_TRUE(result && result->getSuccess());
+
+    stmt = select("id")
+        .from("test_memory")
+        .where(make_var("key") == make_constant("test3"));
+    result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"4"}), result->getResults());
+}
+
+TEST(MemoryDatabase, Join) {
+    using namespace Query;
+    MemoryHandlerChecker checker;
+
+    Create stmt1 = create("test_memoryjoin")
+        .field("id", FieldType::Id)
+        .field("key", FieldType::Text)
+        .field("name_ref", FieldType::Integer);
+    Create stmt2 = create("test_memoryjoin_name")
+        .field("name_id", FieldType::Id)
+        .field("name", FieldType::Text);
+    auto result = checker.query(std::move(stmt1), std::move(stmt2));
+    ASSERT_TRUE(result && result->getSuccess());
+
+    // the second insert reuses the referenced row
+    for (auto& key : {"test0", "test1"}) {
+        Insert stmt = insert()
+            .into("test_memoryjoin")
+            .format("key")
+            .join("test_memoryjoin_name", "name", "testname")
+            .data(std::vector<std::string>{key});
+        result = checker.query(std::move(stmt));
+        ASSERT_TRUE(result && result->getSuccess());
+    }
+    Insert stmt = insert()
+        .into("test_memoryjoin")
+        .format("key")
+        .join("test_memoryjoin_name", "name", "othername")
+        .data(std::vector<std::string>{"test2"});
+    result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+
+    Select select1 = select("name_id", "name")
+        .from("test_memoryjoin_name");
+    result = checker.query(std::move(select1));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"1", "testname", "2", "othername"}), result->getResults());
+
+    Select select2 = select("id", "key", "name")
+        .from("test_memoryjoin")
+        .join("test_memoryjoin_name", "name")
+        .where(make_var("name") == make_constant("testname"))
+        .order_by("id", "DESC");
+    result = checker.query(std::move(select2));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"2", "test1", "testname", "1", "test0", "testname"}), result->getResults());
+}
+
+TEST(MemoryDatabase, Types) {
+    using namespace Query;
+    MemoryHandlerChecker checker;
+
+    Create stmt = create("test_memorytypes")
+        .field("id", FieldType::Id)
+        .field("time", FieldType::Time);
+    auto result = checker.query(std::move(stmt));
+    ASSERT_TRUE(result && result->getSuccess());
+
+    // ctime() output is read back like a postgres timestamp
+    Insert stmtInsert = insert()
+        .into("test_memorytypes")
+        .format("id", "time")
+        .data(vector<string>{"5", "Wed Jun 30 21:49:08 1993\n"});
+    result = checker.query(std::move(stmtInsert));
+    ASSERT_TRUE(result && result->getSuccess());
+
+    Select stmtSelect = select("time")
+        .from("test_memorytypes");
+    result = checker.query(std::move(stmtSelect));
+    ASSERT_TRUE(result && result->getSuccess());
+    ASSERT_EQ((list<string>{"1993-06-30 21:49:08"}), result->getResults());
+
+    // ids are unique
+    stmtInsert = insert()
+        .into("test_memorytypes")
+        .format("id", "time")
+        .data(vector<string>{"5", "Wed Jun 30 21:49:08 1993\n"});
+    result = checker.query(std::move(stmtInsert));
+    ASSERT_TRUE(result && !result->getSuccess());
+
+    // unknown tables and columns fail the query
+    stmtSelect = select("time")
+        .from("test_memorymissing");
+    result = checker.query(std::move(stmtSelect));
+    ASSERT_TRUE(result && !result->getSuccess());
+
+    stmtSelect = select("missing")
+        .from("test_memorytypes");
+    result = checker.query(std::move(stmtSelect));
+    ASSERT_TRUE(result && !result->getSuccess());
+}
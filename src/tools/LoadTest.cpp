@@ -0,0 +1,215 @@
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "tools/loadtest/LoadTestFixture.hpp"
+#include "tools/loadtest/MockIrcd.hpp"
+#include "tools/loadtest/WebsocketSwarm.hpp"
+#include "utils/Ini.hpp"
+
+using namespace std;
+
+
+/// Settings of a load test run, see src/tools/loadtest/scenario.ini
+struct Scenario {
+    LoadTestFixture::Settings fixture;
+    MockIrcd::Settings ircd;
+    WebsocketSwarm::Settings swarm;
+    /// Time between the logins and the measurement
+    chrono::milliseconds warmup{5000};
+    chrono::milliseconds duration{30000};
+};
+
+template<typename T>
+static void readNumber(Ini& ini, const std::string& category, const std::string& name, T& value) {
+    string data;
+    if (ini.getEntry(category, name, data))
+        istringstream(data) >> value;
+}
+
+static void readMilliseconds(Ini& ini, const std::string& category, const std::string& name, chrono::milliseconds& value) {
+    auto count = value.count();
+    readNumber(ini, category, name, count);
+    value = chrono::milliseconds(count);
+}
+
+/// Reads the entries of a scenario, missing entries keep their defaults
+static void loadScenario(const std::string& filename, Scenario& scenario) {
+    Ini ini(filename);
+
+    ini.getEntry("harpoon", "directory", scenario.fixture.directory);
+    readNumber(ini, "harpoon", "channels", scenario.fixture.channels);
+    ini.getEntry("harpoon", "log_level", scenario.fixture.logLevel);
+
+    readNumber(ini, "ircd", "port", scenario.ircd.port);
+    readNumber(ini, "ircd", "users_per_channel", scenario.ircd.usersPerChannel);
+    readNumber(ini, "ircd", "messages_per_second", scenario.ircd.messagesPerSecond);
+    readNumber(ini, "ircd", "churn_per_second", scenario.ircd.churnPerSecond);
+    readMilliseconds(ini, "ircd", "netsplit_interval", scenario.ircd.netsplitInterval);
+    readNumber(ini, "ircd", "netsplit_fraction", scenario.ircd.netsplitFraction);
+    readMilliseconds(ini, "ircd", "netsplit_duration", scenario.ircd.netsplitDuration);
+
+    readNumber(ini, "swarm", "port", scenario.swarm.port);
+    readNumber(ini, "swarm", "clients", scenario.swarm.clients);
+    readMilliseconds(ini, "swarm", "warmup", scenario.warmup);
+    readMilliseconds(ini, "swarm", "duration", scenario.duration);
+}
+
+/// Starts harpoon inside the fixture directory, its output goes to harpoon.log
+static pid_t spawnHarpoon(const std::string& binary, const std::string& directory) {
+    char path[PATH_MAX];
+    if (!realpath(binary.c_str(), path)) {
+        cerr << binary << ": " << strerror(errno) << endl;
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid != 0) return pid;
+
+    if (chdir(directory.c_str()) != 0) _exit(1);
+    int log = open("harpoon.log", O_WRONLY | O_CREAT | O_TRUNC, 0640);
+    if (log >= 0) {
+        dup2(log, STDOUT_FILENO);
+        dup2(log, STDERR_FILENO);
+    }
+    execl(path, path, static_cast<char*>(nullptr));
+    _exit(1);
+}
+
+/// Waits until the websocket server accepts connections
+static bool waitForPort(uint16_t port, pid_t harpoon, chrono::seconds timeout) {
+    auto deadline = chrono::steady_clock::now() + timeout;
+    while (chrono::steady_clock::now() < deadline) {
+        int status;
+        if (harpoon > 0 && waitpid(harpoon, &status, WNOHANG) == harpoon)
+            return false;
+
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bool connected = connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        close(fd);
+        if (connected) return true;
+        this_thread::sleep_for(chrono::milliseconds(100));
+    }
+    return false;
+}
+
+static void printReport(const WebsocketSwarm::Report& report, const MockIrcd::Statistics& ircd) {
+    double seconds = chrono::duration_cast<chrono::duration<double>>(report.duration).count();
+    auto milliseconds = [&report](double percentile) {
+        return report.latency.getValueAtPercentile(percentile) / 1000.0;
+    };
+
+    cout << fixed << setprecision(1)
+         << "clients    " << report.connected << " connected, " << report.loggedIn << " logged in" << endl
+         << "ircd       " << ircd.connections << " connections, " << ircd.messages << " messages, "
+         << ircd.joins << " joins, " << ircd.parts << " parts, " << ircd.netsplits << " netsplits" << endl
+         << "delivered  " << report.messages << " messages in " << seconds << " s, "
+         << (seconds > 0 ? report.messages / seconds : 0) << " messages/s, "
+         << (seconds > 0 ? report.bytes / seconds / 1024 : 0) << " KiB/s" << endl
+         << setprecision(2)
+         << "latency ms p50 " << milliseconds(50)
+         << ", p90 " << milliseconds(90)
+         << ", p99 " << milliseconds(99)
+         << ", p99.9 " << milliseconds(99.9)
+         << ", max " << report.latency.getMax() / 1000.0
+         << " (" << report.latency.getCount() << " samples)" << endl;
+}
+
+static void printUsage(const char* name) {
+    cout << "Load test of a harpoon build against a local mock irc server" << endl
+         << "Writes the configuration of an instance whose users join channels on the mock ircd,"
+         << " logs in a websocket client per user and measures the delivery of the simulated traffic" << endl
+         << endl
+         << name << " [--scenario <ini>] [--harpoon <binary>]" << endl
+         << "  --scenario  settings of the run, see src/tools/loadtest/scenario.ini" << endl
+         << "  --harpoon   binary started inside the fixture directory, an already running instance is used otherwise" << endl;
+}
+
+int main(int argc, char** argv) {
+    string scenarioFile, harpoonBinary;
+    for (int i = 1; i < argc; ++i) {
+        string argument = argv[i];
+        if (argument == "--scenario" && i + 1 < argc) {
+            scenarioFile = argv[++i];
+        } else if (argument == "--harpoon" && i + 1 < argc) {
+            harpoonBinary = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return argument == "--help" ? 0 : 1;
+        }
+    }
+
+    Scenario scenario;
+    if (!scenarioFile.empty())
+        loadScenario(scenarioFile, scenario);
+    scenario.fixture.users = scenario.swarm.clients;
+    scenario.fixture.userPrefix = scenario.swarm.userPrefix;
+    scenario.fixture.password = scenario.swarm.password;
+    scenario.fixture.ircdPort = scenario.ircd.port;
+
+    cout << "writing the configuration of " << scenario.fixture.users << " users to " << scenario.fixture.directory << endl;
+    if (!LoadTestFixture::write(scenario.fixture)) {
+        cerr << "could not create " << scenario.fixture.directory << endl;
+        return 1;
+    }
+
+    MockIrcd ircd(scenario.ircd);
+    if (!ircd.start()) {
+        cerr << "could not listen on port " << scenario.ircd.port << endl;
+        return 1;
+    }
+
+    pid_t harpoon = -1;
+    if (!harpoonBinary.empty()) {
+        harpoon = spawnHarpoon(harpoonBinary, scenario.fixture.directory);
+        if (harpoon < 0) return 1;
+    } else {
+        cout << "waiting for harpoon to be started in " << scenario.fixture.directory << endl;
+    }
+    auto stopHarpoon = [harpoon] {
+        if (harpoon <= 0) return;
+        kill(harpoon, SIGTERM);
+        waitpid(harpoon, nullptr, 0);
+    };
+
+    if (!waitForPort(scenario.swarm.port, harpoon, chrono::seconds(harpoon > 0 ? 30 : 300))) {
+        cerr << "harpoon did not open port " << scenario.swarm.port << ", see harpoon.log of the fixture" << endl;
+        stopHarpoon();
+        return 1;
+    }
+
+    WebsocketSwarm swarm(scenario.swarm);
+    size_t connected = swarm.start();
+    size_t loggedIn = swarm.waitForLogins(chrono::seconds(30));
+    cout << loggedIn << " of " << connected << " clients logged in" << endl;
+
+    this_thread::sleep_for(scenario.warmup);
+    cout << "measuring for " << scenario.duration.count() << " ms" << endl;
+    swarm.beginMeasurement();
+    this_thread::sleep_for(scenario.duration);
+    auto report = swarm.endMeasurement();
+
+    swarm.stop();
+    stopHarpoon();
+    ircd.stop();
+
+    printReport(report, ircd.getStatistics());
+    return loggedIn > 0 && report.messages > 0 ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include "app/Application.hpp"
+#include "app/EventTrace.hpp"
+#include "utils/Logger.hpp"
+
+using namespace std;
+
+
+/// Prints the amount and payload size of every event type of a trace
+static int printStatistics(const std::string& filename) {
+    EventTraceReader reader(filename);
+    if (!reader.isValid()) {
+        cerr << filename << " is no event trace" << endl;
+        return 1;
+    }
+
+    struct TypeStatistics {
+        size_t events = 0;
+        size_t bytes = 0;
+    };
+    map<UUID, TypeStatistics> types;
+    size_t events = 0;
+    EventTraceRecord record;
+    chrono::microseconds duration{0};
+    while (reader.next(record)) {
+        auto& type = types[record.uuid];
+        type.events += 1;
+        type.bytes += record.payload.size();
+        duration = record.offset;
+        ++events;
+    }
+
+    double seconds = chrono::duration_cast<chrono::duration<double>>(duration).count();
+    cout << events << " events in " << seconds << " seconds" << endl;
+    cout << setw(6) << "uuid" << setw(12) << "events" << setw(14) << "bytes" << setw(12) << "per second" << endl;
+    for (auto& type : types) {
+        cout << setw(6) << type.first
+             << setw(12) << type.second.events
+             << setw(14) << type.second.bytes
+             << setw(12) << fixed << setprecision(1) << (seconds > 0 ? type.second.events / seconds : 0)
+             << endl;
+    }
+    return 0;
+}
+
+static void printUsage(const char* name) {
+    cout << "Replays an event trace recorded by harpoon, see [recording] in config/core.ini" << endl
+         << "Runs with the configuration of the working directory, irc networks and the database are replaced by stand-ins" << endl
+         << endl
+         << name << " [--fast] <trace>  replay with the recorded timing or as fast as possible" << endl
+         << name << " --stats <trace>   print the events of a trace by type" << endl;
+}
+
+int main(int argc, char** argv) {
+    Application::Settings settings;
+    bool statistics = false;
+    for (int i = 1; i < argc; ++i) {
+        string argument = argv[i];
+        if (argument == "--fast") {
+            settings.replayFast = true;
+        } else if (argument == "--stats") {
+            statistics = true;
+        } else if (argument.size() > 0 && argument[0] != '-' && settings.replayFile.empty()) {
+            settings.replayFile = argument;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (settings.replayFile.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (statistics)
+        return printStatistics(settings.replayFile);
+
+    try {
+        Application app(settings);
+    } catch(runtime_error& run) {
+        LOG_ERROR(Logger::getInstance().getModule("application")) << run.what();
+    }
+    Logger::getInstance().flush();
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "LoadTestFixture.hpp"
+#include "utils/Filesystem.hpp"
+#include "utils/Ini.hpp"
+#include "utils/Password.hpp"
+#include <cstdio>
+
+using namespace std;
+
+
+LoadTestFixture::Settings::Settings()
+    : directory{"loadtest"}
+    , users{10}
+    , userPrefix{"load"}
+    , password{"load"}
+    , channels{5}
+    , ircdPort{16667}
+    , logLevel{"warning"}
+{
+}
+
+bool LoadTestFixture::write(const Settings& settings) {
+    auto& filesystem = Filesystem::getInstance();
+    string config = settings.directory + "/config";
+    // seasocks serves static files of the working directory's "public" folder
+    if (!filesystem.createPathRecursive(config) || !filesystem.createPathRecursive(settings.directory + "/public"))
+        return false;
+
+    // ini files keep the entries of existing files, start from scratch instead
+    auto fresh = [](const string& filename) {
+        remove(filename.c_str());
+        return filename;
+    };
+
+    {
+        Ini core(fresh(config + "/core.ini"));
+        auto& modules = core.expectCategory("modules");
+        core.setEntry(modules, "login", "ini");
+        core.setEntry(modules, "webchat", "y");
+        core.setEntry(modules, "database", "none");
+        auto& services = core.expectCategory("services");
+        core.setEntry(services, "irc", "y");
+        core.setEntry(services, "hack", "n");
+        core.setEntry("logging", "level", settings.logLevel);
+    }
+    {
+        Ini irc(fresh(config + "/irc.ini"));
+        auto& modules = irc.expectCategory("modules");
+        irc.setEntry(modules, "settings_database", "ini");
+        irc.setEntry(modules, "backlog", "n");
+        // all users connect to the same network at once
+        auto& reconnect = irc.expectCategory("reconnect");
+        irc.setEntry(reconnect, "startup_window", "0");
+        irc.setEntry(reconnect, "max_connects_per_network", to_string(settings.users));
+        auto& floodControl = irc.expectCategory("flood_control");
+        irc.setEntry(floodControl, "burst", "100");
+        irc.setEntry(floodControl, "rate", "100");
+    }
+
+    Ini users(fresh(config + "/users.ini"));
+    for (size_t userId = 1; userId <= settings.users; ++userId) {
+        Password password(settings.password);
+        auto& user = users.expectCategory(settings.userPrefix + to_string(userId));
+        users.setEntry(user, "id", to_string(userId));
+        users.setEntry(user, "salt", password.getSaltBase64());
+        users.setEntry(user, "password", password.getHashBase64());
+
+        string userDirectory = config + "/user" + to_string(userId);
+        if (!filesystem.createPathRecursive(userDirectory + "/server1"))
+            return false;
+
+        Ini servers(fresh(userDirectory + "/irc.servers.ini"));
+        auto& server = servers.expectCategory("mock");
+        servers.setEntry(server, "id", "1");
+        servers.setEntry(server, "nicks", settings.userPrefix + to_string(userId));
+
+        Ini hosts(fresh(userDirectory + "/server1/hosts.ini"));
+        auto& host = hosts.expectCategory("127.0.0.1:" + to_string(settings.ircdPort));
+        hosts.setEntry(host, "password", "");
+        hosts.setEntry(host, "ipV6", "n");
+        hosts.setEntry(host, "ssl", "n");
+
+        Ini channels(fresh(userDirectory + "/server1/channels.ini"));
+        for (size_t channelIndex = 0; channelIndex < settings.channels; ++channelIndex) {
+            auto& channel = channels.expectCategory("#load" + to_string(channelIndex));
+            channels.setEntry(channel, "id", to_string((userId - 1) * settings.channels + channelIndex + 1));
+            channels.setEntry(channel, "password", "");
+            channels.setEntry(channel, "disabled", "no");
+        }
+    }
+
+    Ini ids(fresh(config + "/ids.ini"));
+    auto& idMap = ids.expectCategory("ids");
+    ids.setEntry(idMap, "user", to_string(settings.users));
+    ids.setEntry(idMap, "server", "1");
+    ids.setEntry(idMap, "channel", to_string(settings.users * settings.channels));
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef LOADTESTFIXTURE_H
+#define LOADTESTFIXTURE_H
+
+#include <cstdint>
+#include <string>
+
+
+/// Configuration directory of a harpoon instance under load, every user connects to the mock ircd
+class LoadTestFixture {
+public:
+    /// Read from the category "harpoon" of the load test scenario
+    struct Settings {
+        Settings();
+        /// Working directory of the instance, the configuration is written to its "config" folder
+        std::string directory;
+        /// Users named <userPrefix><n> for n in [1, users], all with the same password
+        size_t users;
+        std::string userPrefix;
+        std::string password;
+        /// Channels every user joins
+        size_t channels;
+        uint16_t ircdPort;
+        /// Default log level of the instance
+        std::string logLevel;
+    };
+
+    /// Writes the configuration, files of a previous run are replaced
+    ///
+    /// \returns False if the directories couldn't be created
+    static bool write(const Settings& settings);
+};
+
+#endif
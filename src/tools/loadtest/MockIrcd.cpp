@@ -0,0 +1,334 @@
+#include "MockIrcd.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+static const string serverName = "mock.invalid";
+/// Nicks per NAMES reply line
+static const size_t namesPerLine = 40;
+
+MockIrcd::Settings::Settings()
+    : port{6667}
+    , usersPerChannel{100}
+    , messagesPerSecond{10}
+    , churnPerSecond{1}
+    , netsplitInterval{0}
+    , netsplitFraction{0.3}
+    , netsplitDuration{5000}
+{
+}
+
+MockIrcd::Statistics::Statistics()
+    : connections{0}
+    , messages{0}
+    , joins{0}
+    , parts{0}
+    , netsplits{0}
+    , received{0}
+{
+}
+
+MockIrcd::MockIrcd(const Settings& settings)
+    : settings{settings}
+    , listenFd{-1}
+    , running{false}
+    , random{random_device{}()}
+    , sequence{0}
+{
+}
+
+MockIrcd::~MockIrcd() {
+    stop();
+}
+
+bool MockIrcd::start() {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) return false;
+
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(settings.port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listenFd, 128) != 0) {
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL) | O_NONBLOCK);
+
+    running = true;
+    thread = std::thread([this]{ run(); });
+    return true;
+}
+
+void MockIrcd::stop() {
+    if (!running) return;
+    running = false;
+    thread.join();
+    for (auto& session : sessions)
+        close(session.fd);
+    sessions.clear();
+    close(listenFd);
+    listenFd = -1;
+}
+
+const MockIrcd::Statistics& MockIrcd::getStatistics() const {
+    return statistics;
+}
+
+void MockIrcd::run() {
+    auto lastTick = chrono::steady_clock::now();
+    vector<pollfd> fds;
+    while (running) {
+        fds.clear();
+        fds.push_back(pollfd{listenFd, POLLIN, 0});
+        for (auto& session : sessions)
+            fds.push_back(pollfd{session.fd, static_cast<short>(POLLIN | (session.output.empty() ? 0 : POLLOUT)), 0});
+        poll(fds.data(), fds.size(), 10);
+
+        if (fds[0].revents & POLLIN)
+            accept();
+
+        auto now = chrono::steady_clock::now();
+        double seconds = chrono::duration_cast<chrono::duration<double>>(now - lastTick).count();
+        lastTick = now;
+
+        // sessions accepted in this round aren't part of fds yet
+        for (size_t i = 0; i < sessions.size(); ++i) {
+            auto& session = sessions[i];
+            bool open = true;
+            if (i + 1 < fds.size() && (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+                open = read(session);
+            if (open) {
+                simulate(session, now, seconds);
+                open = write(session);
+            }
+            if (!open) {
+                close(session.fd);
+                session.fd = -1;
+            }
+        }
+        sessions.erase(remove_if(sessions.begin(), sessions.end(), [](const Session& session) {
+            return session.fd < 0;
+        }), sessions.end());
+    }
+}
+
+void MockIrcd::accept() {
+    int fd;
+    while ((fd = ::accept(listenFd, nullptr, nullptr)) >= 0) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        Session session;
+        session.fd = fd;
+        session.registered = false;
+        session.messageBudget = 0;
+        session.churnBudget = 0;
+        session.nextNetsplit = chrono::steady_clock::now() + settings.netsplitInterval;
+        session.rejoin = chrono::steady_clock::time_point::max();
+        sessions.push_back(std::move(session));
+        ++statistics.connections;
+    }
+}
+
+bool MockIrcd::read(Session& session) {
+    char buffer[4096];
+    for (;;) {
+        ssize_t length = recv(session.fd, buffer, sizeof(buffer), 0);
+        if (length == 0) return false;
+        if (length < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        session.input.append(buffer, length);
+    }
+
+    size_t start = 0, end;
+    while ((end = session.input.find('\n', start)) != string::npos) {
+        string line = session.input.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        handleLine(session, line);
+        start = end + 1;
+    }
+    session.input.erase(0, start);
+    return true;
+}
+
+bool MockIrcd::write(Session& session) {
+    while (!session.output.empty()) {
+        ssize_t length = ::send(session.fd, session.output.data(), session.output.size(), MSG_NOSIGNAL);
+        if (length < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        session.output.erase(0, length);
+    }
+    return true;
+}
+
+void MockIrcd::send(Session& session, const std::string& line) {
+    session.output += line;
+    session.output += "\r\n";
+}
+
+void MockIrcd::handleLine(Session& session, const std::string& line) {
+    istringstream is(line);
+    string command;
+    is >> command;
+    if (!command.empty() && command[0] == ':')
+        is >> command;
+
+    if (command == "NICK") {
+        string nick;
+        is >> nick;
+        if (session.registered)
+            send(session, ":" + session.nick + "!load@" + serverName + " NICK :" + nick);
+        session.nick = nick;
+    } else if (command == "USER" && !session.registered) {
+        session.registered = true;
+        string me = session.nick;
+        send(session, ":" + serverName + " 001 " + me + " :Welcome to the load test network " + me);
+        send(session, ":" + serverName + " 004 " + me + " " + serverName + " mock-1.0 iow ovntk");
+        send(session, ":" + serverName + " 005 " + me + " PREFIX=(ov)@+ CHANTYPES=# CASEMAPPING=rfc1459 :are supported by this server");
+        send(session, ":" + serverName + " 375 " + me + " :- " + serverName + " Message of the day -");
+        send(session, ":" + serverName + " 376 " + me + " :End of /MOTD command.");
+    } else if (command == "PING") {
+        string token;
+        getline(is >> ws, token);
+        send(session, ":" + serverName + " PONG " + serverName + " " + token);
+    } else if (command == "JOIN") {
+        string channels;
+        is >> channels;
+        join(session, channels);
+    } else if (command == "PART") {
+        string channels;
+        is >> channels;
+        istringstream cs(channels);
+        string name;
+        while (getline(cs, name, ',')) {
+            auto it = find_if(session.channels.begin(), session.channels.end(), [&name](const Channel& channel) {
+                return channel.name == name;
+            });
+            if (it == session.channels.end()) continue;
+            session.channels.erase(it);
+            send(session, ":" + session.nick + "!load@" + serverName + " PART " + name);
+        }
+    } else if (command == "PRIVMSG" || command == "NOTICE") {
+        ++statistics.received;
+    }
+}
+
+void MockIrcd::join(Session& session, const std::string& channels) {
+    istringstream cs(channels);
+    string name;
+    while (getline(cs, name, ',')) {
+        if (name.empty() || name[0] != '#') continue;
+        bool joined = any_of(session.channels.begin(), session.channels.end(), [&name](const Channel& channel) {
+            return channel.name == name;
+        });
+        if (joined) continue;
+
+        Channel channel;
+        channel.name = name;
+        for (size_t i = 0; i < settings.usersPerChannel; ++i)
+            channel.present.push_back(name.substr(1) + "_" + to_string(i));
+
+        send(session, ":" + session.nick + "!load@" + serverName + " JOIN :" + name);
+        send(session, ":" + serverName + " 332 " + session.nick + " " + name + " :Load test channel");
+        // the first user is op, every tenth one voiced
+        string names = session.nick;
+        size_t count = 1;
+        for (size_t i = 0; i < channel.present.size(); ++i) {
+            if (count > 0)
+                names += ' ';
+            names += (i == 0 ? "@" : (i % 10 == 0 ? "+" : "")) + channel.present[i];
+            if (++count == namesPerLine) {
+                send(session, ":" + serverName + " 353 " + session.nick + " = " + name + " :" + names);
+                names.clear();
+                count = 0;
+            }
+        }
+        if (!names.empty())
+            send(session, ":" + serverName + " 353 " + session.nick + " = " + name + " :" + names);
+        send(session, ":" + serverName + " 366 " + session.nick + " " + name + " :End of /NAMES list.");
+        session.channels.push_back(std::move(channel));
+    }
+}
+
+void MockIrcd::simulate(Session& session, std::chrono::steady_clock::time_point now, double seconds) {
+    if (!session.registered || session.channels.empty()) return;
+
+    auto pick = [this](size_t size) {
+        return uniform_int_distribution<size_t>(0, size - 1)(random);
+    };
+
+    session.messageBudget += settings.messagesPerSecond * seconds;
+    for (; session.messageBudget >= 1; session.messageBudget -= 1) {
+        auto& channel = session.channels[pick(session.channels.size())];
+        if (channel.present.empty()) continue;
+        auto& nick = channel.present[pick(channel.present.size())];
+        auto sent = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+        ostringstream line;
+        line << ":" << nick << "!load@" << serverName << " PRIVMSG " << channel.name << " :load " << ++sequence << " " << sent;
+        send(session, line.str());
+        ++statistics.messages;
+    }
+
+    session.churnBudget += settings.churnPerSecond * seconds;
+    for (; session.churnBudget >= 1; session.churnBudget -= 1) {
+        auto& channel = session.channels[pick(session.channels.size())];
+        bool rejoin = !channel.absent.empty() && (channel.present.empty() || pick(2) == 0);
+        auto& from = rejoin ? channel.absent : channel.present;
+        auto& to = rejoin ? channel.present : channel.absent;
+        if (from.empty()) continue;
+        size_t index = pick(from.size());
+        string nick = from[index];
+        from[index] = from.back();
+        from.pop_back();
+        to.push_back(nick);
+        if (rejoin) {
+            send(session, ":" + nick + "!load@" + serverName + " JOIN :" + channel.name);
+            ++statistics.joins;
+        } else {
+            send(session, ":" + nick + "!load@" + serverName + " PART " + channel.name + " :churn");
+            ++statistics.parts;
+        }
+    }
+
+    if (settings.netsplitInterval.count() > 0 && now >= session.nextNetsplit
+        && session.rejoin == chrono::steady_clock::time_point::max()) {
+        for (auto& channel : session.channels) {
+            size_t count = static_cast<size_t>(channel.present.size() * settings.netsplitFraction);
+            shuffle(channel.present.begin(), channel.present.end(), random);
+            channel.split.assign(channel.present.end() - count, channel.present.end());
+            channel.present.resize(channel.present.size() - count);
+            for (auto& nick : channel.split)
+                send(session, ":" + nick + "!load@" + serverName + " QUIT :" + serverName + " split.invalid");
+        }
+        session.rejoin = now + settings.netsplitDuration;
+        session.nextNetsplit = now + settings.netsplitInterval;
+        ++statistics.netsplits;
+    } else if (now >= session.rejoin) {
+        for (auto& channel : session.channels) {
+            for (auto& nick : channel.split) {
+                send(session, ":" + nick + "!load@" + serverName + " JOIN :" + channel.name);
+                channel.present.push_back(nick);
+                ++statistics.joins;
+            }
+            channel.split.clear();
+        }
+        session.rejoin = chrono::steady_clock::time_point::max();
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef MOCKIRCD_H
+#define MOCKIRCD_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/// Local irc server for load tests, every connection gets its own simulated network.
+/// Channels joined by a client are filled with simulated users which talk, part and rejoin
+/// and are split off the network from time to time. Messages carry their send time as
+/// "load <sequence> <steady clock nanoseconds>" so clients in the same process can measure latencies.
+class MockIrcd {
+public:
+    /// Read from the category "ircd" of the load test scenario
+    struct Settings {
+        Settings();
+        uint16_t port;
+        /// Simulated users in every joined channel
+        size_t usersPerChannel;
+        /// Messages per second and connection, spread over the joined channels
+        double messagesPerSecond;
+        /// Parts and rejoins per second and connection
+        double churnPerSecond;
+        /// Time between netsplits, zero disables them
+        std::chrono::milliseconds netsplitInterval;
+        /// Part of the simulated users lost in a netsplit
+        double netsplitFraction;
+        /// Time until the split users rejoin
+        std::chrono::milliseconds netsplitDuration;
+    };
+
+    /// Counters of all connections, read after stop
+    struct Statistics {
+        Statistics();
+        std::atomic<size_t> connections;
+        std::atomic<size_t> messages;
+        std::atomic<size_t> joins;
+        std::atomic<size_t> parts;
+        std::atomic<size_t> netsplits;
+        std::atomic<size_t> received;
+    };
+
+private:
+    struct Channel {
+        std::string name;
+        std::vector<std::string> present;
+        std::vector<std::string> absent;
+        /// Users which left with the last netsplit
+        std::vector<std::string> split;
+    };
+    struct Session {
+        int fd;
+        std::string nick;
+        bool registered;
+        std::string input;
+        std::string output;
+        std::vector<Channel> channels;
+        double messageBudget;
+        double churnBudget;
+        std::chrono::steady_clock::time_point nextNetsplit;
+        std::chrono::steady_clock::time_point rejoin;
+    };
+
+    Settings settings;
+    Statistics statistics;
+    int listenFd;
+    std::atomic<bool> running;
+    std::thread thread;
+    std::vector<Session> sessions;
+    std::mt19937 random;
+    uint64_t sequence;
+
+    void run();
+    void accept();
+    /// Reads and answers the commands of a client, returns false if the connection was closed
+    bool read(Session& session);
+    /// Returns false if the connection was closed
+    bool write(Session& session);
+    void handleLine(Session& session, const std::string& line);
+    void join(Session& session, const std::string& channels);
+    /// Generates the messages, churn and netsplits since the last tick
+    void simulate(Session& session, std::chrono::steady_clock::time_point now, double seconds);
+    static void send(Session& session, const std::string& line);
+public:
+    explicit MockIrcd(const Settings& settings);
+    ~MockIrcd();
+
+    /// Binds the port and starts the server thread
+    ///
+    /// \returns False if the port couldn't be bound
+    bool start();
+    void stop();
+    const Statistics& getStatistics() const;
+};
+
+#endif
@@ -0,0 +1,319 @@
+#include "WebsocketSwarm.hpp"
+#include "utils/Base64.hpp"
+#include <cerrno>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <json/json.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+/// Upper bound of a handshake response
+static const size_t maxHandshakeSize = 8192;
+
+WebsocketSwarm::Settings::Settings()
+    : host{"127.0.0.1"}
+    , port{8080}
+    , userPrefix{"load"}
+    , password{"load"}
+    , clients{10}
+{
+}
+
+WebsocketSwarm::WebsocketSwarm(const Settings& settings)
+    : settings{settings}
+    , running{false}
+    , measuring{false}
+{
+    report.connected = 0;
+    report.loggedIn = 0;
+    report.messages = 0;
+    report.bytes = 0;
+    report.duration = chrono::steady_clock::duration::zero();
+}
+
+WebsocketSwarm::~WebsocketSwarm() {
+    stop();
+}
+
+int WebsocketSwarm::connect(std::string& rest) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(settings.port);
+    if (inet_pton(AF_INET, settings.host.c_str(), &address.sin_addr) != 1
+        || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    timeval timeout{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    static thread_local mt19937 random{random_device{}()};
+    string key(16, '\0');
+    for (auto& c : key)
+        c = static_cast<char>(random());
+    ostringstream request;
+    request << "GET /ws HTTP/1.1\r\n"
+            << "Host: " << settings.host << ":" << settings.port << "\r\n"
+            << "Upgrade: websocket\r\n"
+            << "Connection: Upgrade\r\n"
+            << "Sec-WebSocket-Key: " << Base64::encode(key) << "\r\n"
+            << "Sec-WebSocket-Version: 13\r\n\r\n";
+    string data = request.str();
+    if (send(fd, data.data(), data.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(data.size())) {
+        close(fd);
+        return -1;
+    }
+
+    // read until the end of the response header
+    string response;
+    size_t headerEnd;
+    char buffer[1024];
+    while ((headerEnd = response.find("\r\n\r\n")) == string::npos) {
+        ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+        if (length <= 0 || response.size() > maxHandshakeSize) {
+            close(fd);
+            return -1;
+        }
+        response.append(buffer, length);
+    }
+    if (response.compare(0, 12, "HTTP/1.1 101") != 0) {
+        close(fd);
+        return -1;
+    }
+    rest = response.substr(headerEnd + 4);
+    return fd;
+}
+
+bool WebsocketSwarm::sendFrame(int fd, uint8_t opcode, const std::string& payload) {
+    static thread_local mt19937 random{random_device{}()};
+    string frame;
+    frame += static_cast<char>(0x80 | opcode);
+    if (payload.size() < 126) {
+        frame += static_cast<char>(0x80 | payload.size());
+    } else if (payload.size() <= 0xffff) {
+        frame += static_cast<char>(0x80 | 126);
+        frame += static_cast<char>(payload.size() >> 8);
+        frame += static_cast<char>(payload.size() & 0xff);
+    } else {
+        frame += static_cast<char>(0x80 | 127);
+        for (int shift = 56; shift >= 0; shift -= 8)
+            frame += static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xff);
+    }
+    // clients have to mask their frames
+    char mask[4];
+    for (auto& c : mask)
+        c = static_cast<char>(random());
+    frame.append(mask, 4);
+    for (size_t i = 0; i < payload.size(); ++i)
+        frame += static_cast<char>(payload[i] ^ mask[i % 4]);
+
+    size_t sent = 0;
+    while (sent < frame.size()) {
+        ssize_t length = send(fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+        if (length < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+            pollfd pfd{fd, POLLOUT, 0};
+            poll(&pfd, 1, 100);
+            continue;
+        }
+        sent += length;
+    }
+    return true;
+}
+
+size_t WebsocketSwarm::start() {
+    for (size_t i = 1; i <= settings.clients; ++i) {
+        Client client;
+        client.fd = connect(client.input);
+        client.loggedIn = false;
+        if (client.fd < 0) continue;
+        if (!sendFrame(client.fd, 1, "LOGIN " + settings.userPrefix + to_string(i) + " " + settings.password)) {
+            close(client.fd);
+            continue;
+        }
+        fcntl(client.fd, F_SETFL, fcntl(client.fd, F_GETFL) | O_NONBLOCK);
+        clients.push_back(std::move(client));
+    }
+    {
+        lock_guard<mutex> lock(reportMutex);
+        report.connected = clients.size();
+    }
+
+    running = true;
+    thread = std::thread([this]{ run(); });
+    return clients.size();
+}
+
+size_t WebsocketSwarm::waitForLogins(std::chrono::milliseconds timeout) {
+    auto deadline = chrono::steady_clock::now() + timeout;
+    for (;;) {
+        {
+            lock_guard<mutex> lock(reportMutex);
+            if (report.loggedIn >= report.connected || chrono::steady_clock::now() >= deadline)
+                return report.loggedIn;
+        }
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+}
+
+void WebsocketSwarm::beginMeasurement() {
+    lock_guard<mutex> lock(reportMutex);
+    report.messages = 0;
+    report.bytes = 0;
+    report.latency.reset();
+    measureStart = chrono::steady_clock::now();
+    measuring = true;
+}
+
+WebsocketSwarm::Report WebsocketSwarm::endMeasurement() {
+    lock_guard<mutex> lock(reportMutex);
+    measuring = false;
+    report.duration = chrono::steady_clock::now() - measureStart;
+    return report;
+}
+
+void WebsocketSwarm::stop() {
+    if (!running) return;
+    running = false;
+    thread.join();
+    for (auto& client : clients) {
+        if (client.fd >= 0)
+            close(client.fd);
+    }
+    clients.clear();
+}
+
+void WebsocketSwarm::run() {
+    // data received with the handshake responses
+    for (auto& client : clients) {
+        if (!parseFrames(client)) {
+            close(client.fd);
+            client.fd = -1;
+        }
+    }
+
+    vector<pollfd> fds(clients.size());
+    while (running) {
+        for (size_t i = 0; i < clients.size(); ++i)
+            fds[i] = pollfd{clients[i].fd, POLLIN, 0};
+        if (poll(fds.data(), fds.size(), 50) <= 0) continue;
+
+        for (size_t i = 0; i < clients.size(); ++i) {
+            auto& client = clients[i];
+            if (client.fd < 0 || !(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            if (!read(client) || !parseFrames(client)) {
+                close(client.fd);
+                client.fd = -1;
+            }
+        }
+    }
+}
+
+bool WebsocketSwarm::read(Client& client) {
+    char buffer[16384];
+    for (;;) {
+        ssize_t length = recv(client.fd, buffer, sizeof(buffer), 0);
+        if (length == 0) return false;
+        if (length < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        client.input.append(buffer, length);
+    }
+}
+
+bool WebsocketSwarm::parseFrames(Client& client) {
+    auto& input = client.input;
+    size_t position = 0;
+    while (input.size() - position >= 2) {
+        auto byte = [&input, position](size_t offset) {
+            return static_cast<uint8_t>(input[position + offset]);
+        };
+        bool final = byte(0) & 0x80;
+        uint8_t opcode = byte(0) & 0x0f;
+        bool masked = byte(1) & 0x80;
+        uint64_t length = byte(1) & 0x7f;
+        size_t header = 2;
+        if (length == 126) {
+            if (input.size() - position < 4) break;
+            length = (uint64_t(byte(2)) << 8) | byte(3);
+            header = 4;
+        } else if (length == 127) {
+            if (input.size() - position < 10) break;
+            length = 0;
+            for (size_t i = 0; i < 8; ++i)
+                length = (length << 8) | byte(2 + i);
+            header = 10;
+        }
+        size_t maskOffset = header;
+        if (masked)
+            header += 4;
+        if (input.size() - position < header + length) break;
+
+        string payload = input.substr(position + header, length);
+        if (masked) {
+            for (size_t i = 0; i < payload.size(); ++i)
+                payload[i] ^= input[position + maskOffset + i % 4];
+        }
+        position += header + length;
+
+        if (opcode == 8) { // close
+            return false;
+        } else if (opcode == 9) { // ping
+            if (!sendFrame(client.fd, 10, payload)) return false;
+        } else if (opcode <= 2) { // continuation, text or binary
+            client.fragments += payload;
+            if (final) {
+                onMessage(client, client.fragments);
+                client.fragments.clear();
+            }
+        }
+    }
+    input.erase(0, position);
+    return true;
+}
+
+void WebsocketSwarm::onMessage(Client& client, const std::string& message) {
+    auto received = chrono::steady_clock::now();
+    Json::Value root;
+    Json::Reader reader;
+    if (!reader.parse(message, root) || !root.isObject()) return;
+
+    string cmd = root.get("cmd", "").asString();
+    lock_guard<mutex> lock(reportMutex);
+    if (!client.loggedIn) {
+        if (cmd == "login" && root.get("success", false).asBool()) {
+            client.loggedIn = true;
+            ++report.loggedIn;
+        }
+        return;
+    }
+    if (!measuring) return;
+
+    report.messages += 1;
+    report.bytes += message.size();
+    if (cmd != "chat") return;
+    string text = root.get("msg", "").asString();
+    if (text.compare(0, 5, "load ") != 0) return;
+
+    // "load <sequence> <steady clock nanoseconds>"
+    uint64_t sequence, sent;
+    if (!(istringstream(text.substr(5)) >> sequence >> sent)) return;
+    auto now = chrono::duration_cast<chrono::nanoseconds>(received.time_since_epoch()).count();
+    if (static_cast<uint64_t>(now) >= sent)
+        report.latency.record((now - sent) / 1000);
+}
@@ -0,0 +1,89 @@
+#ifndef WEBSOCKETSWARM_H
+#define WEBSOCKETSWARM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils/HdrHistogram.hpp"
+
+
+/// Websocket clients logging into harpoon as many users at once.
+/// Chat messages sent by MockIrcd carry their send time, the swarm records the delivery
+/// latency of every such message received by any client.
+class WebsocketSwarm {
+public:
+    /// Read from the category "swarm" of the load test scenario
+    struct Settings {
+        Settings();
+        std::string host;
+        uint16_t port;
+        /// Clients connect as <userPrefix><n> for n in [1, clients]
+        std::string userPrefix;
+        std::string password;
+        size_t clients;
+    };
+
+    /// Results of a measurement
+    struct Report {
+        size_t connected;
+        size_t loggedIn;
+        size_t messages;
+        size_t bytes;
+        std::chrono::steady_clock::duration duration;
+        /// Delivery latencies in microseconds
+        HdrHistogram latency;
+    };
+
+private:
+    struct Client {
+        int fd;
+        bool loggedIn;
+        std::string input;
+        /// Payload of a fragmented message
+        std::string fragments;
+    };
+
+    Settings settings;
+    std::vector<Client> clients;
+    std::atomic<bool> running;
+    std::thread thread;
+
+    std::mutex reportMutex;
+    Report report;
+    std::chrono::steady_clock::time_point measureStart;
+    std::atomic<bool> measuring;
+
+    /// Connects and upgrades to a websocket, returns -1 on failure
+    ///
+    /// \param rest Receives data which was read after the handshake response
+    int connect(std::string& rest);
+    /// Sends a masked frame, 1 for text and 10 for pongs
+    static bool sendFrame(int fd, uint8_t opcode, const std::string& payload);
+    /// Reads the available data of a client, returns false if the connection was closed
+    bool read(Client& client);
+    /// Parses complete frames of the input buffer, returns false on close frames
+    bool parseFrames(Client& client);
+    void onMessage(Client& client, const std::string& message);
+    void run();
+public:
+    explicit WebsocketSwarm(const Settings& settings);
+    ~WebsocketSwarm();
+
+    /// Connects and logs in all clients, then starts receiving
+    ///
+    /// \returns Amount of connected clients
+    size_t start();
+    /// Waits until all connected clients received their login result or the timeout expired
+    size_t waitForLogins(std::chrono::milliseconds timeout);
+    /// Resets the counters and starts a measurement
+    void beginMeasurement();
+    /// Ends the measurement and returns its results
+    Report endMeasurement();
+    void stop();
+};
+
+#endif
@@ -1,13 +1,16 @@
-#include <iostream>
 #include "UserManager.hpp"
 #include "event/IUserEvent.hpp"
 #include "event/EventQuit.hpp"
 #include "event/EventLoginResult.hpp"
 #include "event/IActivateServiceEvent.hpp"
+#include "utils/Logger.hpp"
 
 using namespace std;
 
 
+static LogModule& logModule = Logger::getInstance().getModule("user_manager");
+
+
 UserManager::UserManager(EventQueue* appQueue)
     : EventLoop({
         EventQuit::uuid,
@@ -32,8 +35,7 @@ bool UserManager::onEvent(std::shared_ptr<IEvent> event) {
 
 		auto activateEvent = event->as<IActivateServiceEvent>();
 		if (activateEvent) {
-			std::cout << "UM received Activate event" << std::endl;
-			cout << "[UM] Activate user: " << activateEvent->getUserId() << endl;
+			LOG_DEBUG(logModule) << "activating user" << logField("user", activateEvent->getUserId());
 			std::map<size_t, std::shared_ptr<EventLoop>>* serviceMap;
 			auto serviceMapIt = users.find(userId);
 			if (serviceMapIt == users.end()) {
@@ -50,7 +52,7 @@ bool UserManager::onEvent(std::shared_ptr<IEvent> event) {
 				serviceInstanceIt.first->second->getEventQueue()->sendEvent(event);
 			}
 		} else if (eventType == EventLoginResult::uuid) {
-			std::cout << "UM received User login result event" << std::endl;
+			LOG_DEBUG(logModule) << "received login result" << logField("user", userId);
 			auto loginResult = event->as<EventLoginResult>();
 			if (loginResult->getSuccess()) {
 				auto it = users.find(userId);
@@ -75,7 +77,7 @@ bool UserManager::onEvent(std::shared_ptr<IEvent> event) {
 	}
 
 	if (eventType == EventQuit::uuid) {
-		cout << "[UM] received QUIT event" << endl;
+		LOG_DEBUG(logModule) << "received quit";
 		return false;
 	}
 
@@ -1,78 +1,45 @@
 #include "Base64.hpp"
-#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE64_X86
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
 
 static const string base64chars("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789*/=");
 
-std::string Base64::decode(const std::string& source) {
-    if (source.size() == 0 || source.size() % 4 != 0) return ""; // validate length
-
-    vector<uint8_t> outData(decodedLength(source), 0);
+static const uint8_t invalidChar = 0xff;
+static const uint8_t paddingChar = 64;
 
-    const uint8_t* in_iterator = reinterpret_cast<const uint8_t*>(source.data());
-    uint8_t* out_iterator = outData.data();
-    size_t position = 0;
-    size_t outPosition = 0;
+/// Symbol value of each character, 64 for '=' and 0xff for invalid characters
+static const uint8_t base64values[256] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  62, 255, 255, 255, 255,  63,
+     52,  53,  54,  55,  56,  57,  58,  59,  60,  61, 255, 255, 255,  64, 255, 255,
+    255,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+     15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25, 255, 255, 255, 255, 255,
+    255,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+     41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+};
 
-    while (position < source.size()) {
-        int len = 4;
-        // validate bytes
-        for (int i = 0; i < 4; ++i) {
-            uint8_t c = in_iterator[i];
-            if (!( // if invalid character stop and return empty string
-                (c >= 'A' && c <= 'Z')
-             || (c >= 'a' && c <= 'z')
-             || (c >= '0' && c <= '9')
-             || (c == '*' || c == '/')
-             || (i >= 2 && c == '='))) {
-                return "";
-            }
-            if (c == '=') len -= 1;
-        }
-
-        // slow, but fast is not required (yet)
-        size_t c1 = base64chars.find(in_iterator[0]);
-        size_t c2 = base64chars.find(in_iterator[1]);
-        size_t c3 = base64chars.find(in_iterator[2]);
-        size_t c4 = base64chars.find(in_iterator[3]);
-
-        if (outPosition < outData.size()) out_iterator[0] = len >= 2 ? ((c1 << 2) & 0xfc) + ((c2 >> 4) & 0x3) : (c1 << 2) & 0xfc;
-        if (outPosition+1 < outData.size()) out_iterator[1] = len >= 3 ? ((c2 << 4) & 0xf0) + ((c3 >> 2) & 0xf) : (c2 << 4) & 0xf0;
-        if (outPosition+2 < outData.size()) out_iterator[2] = len == 4 ? ((c3 << 6) & 0xc0) + (c4 & 0x3f) : (c3 << 6) & 0xc0;
-
-        outPosition += 3;
-        position += 4;
-        in_iterator += 4;
-        out_iterator += 3;
-    }
-
-    return string(reinterpret_cast<char*>(outData.data()), outData.size());
-}
-
-size_t Base64::decodedLength(const std::string& source) {
-    if (source.size() == 0 || source.size() % 4 != 0) return 0;
-    size_t length = (source.size()+3) / 4 * 3;
-    if (source.at(source.size()-1) == '=')
-        length -= 1;
-    else if (source.at(source.size()-2) == '=')
-        length -= 2;
-    return length;
-}
-
-std::string Base64::encode(const std::string& source) {
-    vector<uint8_t> outData(encodedLength(source.size()), 0);
-    int rest;
-    int parts;
-    const uint8_t* in_iterator;
-    uint8_t* out_iterator;
+/// Encodes the input completely, including the padded rest
+static void encodeScalar(const uint8_t* in_iterator, size_t length, uint8_t* out_iterator) {
+    size_t parts = length / 3;
+    size_t rest = length % 3;
 
-    parts = source.size() / 3;
-    rest = source.size() % 3;
-
-    in_iterator = reinterpret_cast<const uint8_t*>(source.data());
-    out_iterator = outData.data();
     for(; parts > 0; --parts) {
         out_iterator[0] = base64chars[in_iterator[0] >> 2 & 0x3f];
         out_iterator[1] = base64chars[(in_iterator[0] << 4 & 0x30) + (in_iterator[1] >> 4 & 0xf)];
@@ -101,9 +68,280 @@ std::string Base64::encode(const std::string& source) {
         out_iterator[2] = base64chars[c];
         out_iterator[3] = '=';
     }
-    return string(reinterpret_cast<char*>(outData.data()), outData.size());
+}
+
+/// Decodes all quads of the input, returns false on an invalid character
+static bool decodeScalar(const uint8_t* in_iterator, size_t length, uint8_t* out_iterator, size_t outLength) {
+    size_t outPosition = 0;
+
+    for (size_t position = 0; position < length; position += 4) {
+        int len = 4;
+        uint8_t c[4];
+        for (int i = 0; i < 4; ++i) {
+            c[i] = base64values[in_iterator[i]];
+            // padding is only valid in the last two characters
+            if (c[i] == invalidChar || (i < 2 && c[i] == paddingChar))
+                return false;
+            if (c[i] == paddingChar) len -= 1;
+        }
+
+        if (outPosition < outLength) out_iterator[0] = len >= 2 ? ((c[0] << 2) & 0xfc) + ((c[1] >> 4) & 0x3) : (c[0] << 2) & 0xfc;
+        if (outPosition+1 < outLength) out_iterator[1] = len >= 3 ? ((c[1] << 4) & 0xf0) + ((c[2] >> 2) & 0xf) : (c[1] << 4) & 0xf0;
+        if (outPosition+2 < outLength) out_iterator[2] = len == 4 ? ((c[2] << 6) & 0xc0) + (c[3] & 0x3f) : (c[2] << 6) & 0xc0;
+
+        outPosition += 3;
+        in_iterator += 4;
+        out_iterator += 3;
+    }
+    return true;
+}
+
+
+/// Block kernels process whole blocks from the start and return the amount of input consumed,
+/// the scalar code continues from there
+typedef size_t (*BlockKernel)(const uint8_t* in, size_t length, uint8_t* out);
+
+static size_t noBlocks(const uint8_t*, size_t, uint8_t*) {
+    return 0;
+}
+
+#ifdef BASE64_X86
+// Bit shuffling as described by Wojciech Muła and Daniel Lemire,
+// "Faster Base64 Encoding and Decoding Using AVX2 Instructions".
+
+/// Maps 16 six bit values to their characters
+__attribute__((target("sse4.1")))
+static inline __m128i lookupSse41(__m128i indices) {
+    // 0..51 map to 0, 52..63 to 1..12, then 0..25 to 13
+    __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+    const __m128i shifts = _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '*' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(_mm_shuffle_epi8(shifts, result), indices);
+}
+
+/// Maps 16 characters to their six bit values, false if any of them is invalid or padding
+__attribute__((target("sse4.1")))
+static inline bool translateSse41(__m128i chars, __m128i& values) {
+    // signed compares, characters above 127 fail every range
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('A' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), chars));
+    __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('a' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), chars));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chars));
+    __m128i star = _mm_cmpeq_epi8(chars, _mm_set1_epi8('*'));
+    __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+
+    __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, star), slash));
+    if (_mm_movemask_epi8(valid) != 0xffff)
+        return false;
+
+    __m128i shift = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')), _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+        _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+            _mm_or_si128(_mm_and_si128(star, _mm_set1_epi8(62 - '*')), _mm_and_si128(slash, _mm_set1_epi8(63 - '/')))));
+    values = _mm_add_epi8(chars, shift);
+    return true;
+}
+
+/// Reads 16 bytes and encodes the first 12 of them into 16 characters each round
+__attribute__((target("sse4.1")))
+static size_t encodeSse41(const uint8_t* in, size_t length, uint8_t* out) {
+    size_t position = 0;
+    for (; position + 16 <= length; position += 12, out += 16) {
+        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + position));
+        data = _mm_shuffle_epi8(data, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+        __m128i high = _mm_mulhi_epu16(_mm_and_si128(data, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+        __m128i low = _mm_mullo_epi16(_mm_and_si128(data, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), lookupSse41(_mm_or_si128(high, low)));
+    }
+    return position;
+}
+
+/// Decodes 16 characters into 12 bytes each round, stops before blocks with padding or invalid characters
+__attribute__((target("sse4.1")))
+static size_t decodeSse41(const uint8_t* in, size_t length, uint8_t* out) {
+    size_t position = 0;
+    for (; position + 16 <= length; position += 16, out += 12) {
+        __m128i values;
+        if (!translateSse41(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + position)), values))
+            break;
+        __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        merged = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), merged);
+        uint32_t rest = _mm_extract_epi32(merged, 2);
+        memcpy(out + 8, &rest, sizeof(rest));
+    }
+    return position;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i lookupAvx2(__m256i indices) {
+    __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+    const __m256i shifts = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '*' - 62, '/' - 63, 'A', 0, 0));
+    return _mm256_add_epi8(_mm256_shuffle_epi8(shifts, result), indices);
+}
+
+__attribute__((target("avx2")))
+static inline bool translateAvx2(__m256i chars, __m256i& values) {
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), chars));
+    __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), chars));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+    __m256i star = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('*'));
+    __m256i slash = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/'));
+
+    __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(_mm256_or_si256(digit, star), slash));
+    if (_mm256_movemask_epi8(valid) != -1)
+        return false;
+
+    __m256i shift = _mm256_or_si256(
+        _mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')), _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+        _mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+            _mm256_or_si256(_mm256_and_si256(star, _mm256_set1_epi8(62 - '*')), _mm256_and_si256(slash, _mm256_set1_epi8(63 - '/')))));
+    values = _mm256_add_epi8(chars, shift);
+    return true;
+}
+
+/// Encodes 24 bytes into 32 characters each round, the lanes read 16 bytes at offset 0 and 12.
+/// The rest goes through the SSE4.1 kernel.
+__attribute__((target("avx2")))
+static size_t encodeAvx2(const uint8_t* in, size_t length, uint8_t* out) {
+    size_t position = 0;
+    for (; position + 28 <= length; position += 24, out += 32) {
+        __m256i data = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + position))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + position + 12)), 1);
+        data = _mm256_shuffle_epi8(data, _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10)));
+        __m256i high = _mm256_mulhi_epu16(_mm256_and_si256(data, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+        __m256i low = _mm256_mullo_epi16(_mm256_and_si256(data, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), lookupAvx2(_mm256_or_si256(high, low)));
+    }
+    // the SSE code would stall on the dirty upper halves otherwise
+    _mm256_zeroupper();
+    return position + encodeSse41(in + position, length - position, out);
+}
+
+/// Decodes 32 characters into 24 bytes each round, the rest goes through the SSE4.1 kernel
+__attribute__((target("avx2")))
+static size_t decodeAvx2(const uint8_t* in, size_t length, uint8_t* out) {
+    size_t position = 0;
+    for (; position + 32 <= length; position += 32, out += 24) {
+        __m256i values;
+        if (!translateAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + position)), values))
+            break;
+        __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        merged = _mm256_shuffle_epi8(merged, _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)));
+        // move the 12 bytes of both lanes together
+        merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(merged));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 16), _mm256_extracti128_si256(merged, 1));
+    }
+    // the SSE code would stall on the dirty upper halves otherwise
+    _mm256_zeroupper();
+    return position + decodeSse41(in + position, length - position, out);
+}
+#endif
+
+static Base64::Kernel detectKernel() {
+#ifdef BASE64_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Base64::Kernel::Avx2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return Base64::Kernel::Sse41;
+#endif
+    return Base64::Kernel::Scalar;
+}
+
+/// Checked once at startup
+static const Base64::Kernel defaultKernel = detectKernel();
+
+static BlockKernel encodeKernel(Base64::Kernel kernel) {
+    switch (kernel) {
+#ifdef BASE64_X86
+    case Base64::Kernel::Avx2: return encodeAvx2;
+    case Base64::Kernel::Sse41: return encodeSse41;
+#endif
+    default: return noBlocks;
+    }
+}
+
+static BlockKernel decodeKernel(Base64::Kernel kernel) {
+    switch (kernel) {
+#ifdef BASE64_X86
+    case Base64::Kernel::Avx2: return decodeAvx2;
+    case Base64::Kernel::Sse41: return decodeSse41;
+#endif
+    default: return noBlocks;
+    }
+}
+
+
+std::string Base64::decode(const std::string& source) {
+    return decode(source, defaultKernel);
+}
+
+std::string Base64::decode(const std::string& source, Kernel kernel) {
+    if (source.size() == 0 || source.size() % 4 != 0) return ""; // validate length
+
+    string result(decodedLength(source), '\0');
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(source.data());
+    uint8_t* out = reinterpret_cast<uint8_t*>(&result[0]);
+
+    // the blocks never contain padding, so their output fits completely
+    size_t done = decodeKernel(kernel)(in, source.size(), out);
+    size_t outDone = done / 4 * 3;
+    if (!decodeScalar(in + done, source.size() - done, out + outDone, result.size() - outDone))
+        return ""; // invalid character
+    return result;
+}
+
+size_t Base64::decodedLength(const std::string& source) {
+    if (source.size() == 0 || source.size() % 4 != 0) return 0;
+    size_t length = (source.size()+3) / 4 * 3;
+    if (source.at(source.size()-2) == '=')
+        length -= 2;
+    else if (source.at(source.size()-1) == '=')
+        length -= 1;
+    return length;
+}
+
+std::string Base64::encode(const std::string& source) {
+    return encode(source, defaultKernel);
+}
+
+std::string Base64::encode(const std::string& source, Kernel kernel) {
+    string result(encodedLength(source.size()), '\0');
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(source.data());
+    uint8_t* out = reinterpret_cast<uint8_t*>(&result[0]);
+
+    size_t done = encodeKernel(kernel)(in, source.size(), out);
+    encodeScalar(in + done, source.size() - done, out + done / 3 * 4);
+    return result;
 }
 
 size_t Base64::encodedLength(size_t length) {
     return (length+2) / 3 * 4;
 }
+
+bool Base64::isSupported(Kernel kernel) {
+    switch (kernel) {
+    case Kernel::Scalar: return true;
+#ifdef BASE64_X86
+    case Kernel::Sse41: return __builtin_cpu_supports("sse4.1");
+    case Kernel::Avx2: return __builtin_cpu_supports("avx2");
+#endif
+    default: return false;
+    }
+}
+
+Base64::Kernel Base64::getKernel() {
+    return defaultKernel;
+}
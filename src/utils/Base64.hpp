@@ -4,16 +4,33 @@
 #include <string>
 
 
+/// Base64 with the alphabet A-Z, a-z, 0-9, '*' and '/', padded with '='
 class Base64 {
 public:
+    /// Implementations of the codec, the best supported one is picked at startup
+    enum class Kernel {
+        Scalar,
+        Sse41,
+        Avx2
+    };
+
     /// Encode the string as base64
     static std::string encode(const std::string& source);
+    /// Encode the string using the given kernel, which has to be supported
+    static std::string encode(const std::string& source, Kernel kernel);
     /// Returns the length required for the encoded string
     static size_t encodedLength(size_t length);
     /// Decodes a base64 string and returns the result
     static std::string decode(const std::string& source);
+    /// Decodes the string using the given kernel, which has to be supported
+    static std::string decode(const std::string& source, Kernel kernel);
     /// Returns the length required for the decoded string
     static size_t decodedLength(const std::string& source);
+
+    /// True if the cpu and the build support the kernel
+    static bool isSupported(Kernel kernel);
+    /// Returns the kernel used by encode and decode
+    static Kernel getKernel();
 };
 
 #endif
@@ -1,5 +1,6 @@
 #include "Crypto.hpp"
 #include "Base64.hpp"
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -7,14 +8,18 @@
 #include <openssl/err.h>
 #include <openssl/rand.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include <openssl/crypto.h>
 
 using namespace std;
 
 
+/// Instances are created by the login workers concurrently
+static mutex cryptoMutex;
 static int cryptoCount = 0;
 
 Crypto::Crypto() {
+    lock_guard<mutex> lock(cryptoMutex);
     if (cryptoCount < 1) {
         // Initialize
         ERR_load_crypto_strings();
@@ -25,6 +30,7 @@ Crypto::Crypto() {
 }
 
 Crypto::~Crypto() {
+    lock_guard<mutex> lock(cryptoMutex);
     --cryptoCount;
     if (cryptoCount < 1) {
         // Clean up
@@ -59,3 +65,17 @@ std::string Crypto::hashPassword(const std::string& salt, const std::string& pas
     vector<char> encodedLength(b.encodedLength(keyLength), 0);
     return b.encode(key);
 }
+
+std::string Crypto::sign(const std::string& key, const std::string& data) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    if (!HMAC(EVP_sha256(), key.data(), key.size(),
+              reinterpret_cast<const unsigned char*>(data.data()), data.size(),
+              digest, &length))
+        throw runtime_error("Can not sign data.");
+    return string(reinterpret_cast<char*>(digest), length);
+}
+
+bool Crypto::equals(const std::string& left, const std::string& right) {
+    return left.size() == right.size() && CRYPTO_memcmp(left.data(), right.data(), left.size()) == 0;
+}
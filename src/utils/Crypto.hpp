@@ -15,6 +15,10 @@ public:
     std::string generateKey(const std::string& salt, const std::string& password, size_t keyLength = 64);
     /// Returns a base64 encoded key
     std::string hashPassword(const std::string& salt, const std::string& password, size_t keyLength = 64);
+    /// Returns the HMAC-SHA256 of the data
+    std::string sign(const std::string& key, const std::string& data);
+    /// Compares in constant time, for signatures received from clients
+    static bool equals(const std::string& left, const std::string& right);
 };
 
 #endif
@@ -0,0 +1,94 @@
+#include "HdrHistogram.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+
+const unsigned HdrHistogram::subBucketBits;
+const uint64_t HdrHistogram::subBucketCount;
+const uint64_t HdrHistogram::subBucketHalf;
+
+HdrHistogram::HdrHistogram(uint64_t highestValue)
+    : highestValue{max<uint64_t>(highestValue, subBucketCount)}
+    , counts(getIndex(this->highestValue) + 1)
+    , totalCount{0}
+    , minValue{0}
+    , maxValue{0}
+    , sum{0}
+{
+}
+
+size_t HdrHistogram::getIndex(uint64_t value) {
+    if (value < subBucketCount) return static_cast<size_t>(value);
+    // values of the group starting at 2^(shift + subBucketBits - 1) share the same step size 2^shift
+    unsigned shift = 64 - __builtin_clzll(value) - subBucketBits;
+    uint64_t subBucket = value >> shift;
+    return static_cast<size_t>(subBucketCount + (shift - 1) * subBucketHalf + (subBucket - subBucketHalf));
+}
+
+uint64_t HdrHistogram::getValue(size_t index) {
+    if (index < subBucketCount) return index;
+    uint64_t offset = index - subBucketCount;
+    unsigned shift = static_cast<unsigned>(offset / subBucketHalf) + 1;
+    uint64_t subBucket = offset % subBucketHalf + subBucketHalf;
+    return (subBucket << shift) + (uint64_t(1) << shift) - 1;
+}
+
+void HdrHistogram::record(uint64_t value) {
+    value = min(value, highestValue);
+    counts[getIndex(value)] += 1;
+    minValue = totalCount == 0 ? value : min(minValue, value);
+    maxValue = max(maxValue, value);
+    totalCount += 1;
+    sum += static_cast<double>(value);
+}
+
+void HdrHistogram::add(const HdrHistogram& other) {
+    if (other.totalCount == 0) return;
+    size_t size = min(counts.size(), other.counts.size());
+    for (size_t i = 0; i < size; ++i)
+        counts[i] += other.counts[i];
+    minValue = totalCount == 0 ? other.minValue : min(minValue, other.minValue);
+    maxValue = max(maxValue, other.maxValue);
+    totalCount += other.totalCount;
+    sum += other.sum;
+}
+
+void HdrHistogram::reset() {
+    fill(counts.begin(), counts.end(), 0);
+    totalCount = 0;
+    minValue = 0;
+    maxValue = 0;
+    sum = 0;
+}
+
+uint64_t HdrHistogram::getCount() const {
+    return totalCount;
+}
+
+uint64_t HdrHistogram::getMin() const {
+    return minValue;
+}
+
+uint64_t HdrHistogram::getMax() const {
+    return maxValue;
+}
+
+double HdrHistogram::getMean() const {
+    return totalCount == 0 ? 0 : sum / totalCount;
+}
+
+uint64_t HdrHistogram::getValueAtPercentile(double percentile) const {
+    if (totalCount == 0) return 0;
+    percentile = max(0.0, min(100.0, percentile));
+    uint64_t target = max<uint64_t>(1, static_cast<uint64_t>(ceil(percentile / 100 * totalCount)));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= target)
+            return min(getValue(i), maxValue);
+    }
+    return maxValue;
+}
@@ -0,0 +1,45 @@
+#ifndef HDRHISTOGRAM_H
+#define HDRHISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/// Histogram of non-negative values with a relative error below 2%, following the HdrHistogram layout.
+/// Values are grouped by their highest bit, each group is split into 64 linear buckets.
+/// Recording is O(1) and doesn't allocate, the histogram is not thread safe.
+class HdrHistogram {
+    static const unsigned subBucketBits = 7;
+    static const uint64_t subBucketCount = uint64_t(1) << subBucketBits;
+    static const uint64_t subBucketHalf = subBucketCount / 2;
+
+    uint64_t highestValue;
+    std::vector<uint64_t> counts;
+    uint64_t totalCount;
+    uint64_t minValue;
+    uint64_t maxValue;
+    /// For the mean, may lose precision on huge counts
+    double sum;
+
+    static size_t getIndex(uint64_t value);
+    /// Highest value which is counted in the bucket
+    static uint64_t getValue(size_t index);
+public:
+    /// \param highestValue Larger values are recorded as this value
+    explicit HdrHistogram(uint64_t highestValue = 3600000000u);
+
+    void record(uint64_t value);
+    /// Adds the counts of a histogram with the same highest value
+    void add(const HdrHistogram& other);
+    void reset();
+
+    uint64_t getCount() const;
+    uint64_t getMin() const;
+    uint64_t getMax() const;
+    double getMean() const;
+    /// Returns the value below which the given percentage of values fall, e.g. 99.9
+    uint64_t getValueAtPercentile(double percentile) const;
+};
+
+#endif
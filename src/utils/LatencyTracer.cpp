@@ -0,0 +1,83 @@
+#include "LatencyTracer.hpp"
+#include <iomanip>
+
+using namespace std;
+
+
+void LatencyTracer::Path::record(std::chrono::steady_clock::duration latency) {
+    auto microseconds = chrono::duration_cast<chrono::microseconds>(latency).count();
+    lock_guard<mutex> lock(pathMutex);
+    histogram.record(microseconds < 0 ? 0 : static_cast<uint64_t>(microseconds));
+}
+
+LatencyTracer::LatencyTracer()
+    : enabled{false}
+    , dumpRequested{false}
+{
+}
+
+LatencyTracer& LatencyTracer::getInstance() {
+    static LatencyTracer tracer;
+    return tracer;
+}
+
+bool LatencyTracer::isEnabled() const {
+    return enabled.load(memory_order_relaxed);
+}
+
+void LatencyTracer::setEnabled(bool lenabled) {
+    enabled = lenabled;
+}
+
+LatencyTracer::Path* LatencyTracer::getPath(const std::string& name) {
+    lock_guard<mutex> lock(pathsMutex);
+    auto& path = paths[name];
+    if (!path)
+        path.reset(new Path);
+    return path.get();
+}
+
+void LatencyTracer::record(const std::string& name, std::chrono::steady_clock::duration latency) {
+    getPath(name)->record(latency);
+}
+
+void LatencyTracer::requestDump() {
+    dumpRequested = true;
+}
+
+bool LatencyTracer::takeDumpRequest() {
+    return dumpRequested.exchange(false);
+}
+
+void LatencyTracer::dump(std::ostream& os) {
+    lock_guard<mutex> lock(pathsMutex);
+    os << "Event latencies in microseconds" << endl;
+    os << left << setw(40) << "path" << right
+       << setw(10) << "count" << setw(10) << "mean"
+       << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99"
+       << setw(10) << "p99.9" << setw(12) << "max" << endl;
+    for (auto& path : paths) {
+        HdrHistogram histogram;
+        {
+            // copied to keep recording threads waiting shortly
+            lock_guard<mutex> pathLock(path.second->pathMutex);
+            histogram = path.second->histogram;
+        }
+        os << left << setw(40) << path.first << right
+           << setw(10) << histogram.getCount()
+           << setw(10) << static_cast<uint64_t>(histogram.getMean())
+           << setw(10) << histogram.getValueAtPercentile(50)
+           << setw(10) << histogram.getValueAtPercentile(90)
+           << setw(10) << histogram.getValueAtPercentile(99)
+           << setw(10) << histogram.getValueAtPercentile(99.9)
+           << setw(12) << histogram.getMax() << endl;
+    }
+}
+
+void LatencyTracer::reset() {
+    lock_guard<mutex> lock(pathsMutex);
+    for (auto& path : paths) {
+        lock_guard<mutex> pathLock(path.second->pathMutex);
+        path.second->histogram.reset();
+    }
+}
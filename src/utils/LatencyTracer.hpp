@@ -0,0 +1,57 @@
+#ifndef LATENCYTRACER_H
+#define LATENCYTRACER_H
+
+#include "utils/HdrHistogram.hpp"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+
+/// Collects latency histograms of event paths like "server/15/wait".
+/// Event loops stamp the queue wait, the handler time and the age of every event,
+/// modules add hops like socket writes or database commits.
+/// Disabled by default, enabled with "enabled=y" in the category "tracing" of config/core.ini.
+class LatencyTracer {
+public:
+    /// Histogram of one path in microseconds
+    class Path {
+        std::mutex pathMutex;
+        HdrHistogram histogram;
+        friend LatencyTracer;
+    public:
+        void record(std::chrono::steady_clock::duration latency);
+    };
+private:
+    std::atomic<bool> enabled;
+    std::atomic<bool> dumpRequested;
+    std::mutex pathsMutex;
+    std::map<std::string, std::unique_ptr<Path>> paths;
+
+    LatencyTracer();
+public:
+    /// Returns the tracer shared by all event loops
+    static LatencyTracer& getInstance();
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    /// Returns the histogram of a path, created on first use and valid until the process ends
+    Path* getPath(const std::string& name);
+    /// Records a latency, looks the path up on every call
+    void record(const std::string& name, std::chrono::steady_clock::duration latency);
+
+    /// Marks a dump as requested, safe to call from a signal handler
+    void requestDump();
+    /// Returns true once after a dump was requested
+    bool takeDumpRequest();
+    /// Writes count, mean and percentiles of every path
+    void dump(std::ostream& os);
+    /// Clears all histograms
+    void reset();
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "Logger.hpp"
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+
+LogModule::LogModule(const std::string& name, LogLevel level)
+    : name{name}
+    , level{static_cast<int>(level)}
+    , overridden{false}
+{
+}
+
+const std::string& LogModule::getName() const {
+    return name;
+}
+
+bool LogModule::isEnabled(LogLevel llevel) const {
+    return static_cast<int>(llevel) >= level.load(memory_order_relaxed);
+}
+
+
+LogRecord::LogRecord(const LogModule& module, LogLevel level)
+    : module(module)
+    , level{level}
+{
+}
+
+LogRecord::~LogRecord() {
+    string text = message.str();
+    text += fields;
+    Logger::getInstance().submit(module, level, move(text));
+}
+
+void LogRecord::appendField(const char* key, const std::string& value) {
+    fields += ' ';
+    fields += key;
+    fields += '=';
+    bool quoted = value.empty() || value.find_first_of(" =\"\\\r\n\t") != string::npos;
+    if (!quoted) {
+        fields += value;
+        return;
+    }
+    fields += '"';
+    for (char c : value) {
+        switch (c) {
+        case '"': fields += "\\\""; break;
+        case '\\': fields += "\\\\"; break;
+        case '\r': fields += "\\r"; break;
+        case '\n': fields += "\\n"; break;
+        case '\t': fields += "\\t"; break;
+        default: fields += c;
+        }
+    }
+    fields += '"';
+}
+
+
+Logger::Buffer::Buffer()
+    : head{0}
+    , tail{0}
+    , dropped{0}
+{
+}
+
+Logger::Logger()
+    : defaultLevel{static_cast<int>(LogLevel::Info)}
+    , stopping{false}
+    , output{&cout}
+{
+    writer = thread([this]{ writeLoop(); });
+}
+
+Logger::~Logger() {
+    {
+        lock_guard<mutex> lock(writerMutex);
+        stopping = true;
+    }
+    writerCondition.notify_one();
+    writer.join();
+}
+
+Logger& Logger::getInstance() {
+    static Logger logger;
+    return logger;
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& level) {
+    if (name == "trace")
+        level = LogLevel::Trace;
+    else if (name == "debug")
+        level = LogLevel::Debug;
+    else if (name == "info")
+        level = LogLevel::Info;
+    else if (name == "warning")
+        level = LogLevel::Warning;
+    else if (name == "error")
+        level = LogLevel::Error;
+    else if (name == "off")
+        level = LogLevel::Off;
+    else
+        return false;
+    return true;
+}
+
+const char* Logger::getLevelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Trace: return "TRACE";
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info: return "INFO";
+    case LogLevel::Warning: return "WARN";
+    case LogLevel::Error: return "ERROR";
+    case LogLevel::Off: break;
+    }
+    return "OFF";
+}
+
+LogModule& Logger::getModule(const std::string& name) {
+    lock_guard<mutex> lock(modulesMutex);
+    auto& module = modules[name];
+    if (!module)
+        module.reset(new LogModule(name, static_cast<LogLevel>(defaultLevel.load())));
+    return *module;
+}
+
+void Logger::setDefaultLevel(LogLevel level) {
+    lock_guard<mutex> lock(modulesMutex);
+    defaultLevel = static_cast<int>(level);
+    for (auto& module : modules) {
+        if (!module.second->overridden)
+            module.second->level = static_cast<int>(level);
+    }
+}
+
+void Logger::setLevel(const std::string& name, LogLevel level) {
+    LogModule& module = getModule(name);
+    lock_guard<mutex> lock(modulesMutex);
+    module.overridden = true;
+    module.level = static_cast<int>(level);
+}
+
+Logger::Buffer& Logger::getBuffer() {
+    // the registry keeps the buffer until the writer drained it after the thread ended
+    static thread_local shared_ptr<Buffer> buffer;
+    if (!buffer) {
+        buffer = make_shared<Buffer>();
+        lock_guard<mutex> lock(buffersMutex);
+        buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void Logger::submit(const LogModule& module, LogLevel level, std::string&& text) {
+    Buffer& buffer = getBuffer();
+    size_t head = buffer.head.load(memory_order_relaxed);
+    if (head - buffer.tail.load(memory_order_acquire) >= bufferCapacity) {
+        buffer.dropped.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    Entry& entry = buffer.entries[head % bufferCapacity];
+    entry.time = chrono::system_clock::now();
+    entry.level = level;
+    entry.module = &module;
+    entry.text = move(text);
+    buffer.head.store(head + 1, memory_order_release);
+    // the writer polls, errors should show up at once
+    if (level >= LogLevel::Error)
+        writerCondition.notify_one();
+}
+
+void Logger::flush() {
+    lock_guard<mutex> lock(writerMutex);
+    drain();
+}
+
+void Logger::setOutput(std::ostream& loutput) {
+    lock_guard<mutex> lock(writerMutex);
+    drain();
+    output = &loutput;
+}
+
+void Logger::writeLoop() {
+    unique_lock<mutex> lock(writerMutex);
+    while (!stopping) {
+        drain();
+        writerCondition.wait_for(lock, chrono::milliseconds(50));
+    }
+    drain();
+}
+
+void Logger::drain() {
+    vector<shared_ptr<Buffer>> lbuffers;
+    {
+        lock_guard<mutex> lock(buffersMutex);
+        lbuffers = buffers;
+    }
+
+    vector<Entry> entries;
+    size_t dropped = 0;
+    for (auto& buffer : lbuffers) {
+        size_t tail = buffer->tail.load(memory_order_relaxed);
+        size_t head = buffer->head.load(memory_order_acquire);
+        for (; tail != head; ++tail)
+            entries.push_back(move(buffer->entries[tail % bufferCapacity]));
+        buffer->tail.store(tail, memory_order_release);
+        dropped += buffer->dropped.exchange(0, memory_order_relaxed);
+    }
+
+    {
+        // buffers of ended threads are only referenced by the registry and the copy above
+        lock_guard<mutex> lock(buffersMutex);
+        buffers.erase(remove_if(buffers.begin(), buffers.end(), [](const shared_ptr<Buffer>& buffer) {
+            return buffer.use_count() == 2 && buffer->head.load() == buffer->tail.load();
+        }), buffers.end());
+    }
+
+    if (entries.empty() && dropped == 0) return;
+    stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.time < b.time;
+    });
+
+    ostream& os = *output;
+    for (auto& entry : entries) {
+        time_t seconds = chrono::system_clock::to_time_t(entry.time);
+        auto milliseconds = chrono::duration_cast<chrono::milliseconds>(entry.time.time_since_epoch()).count() % 1000;
+        tm local;
+        localtime_r(&seconds, &local);
+        char timestamp[32];
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &local);
+        os << timestamp << '.' << setfill('0') << setw(3) << milliseconds << setfill(' ') << ' '
+           << left << setw(5) << getLevelName(entry.level) << right << ' '
+           << entry.module->getName() << ": " << entry.text << '\n';
+    }
+    if (dropped > 0)
+        os << "Logger dropped " << dropped << " records, the writer could not keep up" << '\n';
+    os.flush();
+}
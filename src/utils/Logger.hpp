@@ -0,0 +1,176 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/// Severity of a log record, ordered from verbose to severe
+enum class LogLevel {
+    Trace,
+    Debug,
+    Info,
+    Warning,
+    Error,
+    /// Disables a module
+    Off
+};
+
+/// Records below this level are removed by the compiler, set with -DHARPOON_LOG_MIN_LEVEL=<0..5>
+#ifndef HARPOON_LOG_MIN_LEVEL
+#define HARPOON_LOG_MIN_LEVEL 0
+#endif
+
+/// Named source of log records with its own runtime level
+class LogModule {
+    std::string name;
+    std::atomic<int> level;
+    /// False if the level follows the default level of the logger
+    bool overridden;
+    friend class Logger;
+public:
+    explicit LogModule(const std::string& name, LogLevel level);
+
+    const std::string& getName() const;
+    bool isEnabled(LogLevel level) const;
+};
+
+/// Key/value pair appended to a log record as key=value
+template<typename T>
+struct LogField {
+    const char* key;
+    const T& value;
+};
+
+/// Creates a structured field, e.g. LOG_INFO(module) << "join" << logField("channel", channel)
+template<typename T>
+LogField<T> logField(const char* key, const T& value) {
+    return LogField<T>{key, value};
+}
+
+/// Formats one record and hands it to the logger once the statement ends
+class LogRecord {
+    const LogModule& module;
+    LogLevel level;
+    std::ostringstream message;
+    std::string fields;
+
+    void appendField(const char* key, const std::string& value);
+public:
+    LogRecord(const LogModule& module, LogLevel level);
+    ~LogRecord();
+
+    template<typename T>
+    LogRecord& operator<<(const T& value) {
+        message << value;
+        return *this;
+    }
+    template<typename T>
+    LogRecord& operator<<(const LogField<T>& field) {
+        std::ostringstream value;
+        value << field.value;
+        appendField(field.key, value.str());
+        return *this;
+    }
+};
+
+/// Asynchronous logger shared by all threads.
+/// Every thread writes its records into an own lock-free ring buffer,
+/// a background writer drains all buffers in time order. Records of full buffers are
+/// dropped and counted instead of blocking the logging thread.
+/// Levels are read from the category "logging" of config/core.ini, "level" sets the default,
+/// every other key the level of the module with that name.
+class Logger {
+public:
+    /// Records a thread may queue until the writer catches up
+    static const size_t bufferCapacity = 1024;
+private:
+    struct Entry {
+        std::chrono::system_clock::time_point time;
+        LogLevel level;
+        const LogModule* module;
+        std::string text;
+    };
+    /// Single producer, single consumer ring of one thread
+    struct Buffer {
+        Buffer();
+        Entry entries[bufferCapacity];
+        /// Written by the owning thread
+        std::atomic<size_t> head;
+        /// Written by the writer
+        std::atomic<size_t> tail;
+        std::atomic<size_t> dropped;
+    };
+
+    std::mutex modulesMutex;
+    std::map<std::string, std::unique_ptr<LogModule>> modules;
+    std::atomic<int> defaultLevel;
+
+    std::mutex buffersMutex;
+    std::vector<std::shared_ptr<Buffer>> buffers;
+
+    /// Held while draining, the writer and flush are the only consumers
+    std::mutex writerMutex;
+    std::condition_variable writerCondition;
+    bool stopping;
+    std::ostream* output;
+    std::thread writer;
+
+    Logger();
+    Buffer& getBuffer();
+    void writeLoop();
+    /// Writes the queued records of all threads, requires the writer lock
+    void drain();
+public:
+    ~Logger();
+
+    /// Returns the logger shared by all threads
+    static Logger& getInstance();
+    /// Parses a level name like "debug"
+    ///
+    /// \returns False if the name is unknown
+    static bool parseLevel(const std::string& name, LogLevel& level);
+    static const char* getLevelName(LogLevel level);
+
+    /// Returns the module with the given name, created on first use and valid until the process ends
+    LogModule& getModule(const std::string& name);
+    /// Sets the level of all modules without an own level
+    void setDefaultLevel(LogLevel level);
+    /// Sets the level of one module
+    void setLevel(const std::string& module, LogLevel level);
+
+    /// Queues a record of the calling thread
+    void submit(const LogModule& module, LogLevel level, std::string&& text);
+    /// Blocks until all records queued before the call were written
+    void flush();
+    /// Replaces the stream records are written to, stdout by default
+    void setOutput(std::ostream& output);
+};
+
+/// Turns a streamed record into void, lets the macros below be a single expression
+struct LogVoidify {
+    void operator&(LogRecord&) {}
+};
+
+/// Writes a record if the level is compiled in and enabled for the module,
+/// the streamed values are not evaluated otherwise
+#define HARPOON_LOG(module, level) \
+    (static_cast<int>(level) < HARPOON_LOG_MIN_LEVEL || !(module).isEnabled(level)) \
+        ? (void)0 : LogVoidify() & LogRecord((module), (level))
+
+#define LOG_TRACE(module) HARPOON_LOG(module, LogLevel::Trace)
+#define LOG_DEBUG(module) HARPOON_LOG(module, LogLevel::Debug)
+#define LOG_INFO(module) HARPOON_LOG(module, LogLevel::Info)
+#define LOG_WARNING(module) HARPOON_LOG(module, LogLevel::Warning)
+#define LOG_ERROR(module) HARPOON_LOG(module, LogLevel::Error)
+
+#endif
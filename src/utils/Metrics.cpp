@@ -0,0 +1,210 @@
+#include "Metrics.hpp"
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+
+MetricsCounter::MetricsCounter()
+    : value{0}
+{
+}
+
+void MetricsCounter::increment(uint64_t amount) {
+    value.fetch_add(amount, memory_order_relaxed);
+}
+
+uint64_t MetricsCounter::get() const {
+    return value.load(memory_order_relaxed);
+}
+
+MetricsGauge::MetricsGauge()
+    : value{0}
+{
+}
+
+void MetricsGauge::set(int64_t lvalue) {
+    value.store(lvalue, memory_order_relaxed);
+}
+
+void MetricsGauge::add(int64_t amount) {
+    value.fetch_add(amount, memory_order_relaxed);
+}
+
+int64_t MetricsGauge::get() const {
+    return value.load(memory_order_relaxed);
+}
+
+MetricsHistogram::MetricsHistogram()
+    : bounds{100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000}
+    , buckets{new atomic<uint64_t>[bounds.size() + 1]}
+    , count{0}
+    , sum{0}
+{
+    for (size_t i = 0; i <= bounds.size(); ++i)
+        buckets[i] = 0;
+}
+
+void MetricsHistogram::observe(std::chrono::steady_clock::duration duration) {
+    auto microseconds = chrono::duration_cast<chrono::microseconds>(duration).count();
+    uint64_t value = microseconds < 0 ? 0 : static_cast<uint64_t>(microseconds);
+
+    size_t bucket = 0;
+    while (bucket < bounds.size() && value > bounds[bucket])
+        ++bucket;
+    buckets[bucket].fetch_add(1, memory_order_relaxed);
+    count.fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(value, memory_order_relaxed);
+}
+
+const std::vector<uint64_t>& MetricsHistogram::getBounds() const {
+    return bounds;
+}
+
+std::vector<uint64_t> MetricsHistogram::getCumulativeCounts() const {
+    vector<uint64_t> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i <= bounds.size(); ++i) {
+        total += buckets[i].load(memory_order_relaxed);
+        counts.push_back(total);
+    }
+    return counts;
+}
+
+uint64_t MetricsHistogram::getCount() const {
+    return count.load(memory_order_relaxed);
+}
+
+uint64_t MetricsHistogram::getSum() const {
+    return sum.load(memory_order_relaxed);
+}
+
+void MetricsRegistry::Collection::add(const std::string& name, const Labels& labels, double value) {
+    samples[name][formatLabels(labels)] += value;
+}
+
+MetricsRegistry::MetricsRegistry()
+    : lastCollectorId{0}
+{
+}
+
+MetricsRegistry& MetricsRegistry::getInstance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Family& MetricsRegistry::getFamily(const std::string& name, const std::string& help, const std::string& type) {
+    Family& family = families[name];
+    if (family.type.empty()) {
+        family.help = help;
+        family.type = type;
+    }
+    return family;
+}
+
+std::string MetricsRegistry::formatLabels(const Labels& labels) {
+    if (labels.empty()) return "";
+    string formatted = "{";
+    for (auto& label : labels) {
+        if (formatted.size() > 1)
+            formatted += ',';
+        formatted += label.first + "=\"";
+        for (char c : label.second) {
+            switch (c) {
+            case '\\': formatted += "\\\\"; break;
+            case '"': formatted += "\\\""; break;
+            case '\n': formatted += "\\n"; break;
+            default: formatted += c;
+            }
+        }
+        formatted += '"';
+    }
+    return formatted + "}";
+}
+
+MetricsCounter& MetricsRegistry::getCounter(const std::string& name, const std::string& help, const Labels& labels) {
+    lock_guard<mutex> lock(registryMutex);
+    auto& counter = getFamily(name, help, "counter").counters[formatLabels(labels)];
+    if (!counter)
+        counter.reset(new MetricsCounter);
+    return *counter;
+}
+
+MetricsGauge& MetricsRegistry::getGauge(const std::string& name, const std::string& help, const Labels& labels) {
+    lock_guard<mutex> lock(registryMutex);
+    auto& gauge = getFamily(name, help, "gauge").gauges[formatLabels(labels)];
+    if (!gauge)
+        gauge.reset(new MetricsGauge);
+    return *gauge;
+}
+
+MetricsHistogram& MetricsRegistry::getHistogram(const std::string& name, const std::string& help, const Labels& labels) {
+    lock_guard<mutex> lock(registryMutex);
+    auto& histogram = getFamily(name, help, "histogram").histograms[formatLabels(labels)];
+    if (!histogram)
+        histogram.reset(new MetricsHistogram);
+    return *histogram;
+}
+
+void MetricsRegistry::describe(const std::string& name, const std::string& help, const std::string& type) {
+    lock_guard<mutex> lock(registryMutex);
+    getFamily(name, help, type);
+}
+
+size_t MetricsRegistry::addCollector(Collector collector) {
+    lock_guard<mutex> lock(registryMutex);
+    size_t collectorId = ++lastCollectorId;
+    collectors.emplace(collectorId, move(collector));
+    return collectorId;
+}
+
+void MetricsRegistry::removeCollector(size_t collectorId) {
+    lock_guard<mutex> lock(registryMutex);
+    collectors.erase(collectorId);
+}
+
+/// Appends labels to already rendered labels
+static std::string appendLabel(const std::string& labels, const std::string& label) {
+    if (labels.empty()) return "{" + label + "}";
+    return labels.substr(0, labels.size() - 1) + "," + label + "}";
+}
+
+std::string MetricsRegistry::render() {
+    lock_guard<mutex> lock(registryMutex);
+    Collection collection;
+    for (auto& collector : collectors)
+        collector.second(collection);
+
+    ostringstream os;
+    // large counters would lose digits with the default precision of 6
+    os << setprecision(17);
+    for (auto& familyIt : families) {
+        const string& name = familyIt.first;
+        Family& family = familyIt.second;
+        os << "# HELP " << name << " " << family.help << "\n";
+        os << "# TYPE " << name << " " << family.type << "\n";
+
+        for (auto& counter : family.counters)
+            os << name << counter.first << " " << counter.second->get() << "\n";
+        for (auto& gauge : family.gauges)
+            os << name << gauge.first << " " << gauge.second->get() << "\n";
+        for (auto& histogram : family.histograms) {
+            auto& bounds = histogram.second->getBounds();
+            auto counts = histogram.second->getCumulativeCounts();
+            for (size_t i = 0; i < bounds.size(); ++i) {
+                os << name << "_bucket" << appendLabel(histogram.first, "le=\"" + to_string(bounds[i] / 1e6) + "\"")
+                   << " " << counts[i] << "\n";
+            }
+            os << name << "_bucket" << appendLabel(histogram.first, "le=\"+Inf\"") << " " << counts.back() << "\n";
+            os << name << "_sum" << histogram.first << " " << histogram.second->getSum() / 1e6 << "\n";
+            os << name << "_count" << histogram.first << " " << histogram.second->getCount() << "\n";
+        }
+
+        auto samplesIt = collection.samples.find(name);
+        if (samplesIt != collection.samples.end()) {
+            for (auto& sample : samplesIt->second)
+                os << name << sample.first << " " << sample.second << "\n";
+        }
+    }
+    return os.str();
+}
@@ -0,0 +1,113 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/// Monotonically increasing value, updated without locking
+class MetricsCounter {
+    std::atomic<uint64_t> value;
+public:
+    MetricsCounter();
+    void increment(uint64_t amount = 1);
+    uint64_t get() const;
+};
+
+/// Value which can go up and down, updated without locking
+class MetricsGauge {
+    std::atomic<int64_t> value;
+public:
+    MetricsGauge();
+    void set(int64_t value);
+    void add(int64_t amount);
+    int64_t get() const;
+};
+
+/// Latency histogram with fixed buckets, updated without locking
+class MetricsHistogram {
+    /// Upper bounds of the buckets in microseconds
+    std::vector<uint64_t> bounds;
+    /// One more than bounds for the +Inf bucket, not cumulative
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+public:
+    /// Uses buckets from 100us to 10s
+    MetricsHistogram();
+
+    void observe(std::chrono::steady_clock::duration duration);
+    const std::vector<uint64_t>& getBounds() const;
+    /// Cumulative counts per bound followed by the total count
+    std::vector<uint64_t> getCumulativeCounts() const;
+    uint64_t getCount() const;
+    /// Summed up observations in microseconds
+    uint64_t getSum() const;
+};
+
+/// Registry of all runtime metrics, rendered in the Prometheus text format.
+/// Metrics are created on first use and live until the process ends,
+/// callers keep the returned references to update them without lookups.
+class MetricsRegistry {
+public:
+    using Labels = std::map<std::string, std::string>;
+
+    /// Receives values computed while rendering, values of equal series are summed up
+    class Collection {
+        /// Samples by metric name and rendered labels
+        std::map<std::string, std::map<std::string, double>> samples;
+        friend MetricsRegistry;
+    public:
+        void add(const std::string& name, const Labels& labels, double value);
+    };
+    using Collector = std::function<void(Collection&)>;
+private:
+    struct Family {
+        std::string help;
+        std::string type;
+        std::map<std::string, std::unique_ptr<MetricsCounter>> counters;
+        std::map<std::string, std::unique_ptr<MetricsGauge>> gauges;
+        std::map<std::string, std::unique_ptr<MetricsHistogram>> histograms;
+    };
+
+    std::mutex registryMutex;
+    std::map<std::string, Family> families;
+    std::map<size_t, Collector> collectors;
+    size_t lastCollectorId;
+
+    MetricsRegistry();
+    /// Returns the family and sets help and type on first use, requires the lock
+    Family& getFamily(const std::string& name, const std::string& help, const std::string& type);
+    /// Renders labels as {name="value",...}
+    static std::string formatLabels(const Labels& labels);
+public:
+    /// Returns the registry shared by all modules
+    static MetricsRegistry& getInstance();
+
+    MetricsCounter& getCounter(const std::string& name, const std::string& help, const Labels& labels = {});
+    MetricsGauge& getGauge(const std::string& name, const std::string& help, const Labels& labels = {});
+    MetricsHistogram& getHistogram(const std::string& name, const std::string& help, const Labels& labels = {});
+
+    /// Declares a metric whose values are provided by a collector
+    ///
+    /// \param type Prometheus type, "counter" or "gauge"
+    void describe(const std::string& name, const std::string& help, const std::string& type);
+    /// Adds a callback which is called on every rendering
+    ///
+    /// \returns Id to remove the collector
+    size_t addCollector(Collector collector);
+    /// Removes a collector, it isn't running anymore once this returns
+    void removeCollector(size_t collectorId);
+
+    /// Renders all metrics in the Prometheus text exposition format
+    std::string render();
+};
+
+#endif
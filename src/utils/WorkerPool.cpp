@@ -0,0 +1,64 @@
+#include "WorkerPool.hpp"
+#include <algorithm>
+
+using namespace std;
+
+
+WorkerPool::WorkerPool(size_t threadCount, size_t capacity)
+    : capacity{capacity}
+    , stopping{false}
+{
+    threadCount = max<size_t>(threadCount, 1);
+    for (size_t i = 0; i < threadCount; ++i)
+        threads.emplace_back([this]{ run(); });
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+bool WorkerPool::post(std::function<void()> job) {
+    {
+        lock_guard<mutex> lock(jobsMutex);
+        if (stopping || jobs.size() >= capacity)
+            return false;
+        jobs.push_back(std::move(job));
+    }
+    jobsCondition.notify_one();
+    return true;
+}
+
+size_t WorkerPool::getPending() {
+    lock_guard<mutex> lock(jobsMutex);
+    return jobs.size();
+}
+
+void WorkerPool::stop() {
+    {
+        lock_guard<mutex> lock(jobsMutex);
+        if (stopping) return;
+        stopping = true;
+        jobs.clear();
+    }
+    jobsCondition.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+size_t WorkerPool::defaultThreads() {
+    return max<size_t>(thread::hardware_concurrency() / 2, 1);
+}
+
+void WorkerPool::run() {
+    for (;;) {
+        function<void()> job;
+        {
+            unique_lock<mutex> lock(jobsMutex);
+            jobsCondition.wait(lock, [this]{ return stopping || !jobs.empty(); });
+            if (stopping) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/// Fixed amount of threads running jobs which are too expensive for an event loop.
+/// Jobs wait in a bounded queue, post fails once it is full.
+class WorkerPool {
+    std::mutex jobsMutex;
+    std::condition_variable jobsCondition;
+    std::deque<std::function<void()>> jobs;
+    size_t capacity;
+    bool stopping;
+    std::vector<std::thread> threads;
+
+    void run();
+public:
+    /// \param threads Amount of worker threads, at least one is started
+    /// \param capacity Maximum amount of waiting jobs
+    WorkerPool(size_t threads, size_t capacity);
+    ~WorkerPool();
+
+    /// Queues a job, returns false if the pool is full or stopped
+    bool post(std::function<void()> job);
+    /// Returns the amount of waiting jobs
+    size_t getPending();
+    /// Discards the waiting jobs and joins the threads after their current job
+    void stop();
+
+    /// Half of the hardware threads, at least one
+    static size_t defaultThreads();
+};
+
+#endif